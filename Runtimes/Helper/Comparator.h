@@ -22,6 +22,17 @@ struct FIVec3Comparator
 	}
 };
 
+struct FIVec4Comparator
+{
+	bool operator()(const glm::ivec4& A, const glm::ivec4& B) const
+	{
+		if (A.x != B.x) return A.x < B.x;
+		if (A.y != B.y) return A.y < B.y;
+		if (A.z != B.z) return A.z < B.z;
+		return A.w < B.w;
+	}
+};
+
 struct FBlockComparator
 {
 	bool operator()(const FBlock& A, const FBlock& B) const
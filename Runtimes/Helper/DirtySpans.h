@@ -0,0 +1,88 @@
+// Meso Engine 2024
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+struct FIndexSpan
+{
+    uint32_t Begin = 0;
+    uint32_t End = 0;//Exclusive
+};
+
+/*
+Modified index ranges of a buffer waiting for an upload. Consecutive marks extend the last span, so a pushed chunk's blocks stay one span.
+Coalesce sorts and merges the spans closer than a gap, sending a few untouched elements costs less than another upload.
+*/
+class FDirtySpans
+{
+public:
+    //Past this the spans are coalesced on the way, so a buffer nobody uploads doesn't grow them forever
+    static constexpr size_t MaxSpanNum = 4096;
+
+    //Room for the most spans there can be, marking never allocates after it
+    void Reserve()
+    {
+        Spans.reserve(MaxSpanNum + 1);
+    }
+    void Add(uint32_t Index)
+    {
+        AddRange(Index, Index + 1);
+    }
+    void AddRange(uint32_t Begin, uint32_t End)
+    {
+        if (Begin >= End)
+        {
+            return;
+        }
+        if (!Spans.empty() && Begin >= Spans.back().Begin && Begin <= Spans.back().End)
+        {
+            Spans.back().End = std::max(Spans.back().End, End);
+            return;
+        }
+        Spans.push_back({ Begin, End });
+        if (Spans.size() > MaxSpanNum)
+        {
+            //Wider gaps until half is left, scattered marks would otherwise sort at every mark past the cap
+            for (uint32_t MaxGap = 0; Spans.size() > MaxSpanNum / 2; MaxGap = MaxGap * 2 + 1)
+            {
+                Coalesce(MaxGap);
+            }
+        }
+    }
+    void Coalesce(uint32_t MaxGap)
+    {
+        if (Spans.size() < 2)
+        {
+            return;
+        }
+        std::sort(Spans.begin(), Spans.end(), [](const FIndexSpan& A, const FIndexSpan& B) { return A.Begin < B.Begin; });
+        size_t Last = 0;
+        for (size_t i = 1; i < Spans.size(); i++)
+        {
+            if ((uint64_t)Spans[i].Begin <= (uint64_t)Spans[Last].End + MaxGap)
+            {
+                Spans[Last].End = std::max(Spans[Last].End, Spans[i].End);
+            }
+            else
+            {
+                Spans[++Last] = Spans[i];
+            }
+        }
+        Spans.resize(Last + 1);
+    }
+    const std::vector<FIndexSpan>& GetSpans() const
+    {
+        return Spans;
+    }
+    bool bEmpty() const
+    {
+        return Spans.empty();
+    }
+    void Clear()
+    {
+        Spans.clear();
+    }
+private:
+    std::vector<FIndexSpan> Spans;
+};
@@ -0,0 +1,389 @@
+// Meso Engine 2024
+#pragma once
+#include "GeneratorHelper.h"
+
+/*
+Compile-time generator graph. Nodes are plain structs composed as template arguments, the whole graph inlines into one kernel:
+    TGraphAdd{ FGraphPlane{}, TGraphScale{ TGraphFbm<TGraphDomainScale<TGraphNoise<>>, 4>{ ... }, -16.0 } }
+Every node is a signed field (solid where < 0) with
+    T Evaluate(tvec3<T> p)                                   scalar
+    void EvaluateLanes(TVec3Lanes<T, LaneNum> p, T* Result)  LaneNum samples at once, same operation order as Evaluate
+Run it with FGeneratorGraph::GenerateOccupancy / Generate, or hand FGeneratorGraph::MakeOccupancyGenerator to FChunkManage.
+*/
+
+// p.y - Height, ground below
+struct FGraphPlane
+{
+    double Height = 0.0;
+
+    template<typename T>
+    MESO_FORCEINLINE T Evaluate(const glm::tvec3<T, glm::defaultp>& p) const
+    {
+        return p.y - static_cast<T>(Height);
+    }
+    template<typename T, uint32_t LaneNum>
+    MESO_FORCEINLINE void EvaluateLanes(const TVec3Lanes<T, LaneNum>& p, T* Result) const
+    {
+        for (uint32_t i = 0; i < LaneNum; i++)
+        {
+            Result[i] = p.Y[i] - static_cast<T>(Height);
+        }
+    }
+};
+
+struct FGraphSphere
+{
+    dvec3 Center = { 0.0, 0.0, 0.0 };
+    double Radius = 1.0;
+
+    template<typename T>
+    MESO_FORCEINLINE T Evaluate(const glm::tvec3<T, glm::defaultp>& p) const
+    {
+        return length(p - glm::tvec3<T, glm::defaultp>(Center)) - static_cast<T>(Radius);
+    }
+    template<typename T, uint32_t LaneNum>
+    MESO_FORCEINLINE void EvaluateLanes(const TVec3Lanes<T, LaneNum>& p, T* Result) const
+    {
+        for (uint32_t i = 0; i < LaneNum; i++)
+        {
+            const T dx = p.X[i] - static_cast<T>(Center.x);
+            const T dy = p.Y[i] - static_cast<T>(Center.y);
+            const T dz = p.Z[i] - static_cast<T>(Center.z);
+            Result[i] = std::sqrt(dx * dx + dy * dy + dz * dz) - static_cast<T>(Radius);
+        }
+    }
+};
+
+// Gradient noise value in [-1, 1)
+template<ENoiseHashMode HashMode = FGeneratorHelper::GeneratorHashMode>
+struct TGraphNoise
+{
+    template<typename T>
+    MESO_FORCEINLINE T Evaluate(const glm::tvec3<T, glm::defaultp>& p) const
+    {
+        return FGeneratorHelper::noised<T, HashMode>(p).w;
+    }
+    template<typename T, uint32_t LaneNum>
+    MESO_FORCEINLINE void EvaluateLanes(const TVec3Lanes<T, LaneNum>& p, T* Result) const
+    {
+        TVec4Lanes<T, LaneNum> rnd;
+        FGeneratorHelper::noisedLanes<T, LaneNum, HashMode>(p, rnd);
+        for (uint32_t i = 0; i < LaneNum; i++)
+        {
+            Result[i] = rnd.W[i];
+        }
+    }
+};
+
+// The domain warped fbm of TestGenerator
+template<ENoiseHashMode HashMode = FGeneratorHelper::GeneratorHashMode>
+struct TGraphDisplacement
+{
+    template<typename T>
+    MESO_FORCEINLINE T Evaluate(const glm::tvec3<T, glm::defaultp>& p) const
+    {
+        return FGeneratorHelper::displacement<T, HashMode>(p);
+    }
+    template<typename T, uint32_t LaneNum>
+    MESO_FORCEINLINE void EvaluateLanes(const TVec3Lanes<T, LaneNum>& p, T* Result) const
+    {
+        FGeneratorHelper::displacementLanes<T, LaneNum, HashMode>(p, Result);
+    }
+};
+
+// Node(p * Scale), per axis so a heightfield can drop y
+template<typename TNode>
+struct TGraphDomainScale
+{
+    TNode Node;
+    dvec3 Scale = { 1.0, 1.0, 1.0 };
+
+    template<typename T>
+    MESO_FORCEINLINE T Evaluate(const glm::tvec3<T, glm::defaultp>& p) const
+    {
+        return Node.Evaluate(p * glm::tvec3<T, glm::defaultp>(Scale));
+    }
+    template<typename T, uint32_t LaneNum>
+    MESO_FORCEINLINE void EvaluateLanes(const TVec3Lanes<T, LaneNum>& p, T* Result) const
+    {
+        TVec3Lanes<T, LaneNum> Scaled;
+        for (uint32_t i = 0; i < LaneNum; i++)
+        {
+            Scaled.X[i] = p.X[i] * static_cast<T>(Scale.x);
+            Scaled.Y[i] = p.Y[i] * static_cast<T>(Scale.y);
+            Scaled.Z[i] = p.Z[i] * static_cast<T>(Scale.z);
+        }
+        Node.EvaluateLanes(Scaled, Result);
+    }
+};
+
+// Node(p + Strength * (Warp(p), Warp(p + OffsetY), Warp(p + OffsetZ)))
+template<typename TNode, typename TWarp>
+struct TGraphDomainWarp
+{
+    TNode Node;
+    TWarp Warp;
+    double Strength = 1.0;
+    dvec3 OffsetY = { 5.2, 1.3, 2.8 };//Decorrelates the three warp axes
+    dvec3 OffsetZ = { 1.7, 9.2, 3.1 };
+
+    template<typename T>
+    MESO_FORCEINLINE T Evaluate(const glm::tvec3<T, glm::defaultp>& p) const
+    {
+        const glm::tvec3<T, glm::defaultp> Offset = {
+            Warp.Evaluate(p),
+            Warp.Evaluate(p + glm::tvec3<T, glm::defaultp>(OffsetY)),
+            Warp.Evaluate(p + glm::tvec3<T, glm::defaultp>(OffsetZ)) };
+        return Node.Evaluate(p + Offset * static_cast<T>(Strength));
+    }
+    template<typename T, uint32_t LaneNum>
+    MESO_FORCEINLINE void EvaluateLanes(const TVec3Lanes<T, LaneNum>& p, T* Result) const
+    {
+        alignas(64) T WarpX[LaneNum], WarpY[LaneNum], WarpZ[LaneNum];
+        TVec3Lanes<T, LaneNum> Shifted;
+        Warp.EvaluateLanes(p, WarpX);
+        for (uint32_t i = 0; i < LaneNum; i++)
+        {
+            Shifted.X[i] = p.X[i] + static_cast<T>(OffsetY.x);
+            Shifted.Y[i] = p.Y[i] + static_cast<T>(OffsetY.y);
+            Shifted.Z[i] = p.Z[i] + static_cast<T>(OffsetY.z);
+        }
+        Warp.EvaluateLanes(Shifted, WarpY);
+        for (uint32_t i = 0; i < LaneNum; i++)
+        {
+            Shifted.X[i] = p.X[i] + static_cast<T>(OffsetZ.x);
+            Shifted.Y[i] = p.Y[i] + static_cast<T>(OffsetZ.y);
+            Shifted.Z[i] = p.Z[i] + static_cast<T>(OffsetZ.z);
+        }
+        Warp.EvaluateLanes(Shifted, WarpZ);
+        for (uint32_t i = 0; i < LaneNum; i++)
+        {
+            Shifted.X[i] = p.X[i] + WarpX[i] * static_cast<T>(Strength);
+            Shifted.Y[i] = p.Y[i] + WarpY[i] * static_cast<T>(Strength);
+            Shifted.Z[i] = p.Z[i] + WarpZ[i] * static_cast<T>(Strength);
+        }
+        Node.EvaluateLanes(Shifted, Result);
+    }
+};
+
+// Sum of Node(p * 2^k) * 0.5^(k + 1), the octave count is unrolled
+template<typename TNode, int OctaveNum>
+struct TGraphFbm
+{
+    TNode Node;
+
+    template<typename T>
+    MESO_FORCEINLINE T Evaluate(const glm::tvec3<T, glm::defaultp>& p) const
+    {
+        glm::tvec3<T, glm::defaultp> q = p;
+        T Sum = static_cast<T>(0.0);
+        T mgn = static_cast<T>(0.5);
+        for (int k = 0; k < OctaveNum; k++)
+        {
+            Sum += Node.Evaluate(q) * mgn;
+            q *= static_cast<T>(2.0);
+            mgn *= static_cast<T>(0.5);
+        }
+        return Sum;
+    }
+    template<typename T, uint32_t LaneNum>
+    MESO_FORCEINLINE void EvaluateLanes(const TVec3Lanes<T, LaneNum>& p, T* Result) const
+    {
+        TVec3Lanes<T, LaneNum> q = p;
+        alignas(64) T Octave[LaneNum];
+        T mgn = static_cast<T>(0.5);
+        for (uint32_t i = 0; i < LaneNum; i++)
+        {
+            Result[i] = static_cast<T>(0.0);
+        }
+        for (int k = 0; k < OctaveNum; k++)
+        {
+            Node.EvaluateLanes(q, Octave);
+            for (uint32_t i = 0; i < LaneNum; i++)
+            {
+                Result[i] += Octave[i] * mgn;
+                q.X[i] *= static_cast<T>(2.0);
+                q.Y[i] *= static_cast<T>(2.0);
+                q.Z[i] *= static_cast<T>(2.0);
+            }
+            mgn *= static_cast<T>(0.5);
+        }
+    }
+};
+
+// Node * Factor
+template<typename TNode>
+struct TGraphScale
+{
+    TNode Node;
+    double Factor = 1.0;
+
+    template<typename T>
+    MESO_FORCEINLINE T Evaluate(const glm::tvec3<T, glm::defaultp>& p) const
+    {
+        return Node.Evaluate(p) * static_cast<T>(Factor);
+    }
+    template<typename T, uint32_t LaneNum>
+    MESO_FORCEINLINE void EvaluateLanes(const TVec3Lanes<T, LaneNum>& p, T* Result) const
+    {
+        Node.EvaluateLanes(p, Result);
+        for (uint32_t i = 0; i < LaneNum; i++)
+        {
+            Result[i] *= static_cast<T>(Factor);
+        }
+    }
+};
+
+// Node - Iso, moves the surface to the Iso level set
+template<typename TNode>
+struct TGraphThreshold
+{
+    TNode Node;
+    double Iso = 0.0;
+
+    template<typename T>
+    MESO_FORCEINLINE T Evaluate(const glm::tvec3<T, glm::defaultp>& p) const
+    {
+        return Node.Evaluate(p) - static_cast<T>(Iso);
+    }
+    template<typename T, uint32_t LaneNum>
+    MESO_FORCEINLINE void EvaluateLanes(const TVec3Lanes<T, LaneNum>& p, T* Result) const
+    {
+        Node.EvaluateLanes(p, Result);
+        for (uint32_t i = 0; i < LaneNum; i++)
+        {
+            Result[i] -= static_cast<T>(Iso);
+        }
+    }
+};
+
+// Binary nodes share the lane plumbing, FOp is the per sample combine
+template<typename TA, typename TB, typename FOp>
+struct TGraphBinary
+{
+    TA A;
+    TB B;
+
+    template<typename T>
+    MESO_FORCEINLINE T Evaluate(const glm::tvec3<T, glm::defaultp>& p) const
+    {
+        return FOp::Combine(A.Evaluate(p), B.Evaluate(p));
+    }
+    template<typename T, uint32_t LaneNum>
+    MESO_FORCEINLINE void EvaluateLanes(const TVec3Lanes<T, LaneNum>& p, T* Result) const
+    {
+        alignas(64) T Other[LaneNum];
+        A.EvaluateLanes(p, Result);
+        B.EvaluateLanes(p, Other);
+        for (uint32_t i = 0; i < LaneNum; i++)
+        {
+            Result[i] = FOp::Combine(Result[i], Other[i]);
+        }
+    }
+};
+struct FGraphAddOp
+{
+    template<typename T> MESO_FORCEINLINE static T Combine(T a, T b) { return a + b; }
+};
+struct FGraphUnionOp
+{
+    template<typename T> MESO_FORCEINLINE static T Combine(T a, T b) { return std::min(a, b); }
+};
+struct FGraphIntersectOp
+{
+    template<typename T> MESO_FORCEINLINE static T Combine(T a, T b) { return std::max(a, b); }
+};
+struct FGraphSubtractOp
+{
+    template<typename T> MESO_FORCEINLINE static T Combine(T a, T b) { return std::max(a, -b); }
+};
+// Aggregate templates instead of aliases so TGraphAdd{ A, B } deduces its arguments
+template<typename TA, typename TB> struct TGraphAdd : TGraphBinary<TA, TB, FGraphAddOp> {};
+template<typename TA, typename TB> struct TGraphUnion : TGraphBinary<TA, TB, FGraphUnionOp> {};
+template<typename TA, typename TB> struct TGraphIntersect : TGraphBinary<TA, TB, FGraphIntersectOp> {};
+template<typename TA, typename TB> struct TGraphSubtract : TGraphBinary<TA, TB, FGraphSubtractOp> {};//A minus B
+template<typename TA, typename TB> TGraphAdd(TA, TB) -> TGraphAdd<TA, TB>;
+template<typename TA, typename TB> TGraphUnion(TA, TB) -> TGraphUnion<TA, TB>;
+template<typename TA, typename TB> TGraphIntersect(TA, TB) -> TGraphIntersect<TA, TB>;
+template<typename TA, typename TB> TGraphSubtract(TA, TB) -> TGraphSubtract<TA, TB>;
+
+struct FGeneratorGraph
+{
+    // Occupancy generator body, same sample locations as the built-in generators, LaneNum voxels of a Z row per graph call
+    template<uint32_t LaneNum = kSimdLaneNum, typename TGraph>
+    inline static void GenerateOccupancy(const TGraph& Graph, FChunkOccupancyVolume& Occupancy, ivec3 StartLocation, float BlockSize, unsigned char ChunkResolution, uint32_t MipmapLevel)
+    {
+        const dvec3 ChunkStartLocation = (dvec3)StartLocation * (double)BlockSize * (double)ChunkResolution;
+        TVec3Lanes<double, LaneNum> Samples;
+        alignas(64) double Value[LaneNum];
+        for (uint32_t X = 0; X < ChunkResolution; X++)
+        {
+            for (uint32_t Y = 0; Y < ChunkResolution; Y++)
+            {
+                for (uint32_t ZStart = 0; ZStart < ChunkResolution; ZStart += LaneNum)
+                {
+                    for (uint32_t i = 0; i < LaneNum; i++)
+                    {
+                        const uint32_t Z = std::min(ZStart + i, (uint32_t)ChunkResolution - 1u);//Tail lanes repeat the last voxel
+                        const dvec3 BlockCenterLocation = ChunkStartLocation + dvec3{ X,Y,Z } *(double)BlockSize;
+                        Samples.X[i] = BlockCenterLocation.x;
+                        Samples.Y[i] = BlockCenterLocation.y;
+                        Samples.Z[i] = BlockCenterLocation.z;
+                    }
+                    Graph.EvaluateLanes(Samples, Value);
+                    for (uint32_t i = 0; i < LaneNum && ZStart + i < ChunkResolution; i++)
+                    {
+                        if (Value[i] < 0.0)
+                        {
+                            Occupancy.Set(true, { X, Y, ZStart + i });
+                        }
+                    }
+                }
+            }
+        }
+    }
+    template<uint32_t LaneNum = kSimdLaneNum, typename TGraph>
+    inline static FChunk Generate(const TGraph& Graph, ivec3 StartLocation, float BlockSize, unsigned char ChunkResolution, uint32_t MipmapLevel)
+    {
+        FChunk Result;
+        Result.ChunkLocation = StartLocation;
+        FChunkOccupancyVolume Occupancy;
+        GenerateOccupancy<LaneNum>(Graph, Occupancy, StartLocation, BlockSize, ChunkResolution, MipmapLevel);
+        Result.AddBlocksFromOccupancy(Occupancy);
+        return Result;
+    }
+    // For FChunkManage::SetOccupancyGenerator / SetGenerator, the std::function is called once per chunk, never per voxel
+    template<typename TGraph>
+    inline static auto MakeOccupancyGenerator(TGraph Graph)
+    {
+        return [Graph](FChunkOccupancyVolume& Occupancy, ivec3 StartLocation, float BlockSize, unsigned char ChunkResolution, uint32_t MipmapLevel)
+            {
+                GenerateOccupancy(Graph, Occupancy, StartLocation, BlockSize, ChunkResolution, MipmapLevel);
+            };
+    }
+    template<typename TGraph>
+    inline static auto MakeGenerator(TGraph Graph)
+    {
+        return [Graph](ivec3 StartLocation, float BlockSize, unsigned char ChunkResolution, uint32_t MipmapLevel)
+            {
+                return Generate(Graph, StartLocation, BlockSize, ChunkResolution, MipmapLevel);
+            };
+    }
+
+    // FGeneratorHelper::TestGenerator as a graph, (y * .5 + displacement(p * .1) * 10.3) * .4
+    template<ENoiseHashMode HashMode = FGeneratorHelper::GeneratorHashMode>
+    inline static auto MakeTestGeneratorGraph()
+    {
+        return TGraphScale{ TGraphAdd{
+            TGraphScale{ FGraphPlane{}, 0.5 },
+            TGraphScale{ TGraphDomainScale{ TGraphDisplacement<HashMode>{}, dvec3(0.1) }, 10.3 } }, 0.4 };
+    }
+    // FGeneratorHelper::FbmTerrainSdf as a graph, y - FbmTerrainAmplitude * fbm(x, z)
+    template<ENoiseHashMode HashMode = FGeneratorHelper::GeneratorHashMode>
+    inline static auto MakeFbmTerrainGraph()
+    {
+        using FHeightNoise = TGraphDomainScale<TGraphNoise<HashMode>>;
+        const FHeightNoise HeightNoise = { {}, dvec3(FGeneratorHelper::FbmTerrainFrequency, 0.0, FGeneratorHelper::FbmTerrainFrequency) };
+        return TGraphAdd{ FGraphPlane{}, TGraphScale{ TGraphFbm<FHeightNoise, FGeneratorHelper::FbmTerrainOctaveNum>{ HeightNoise }, -FGeneratorHelper::FbmTerrainAmplitude } };
+    }
+};
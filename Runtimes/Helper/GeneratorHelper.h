@@ -1,9 +1,11 @@
 // Meso Engine 2024
 #pragma once
+#include <type_traits>
 #include <glm/ext.hpp>
 #include <glm/glm.hpp>
 #include "VoxelMathHelper.h"
 #include "FileHelper.h"
+#include "SimdLanes.h"
 #include "Voxel/Chunk/Chunk.h"
 using glm::vec3;
 using glm::vec4;
@@ -13,10 +15,103 @@ using glm::ivec4;
 using glm::u8vec3;
 using glm::u8vec4;
 
+// Hashes of a box of lattice corners, filled once per chunk so samples falling in the same cell share them.
+// Corners outside the box are hashed on the fly, so results are identical with or without the table.
+template<typename T>
+struct TNoiseLatticeTable
+{
+    ivec3 Origin = ivec3(0);
+    ivec3 Size = ivec3(0);
+    std::vector<T> Values;
+
+    template<ENoiseHashMode HashMode>
+    inline static T HashCorner(int32_t X, int32_t Y, int32_t Z)
+    {
+        if constexpr (HashMode == ENoiseHashMode::Integer)
+        {
+            return FVoxelMathHelper::HashInteger<T>(X, Y, Z);
+        }
+        else
+        {
+            return FVoxelMathHelper::Hash(glm::tvec3<T, glm::defaultp>(X, Y, Z));
+        }
+    }
+
+    template<ENoiseHashMode HashMode>
+    void Fill(ivec3 InOrigin, ivec3 InSize)
+    {
+        Origin = InOrigin;
+        Size = InSize;
+        Values.resize((size_t)Size.x * Size.y * Size.z);
+        size_t Index = 0;
+        for (int32_t Z = 0; Z < Size.z; Z++)
+        {
+            for (int32_t Y = 0; Y < Size.y; Y++)
+            {
+                for (int32_t X = 0; X < Size.x; X++)
+                {
+                    Values[Index++] = HashCorner<HashMode>(Origin.x + X, Origin.y + Y, Origin.z + Z);
+                }
+            }
+        }
+    }
+
+    template<ENoiseHashMode HashMode>
+    inline T Get(int32_t X, int32_t Y, int32_t Z) const
+    {
+        const uint32_t LocalX = (uint32_t)(X - Origin.x);
+        const uint32_t LocalY = (uint32_t)(Y - Origin.y);
+        const uint32_t LocalZ = (uint32_t)(Z - Origin.z);
+        if (LocalX < (uint32_t)Size.x && LocalY < (uint32_t)Size.y && LocalZ < (uint32_t)Size.z)
+        {
+            return Values[LocalX + (size_t)Size.x * (LocalY + (size_t)Size.y * LocalZ)];
+        }
+        return HashCorner<HashMode>(X, Y, Z);
+    }
+
+    // No fallback, for callers that know the corner is inside (clamped to stay in memory otherwise). Lets the lane loop vectorize into gathers
+    inline T GetInside(int32_t X, int32_t Y, int32_t Z) const
+    {
+        const int32_t LocalX = std::clamp(X - Origin.x, 0, Size.x - 1);
+        const int32_t LocalY = std::clamp(Y - Origin.y, 0, Size.y - 1);
+        const int32_t LocalZ = std::clamp(Z - Origin.z, 0, Size.z - 1);
+        return Values[LocalX + Size.x * (LocalY + Size.y * LocalZ)];//32 bit index math (tables stay far below 2^31), 64 bit would halve the float gathers
+    }
+};
+
+// One lattice table per displacement octave, octaves whose table would exceed the cell budget stay uncached.
+// Lattice cells per chunk grow 8x an octave, with 16^3 chunks only the 3 coarsest of the 9 fit the voxel count, the fine octaves keep hashing per sample
+// (a table as big as the chunk costs as many hashes to fill and misses L1 on lookup, the integer hash is only a few ops).
+// Measured: TestGeneratorBatched 1-9% faster with it, scalar TestGenerator within noise (2% slower to 6% faster), so only the batched generators use it by default
+template<typename T>
+struct TNoiseLatticeCache
+{
+    static constexpr uint32_t OctaveNum = 9;
+    TNoiseLatticeTable<T> Octaves[OctaveNum];
+
+    inline const TNoiseLatticeTable<T>* GetOctave(uint32_t Octave) const
+    {
+        return Octaves[Octave].Values.empty() ? nullptr : &Octaves[Octave];
+    }
+};
+
 struct FGeneratorHelper
 {
-    template<typename T>
-    inline static glm::tvec4<T, glm::defaultp> noised(glm::tvec3<T, glm::defaultp> x)
+    // Hash used by the built-in generators
+    inline static constexpr ENoiseHashMode GeneratorHashMode = ENoiseHashMode::Integer;
+
+    template<typename T, ENoiseHashMode HashMode>
+    inline static T HashLattice(const TNoiseLatticeTable<T>* LatticeTable, const glm::tvec3<T, glm::defaultp>& Lattice, int32_t OffsetX, int32_t OffsetY, int32_t OffsetZ)
+    {
+        if (LatticeTable)
+        {
+            return LatticeTable->template Get<HashMode>((int32_t)Lattice.x + OffsetX, (int32_t)Lattice.y + OffsetY, (int32_t)Lattice.z + OffsetZ);
+        }
+        return FVoxelMathHelper::HashLattice<T, HashMode>(Lattice, OffsetX, OffsetY, OffsetZ);
+    }
+
+    template<typename T, ENoiseHashMode HashMode = ENoiseHashMode::Sine>
+    inline static glm::tvec4<T, glm::defaultp> noised(glm::tvec3<T, glm::defaultp> x, const TNoiseLatticeTable<T>* LatticeTable = nullptr)
     {
         // https://iquilezles.org/articles/gradientnoise
         glm::tvec3<T, glm::defaultp> p = floor(x);
@@ -25,14 +120,14 @@ struct FGeneratorHelper
         glm::tvec3<T, glm::defaultp> u = w * w * w * (w * (w * static_cast<T>(6.0) - static_cast<T>(15.0)) + static_cast<T>(10.0));
         glm::tvec3<T, glm::defaultp> du = static_cast<T>(30.0) * w * w * (w * (w - static_cast<T>(2.0)) + static_cast<T>(1.0));
 
-        T a = FVoxelMathHelper::Hash(p + glm::tvec3<T, glm::defaultp>(0, 0, 0));
-        T b = FVoxelMathHelper::Hash(p + glm::tvec3<T, glm::defaultp>(1, 0, 0));
-        T c = FVoxelMathHelper::Hash(p + glm::tvec3<T, glm::defaultp>(0, 1, 0));
-        T d = FVoxelMathHelper::Hash(p + glm::tvec3<T, glm::defaultp>(1, 1, 0));
-        T e = FVoxelMathHelper::Hash(p + glm::tvec3<T, glm::defaultp>(0, 0, 1));
-        T f = FVoxelMathHelper::Hash(p + glm::tvec3<T, glm::defaultp>(1, 0, 1));
-        T g = FVoxelMathHelper::Hash(p + glm::tvec3<T, glm::defaultp>(0, 1, 1));
-        T h = FVoxelMathHelper::Hash(p + glm::tvec3<T, glm::defaultp>(1, 1, 1));
+        T a = HashLattice<T, HashMode>(LatticeTable, p, 0, 0, 0);
+        T b = HashLattice<T, HashMode>(LatticeTable, p, 1, 0, 0);
+        T c = HashLattice<T, HashMode>(LatticeTable, p, 0, 1, 0);
+        T d = HashLattice<T, HashMode>(LatticeTable, p, 1, 1, 0);
+        T e = HashLattice<T, HashMode>(LatticeTable, p, 0, 0, 1);
+        T f = HashLattice<T, HashMode>(LatticeTable, p, 1, 0, 1);
+        T g = HashLattice<T, HashMode>(LatticeTable, p, 0, 1, 1);
+        T h = HashLattice<T, HashMode>(LatticeTable, p, 1, 1, 1);
 
         T k0 = a;
         T k1 = b - a;
@@ -52,8 +147,8 @@ struct FGeneratorHelper
         return glm::tvec4<T, glm::defaultp>{result.y, result.z, result.w, result.x};
     }
 
-    template<typename T>
-    inline static T displacement(glm::tvec3<T, glm::defaultp> p)
+    template<typename T, ENoiseHashMode HashMode = ENoiseHashMode::Sine>
+    inline static T displacement(glm::tvec3<T, glm::defaultp> p, const TNoiseLatticeCache<T>* LatticeCache = nullptr)
     {
         // more cool tricks -> https://developer.nvidia.com/gpugems/GPUGems3/gpugems3_ch01.html
         glm::tvec3<T, glm::defaultp> pp = p;
@@ -62,7 +157,7 @@ struct FGeneratorHelper
         T s = static_cast<T>(1.0);
         for (int i = 0; i < 5; i++)
         {
-            glm::tvec4<T, glm::defaultp> rnd = noised(p + static_cast<T>(10.0));
+            glm::tvec4<T, glm::defaultp> rnd = noised<T, HashMode>(p + static_cast<T>(10.0), LatticeCache ? LatticeCache->GetOctave(i) : nullptr);
             d += rnd.w * mgn;
 
             p *= static_cast<T>(2.0);
@@ -77,7 +172,7 @@ struct FGeneratorHelper
         p = pp * pow(static_cast<T>(2.0), 5);
         for (int i = 0; i < 4; i++)
         {
-            glm::tvec4<T, glm::defaultp> rnd = noised(p);
+            glm::tvec4<T, glm::defaultp> rnd = noised<T, HashMode>(p, LatticeCache ? LatticeCache->GetOctave(5 + i) : nullptr);
             d += rnd.w * mgn;
 
             p *= static_cast<T>(2.0);
@@ -85,12 +180,304 @@ struct FGeneratorHelper
         }
         return d;
     }
+
+    // Fill the lattice tables of every displacement octave touched by samples inside [SampleMin, SampleMax].
+    // The warped octaves drift by at most 0.2 * |gradient| <= 0.75 per octave (compounded by the x2 frequency), the tables cover that bound.
+    // Bounds are in double (absolute lattice space) for the float chunk-local path too, T is only the stored hash type.
+    template<typename T, ENoiseHashMode HashMode = ENoiseHashMode::Sine>
+    inline static void BuildDisplacementLatticeCache(TNoiseLatticeCache<T>& LatticeCache, dvec3 SampleMin, dvec3 SampleMax, uint32_t MaxCellNum)
+    {
+        auto FillOctave = [&](uint32_t Octave, dvec3 Min, dvec3 Max)
+        {
+            //One cell of slack on each side against rounding of the warped positions, so lane lookups never leave the table
+            const ivec3 Origin = ivec3(floor(Min)) - 1;
+            const ivec3 Size = ivec3(floor(Max)) - Origin + 3;
+            TNoiseLatticeTable<T>& Table = LatticeCache.Octaves[Octave];
+            if ((uint64_t)Size.x * Size.y * Size.z <= MaxCellNum)
+            {
+                Table.template Fill<HashMode>(Origin, Size);
+            }
+            else
+            {
+                Table.Values.clear();
+            }
+        };
+        double Scale = 1.0;
+        double WarpBound = 0.0;
+        for (uint32_t i = 0; i < 5; i++)
+        {
+            FillOctave(i, SampleMin * Scale - WarpBound + 10.0, SampleMax * Scale + WarpBound + 10.0);
+            Scale *= 2.0;
+            WarpBound = WarpBound * 2.0 + 0.75;
+        }
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            FillOctave(5 + i, SampleMin * Scale, SampleMax * Scale);
+            Scale *= 2.0;
+        }
+    }
+    // Batched noised, evaluates LaneNum samples at once (SoA).
+    // Same operation order as noised, so lanes match the scalar path bit for bit when fp contraction is off (/fp:precise, -ffp-contract=off).
+    // With contraction (gnu++ default, -mfma) the difference stays below 1e-12 per sample in double.
+    // The noise is evaluated at LatticeOrigin + x, the integer origin only shifts the hashed corners so x can stay small (chunk-local) in float.
+    // That shift is exact for the integer hash only, the sine hash sees the origin converted to T.
+    template<typename T, uint32_t LaneNum = kSimdLaneNum, ENoiseHashMode HashMode = ENoiseHashMode::Sine>
+    inline static void noisedLanes(const TVec3Lanes<T, LaneNum>& x, TVec4Lanes<T, LaneNum>& Result, const TNoiseLatticeTable<T>* LatticeTable = nullptr, const ivec3& LatticeOrigin = ivec3(0))
+    {
+        alignas(64) T px[LaneNum], py[LaneNum], pz[LaneNum];
+        alignas(64) T ux[LaneNum], uy[LaneNum], uz[LaneNum];
+        alignas(64) T dux[LaneNum], duy[LaneNum], duz[LaneNum];
+        for (uint32_t i = 0; i < LaneNum; i++)
+        {
+            px[i] = std::floor(x.X[i]);
+            py[i] = std::floor(x.Y[i]);
+            pz[i] = std::floor(x.Z[i]);
+            const T wx = x.X[i] - px[i];
+            const T wy = x.Y[i] - py[i];
+            const T wz = x.Z[i] - pz[i];
+            ux[i] = wx * wx * wx * (wx * (wx * static_cast<T>(6.0) - static_cast<T>(15.0)) + static_cast<T>(10.0));
+            uy[i] = wy * wy * wy * (wy * (wy * static_cast<T>(6.0) - static_cast<T>(15.0)) + static_cast<T>(10.0));
+            uz[i] = wz * wz * wz * (wz * (wz * static_cast<T>(6.0) - static_cast<T>(15.0)) + static_cast<T>(10.0));
+            dux[i] = static_cast<T>(30.0) * wx * wx * (wx * (wx - static_cast<T>(2.0)) + static_cast<T>(1.0));
+            duy[i] = static_cast<T>(30.0) * wy * wy * (wy * (wy - static_cast<T>(2.0)) + static_cast<T>(1.0));
+            duz[i] = static_cast<T>(30.0) * wz * wz * (wz * (wz - static_cast<T>(2.0)) + static_cast<T>(1.0));
+        }
+        alignas(64) T Corner[8][LaneNum];
+        for (uint32_t c = 0; c < 8; c++)
+        {
+            const T ox = static_cast<T>(c & 1);
+            const T oy = static_cast<T>((c >> 1) & 1);
+            const T oz = static_cast<T>((c >> 2) & 1);
+            if (LatticeTable)
+            {
+                for (uint32_t i = 0; i < LaneNum; i++)
+                {
+                    Corner[c][i] = LatticeTable->GetInside((int32_t)px[i] + (int32_t)ox + LatticeOrigin.x, (int32_t)py[i] + (int32_t)oy + LatticeOrigin.y, (int32_t)pz[i] + (int32_t)oz + LatticeOrigin.z);
+                }
+            }
+            else if constexpr (HashMode == ENoiseHashMode::Integer)
+            {
+                for (uint32_t i = 0; i < LaneNum; i++)
+                {
+                    Corner[c][i] = FVoxelMathHelper::HashInteger<T>((int32_t)px[i] + (int32_t)ox + LatticeOrigin.x, (int32_t)py[i] + (int32_t)oy + LatticeOrigin.y, (int32_t)pz[i] + (int32_t)oz + LatticeOrigin.z);
+                }
+            }
+            else
+            {
+                for (uint32_t i = 0; i < LaneNum; i++)
+                {
+                    Corner[c][i] = FVoxelMathHelper::Hash(glm::tvec3<T, glm::defaultp>(px[i] + ox, py[i] + oy, pz[i] + oz) + glm::tvec3<T, glm::defaultp>(LatticeOrigin));
+                }
+            }
+        }
+        for (uint32_t i = 0; i < LaneNum; i++)
+        {
+            const T a = Corner[0][i];
+            const T b = Corner[1][i];
+            const T c = Corner[2][i];
+            const T d = Corner[3][i];
+            const T e = Corner[4][i];
+            const T f = Corner[5][i];
+            const T g = Corner[6][i];
+            const T h = Corner[7][i];
+
+            const T k0 = a;
+            const T k1 = b - a;
+            const T k2 = c - a;
+            const T k3 = e - a;
+            const T k4 = a - b - c + d;
+            const T k5 = a - c - e + g;
+            const T k6 = a - b - e + f;
+            const T k7 = -a + b + c - d + e - f - g + h;
+
+            Result.W[i] = -static_cast<T>(1.0) + static_cast<T>(2.0) * (k0 + k1 * ux[i] + k2 * uy[i] + k3 * uz[i] + k4 * ux[i] * uy[i] + k5 * uy[i] * uz[i] + k6 * uz[i] * ux[i] + k7 * ux[i] * uy[i] * uz[i]);
+            Result.X[i] = static_cast<T>(2.0) * dux[i] * (k1 + k4 * uy[i] + k6 * uz[i] + k7 * uy[i] * uz[i]);
+            Result.Y[i] = static_cast<T>(2.0) * duy[i] * (k2 + k5 * uz[i] + k4 * ux[i] + k7 * uz[i] * ux[i]);
+            Result.Z[i] = static_cast<T>(2.0) * duz[i] * (k3 + k6 * ux[i] + k5 * uy[i] + k7 * ux[i] * uy[i]);
+        }
+    }
+
+    // Batched displacement, see noisedLanes for the tolerance.
+    // Evaluated at LatticeOrigin + pp, every octave scales position by 2 so octave k sees the exact integer origin LatticeOrigin * 2^k
+    // and pp (plus the warp) stays small. Valid while LatticeOrigin * 2^8 fits in int32.
+    template<typename T, uint32_t LaneNum = kSimdLaneNum, ENoiseHashMode HashMode = ENoiseHashMode::Sine>
+    inline static void displacementLanes(const TVec3Lanes<T, LaneNum>& pp, T* Result, const TNoiseLatticeCache<T>* LatticeCache = nullptr, const ivec3& LatticeOrigin = ivec3(0))
+    {
+        TVec3Lanes<T, LaneNum> p;
+        TVec3Lanes<T, LaneNum> Offseted;
+        TVec4Lanes<T, LaneNum> rnd;
+        for (uint32_t i = 0; i < LaneNum; i++)
+        {
+            p.X[i] = pp.X[i];
+            p.Y[i] = pp.Y[i];
+            p.Z[i] = pp.Z[i];
+            Result[i] = static_cast<T>(0.0);
+        }
+        T mgn = static_cast<T>(0.5);
+        T s = static_cast<T>(1.0);
+        for (int o = 0; o < 5; o++)
+        {
+            for (uint32_t i = 0; i < LaneNum; i++)
+            {
+                Offseted.X[i] = p.X[i] + static_cast<T>(10.0);
+                Offseted.Y[i] = p.Y[i] + static_cast<T>(10.0);
+                Offseted.Z[i] = p.Z[i] + static_cast<T>(10.0);
+            }
+            noisedLanes<T, LaneNum, HashMode>(Offseted, rnd, LatticeCache ? LatticeCache->GetOctave(o) : nullptr, LatticeOrigin * (1 << o));
+            for (uint32_t i = 0; i < LaneNum; i++)
+            {
+                Result[i] += rnd.W[i] * mgn;
+                p.X[i] = p.X[i] * static_cast<T>(2.0) + rnd.X[i] * static_cast<T>(0.2) * s;
+                p.Y[i] = p.Y[i] * static_cast<T>(2.0) + rnd.Y[i] * static_cast<T>(0.2) * s;
+                p.Z[i] = p.Z[i] * static_cast<T>(2.0) + rnd.Z[i] * static_cast<T>(0.2) * s;
+            }
+            if (o == 2)
+            {
+                s *= static_cast<T>(-1.0);
+            }
+            mgn *= static_cast<T>(0.5);
+        }
+
+        for (uint32_t i = 0; i < LaneNum; i++)
+        {
+            p.X[i] = pp.X[i] * static_cast<T>(32.0);
+            p.Y[i] = pp.Y[i] * static_cast<T>(32.0);
+            p.Z[i] = pp.Z[i] * static_cast<T>(32.0);
+        }
+        for (int o = 0; o < 4; o++)
+        {
+            noisedLanes<T, LaneNum, HashMode>(p, rnd, LatticeCache ? LatticeCache->GetOctave(5 + o) : nullptr, LatticeOrigin * (1 << (5 + o)));
+            for (uint32_t i = 0; i < LaneNum; i++)
+            {
+                Result[i] += rnd.W[i] * mgn;
+                p.X[i] *= static_cast<T>(2.0);
+                p.Y[i] *= static_cast<T>(2.0);
+                p.Z[i] *= static_cast<T>(2.0);
+            }
+            mgn *= static_cast<T>(0.5);
+        }
+    }
+
+    // Integer part of the chunk's first noise sample, the float path evaluates the noise relative to it. Double keeps absolute samples
+    template<typename T>
+    inline static ivec3 GetTestGeneratorLatticeOrigin(ivec3 StartLocation, float BlockSize, unsigned char ChunkResolution)
+    {
+        if constexpr (std::is_same_v<T, double>)
+        {
+            return ivec3(0);
+        }
+        const dvec3 ChunkStartLocation = (dvec3)StartLocation * (double)BlockSize * (double)ChunkResolution;
+        return ivec3(floor(ChunkStartLocation * .1));
+    }
+    // Fill the whole Z row (X, Y fixed) of a TestGenerator chunk, LaneNum voxels per kernel call.
+    // T = float is the chunk-local mode: samples are formed in double, the lattice origin is subtracted, and only the small remainder goes through the float noise,
+    // so the error does not grow with the distance to the world origin (see displacementLanes for the int32 range)
+    template<uint32_t LaneNum = kSimdLaneNum, ENoiseHashMode HashMode = GeneratorHashMode, typename T = double>
+    inline static void TestGeneratorRow(FChunkOccupancyVolume& Occupancy, ivec3 StartLocation, float BlockSize, unsigned char ChunkResolution, uint32_t X, uint32_t Y, const TNoiseLatticeCache<T>* LatticeCache = nullptr)
+    {
+        static_assert(std::is_same_v<T, double> || HashMode == ENoiseHashMode::Integer, "Chunk-local float evaluation needs the integer hash");
+        const dvec3 ChunkStartLocation = (dvec3)StartLocation * (double)BlockSize * (double)ChunkResolution;
+        const ivec3 LatticeOrigin = GetTestGeneratorLatticeOrigin<T>(StartLocation, BlockSize, ChunkResolution);
+        TVec3Lanes<T, LaneNum> Samples;
+        alignas(64) T Displacement[LaneNum];
+        for (uint32_t ZStart = 0; ZStart < ChunkResolution; ZStart += LaneNum)
+        {
+            for (uint32_t i = 0; i < LaneNum; i++)
+            {
+                const uint32_t Z = std::min(ZStart + i, (uint32_t)ChunkResolution - 1u);//Tail lanes repeat the last voxel
+                const dvec3 BlockCenterLocation = ChunkStartLocation + dvec3{ X,Y,Z } *(double)BlockSize;
+                const dvec3 SampleLocation = BlockCenterLocation * .1 - dvec3(LatticeOrigin);
+                Samples.X[i] = static_cast<T>(SampleLocation.x);
+                Samples.Y[i] = static_cast<T>(SampleLocation.y);
+                Samples.Z[i] = static_cast<T>(SampleLocation.z);
+            }
+            displacementLanes<T, LaneNum, HashMode>(Samples, Displacement, LatticeCache, LatticeOrigin);
+            for (uint32_t i = 0; i < LaneNum && ZStart + i < ChunkResolution; i++)
+            {
+                const uint32_t Z = ZStart + i;
+                const double BlockCenterY = ChunkStartLocation.y + (double)Y * (double)BlockSize;
+                double d = (BlockCenterY * .5 + Displacement[i] * 10.3) * .4;
+                if (d < 0.0)
+                {
+                    Occupancy.Set(true, { X, Y, Z });
+                }
+            }
+        }
+    }
+    // Bounds of the voxel sample locations of a chunk (the first and last BlockCenterLocation)
+    inline static std::tuple<dvec3, dvec3> GetChunkSampleBounds(ivec3 StartLocation, float BlockSize, unsigned char ChunkResolution)
+    {
+        const dvec3 ChunkStartLocation = (dvec3)StartLocation * (double)BlockSize * (double)ChunkResolution;
+        const dvec3 ChunkEndLocation = ChunkStartLocation + dvec3((double)(ChunkResolution - 1)) * (double)BlockSize;
+        return { ChunkStartLocation, ChunkEndLocation };
+    }
+    // Lattice tables covering every sample of a TestGenerator chunk, octaves bigger than the voxel count are left uncached
+    template<ENoiseHashMode HashMode = GeneratorHashMode, typename T = double>
+    inline static void BuildTestGeneratorLatticeCache(TNoiseLatticeCache<T>& LatticeCache, ivec3 StartLocation, float BlockSize, unsigned char ChunkResolution)
+    {
+        const auto [SampleMin, SampleMax] = GetChunkSampleBounds(StartLocation, BlockSize, ChunkResolution);
+        BuildDisplacementLatticeCache<T, HashMode>(LatticeCache, SampleMin * .1, SampleMax * .1, (uint32_t)ChunkResolution * ChunkResolution * ChunkResolution);
+    }
+    // |displacement| <= 0.5 + 0.25 + ... + 2^-9 since every octave is in [-1, 1), so the TestGenerator surface stays inside |y| < 20.6 * that
+    inline static EGeneratorRegion ClassifyTestGeneratorRegion(dvec3 SampleMin, dvec3 SampleMax)
+    {
+        constexpr double SurfaceHalfHeight = 20.6 * (1.0 - 1.0 / 512.0);
+        if (SampleMin.y >= SurfaceHalfHeight)
+        {
+            return EGeneratorRegion::Empty;
+        }
+        if (SampleMax.y < -SurfaceHalfHeight)
+        {
+            return EGeneratorRegion::Solid;
+        }
+        return EGeneratorRegion::Mixed;
+    }
+    inline static EGeneratorRegion ClassifyTestGenerator(ivec3 StartLocation, float BlockSize, unsigned char ChunkResolution, uint32_t MipmapLevel)
+    {
+        const auto [SampleMin, SampleMax] = GetChunkSampleBounds(StartLocation, BlockSize, ChunkResolution);
+        return ClassifyTestGeneratorRegion(SampleMin, SampleMax);
+    }
+    // Occupancy generator (see FChunkManage::OccupancyGeneratorType), writes the TestGenerator voxels into a cleared volume, one row per call.
+    // T = float is the chunk-local single precision mode, close to but not bit identical with double
+    template<uint32_t LaneNum = kSimdLaneNum, ENoiseHashMode HashMode = GeneratorHashMode, bool bLatticeCache = true, typename T = double>
+    inline static void TestGeneratorOccupancy(FChunkOccupancyVolume& Occupancy, ivec3 StartLocation, float BlockSize, unsigned char ChunkResolution, uint32_t MipmapLevel)
+    {
+        TNoiseLatticeCache<T> LatticeCache;
+        if constexpr (bLatticeCache)
+        {
+            BuildTestGeneratorLatticeCache<HashMode, T>(LatticeCache, StartLocation, BlockSize, ChunkResolution);
+        }
+        for (uint32_t X = 0; X < ChunkResolution; X++)
+        {
+            for (uint32_t Y = 0; Y < ChunkResolution; Y++)
+            {
+                TestGeneratorRow<LaneNum, HashMode, T>(Occupancy, StartLocation, BlockSize, ChunkResolution, X, Y, bLatticeCache ? &LatticeCache : nullptr);
+            }
+        }
+    }
+    // Same output as TestGenerator (T = double)
+    template<uint32_t LaneNum = kSimdLaneNum, ENoiseHashMode HashMode = GeneratorHashMode, bool bLatticeCache = true, typename T = double>
+    inline static FChunk TestGeneratorBatched(ivec3 StartLocation, float BlockSize, unsigned char ChunkResolution, uint32_t MipmapLevel)
+    {
+        FChunk Result;
+        Result.ChunkLocation = StartLocation;
+        FChunkOccupancyVolume Occupancy;
+        TestGeneratorOccupancy<LaneNum, HashMode, bLatticeCache, T>(Occupancy, StartLocation, BlockSize, ChunkResolution, MipmapLevel);
+        Result.AddBlocksFromOccupancy(Occupancy);
+        return Result;
+    }
     //Todo: can be optimize by octree (culling on top level)
     //If using neural, can train a "min sdf" layered network for fast culling
+    template<ENoiseHashMode HashMode = GeneratorHashMode, bool bLatticeCache = false>
     inline static FChunk TestGenerator(ivec3 StartLocation, float BlockSize, unsigned char ChunkResolution, uint32_t MipmapLevel)
     {
         FChunk Result;
         Result.ChunkLocation = StartLocation;
+        TNoiseLatticeCache<double> LatticeCache;
+        if constexpr (bLatticeCache)
+        {
+            BuildTestGeneratorLatticeCache<HashMode>(LatticeCache, StartLocation, BlockSize, ChunkResolution);
+        }
         using uchar = unsigned char;
         for (uint32_t X = 0; X < ChunkResolution; X++)
         {
@@ -101,7 +488,7 @@ struct FGeneratorHelper
                     dvec3 ChunkStartLocation = (dvec3)StartLocation * (double)BlockSize * (double)ChunkResolution;
                     dvec3 BlockCenterLocation = ChunkStartLocation + dvec3{ X,Y,Z } *(double)BlockSize;
 
-                    double d = (BlockCenterLocation.y * .5 + (displacement(BlockCenterLocation * .1)) * 10.3) * .4;
+                    double d = (BlockCenterLocation.y * .5 + (displacement<double, HashMode>(BlockCenterLocation * .1, bLatticeCache ? &LatticeCache : nullptr)) * 10.3) * .4;
                     if (d < 0.0)
                     {
                         Result.AddBlock(
@@ -117,6 +504,10 @@ struct FGeneratorHelper
         }
         return Result;// Result;
     }
+    inline static double SphereSdf(dvec3 Location)
+    {
+        return length(Location - dvec3{ 100.0, 0.0, 0.0 }) - 50.0;
+    }
     inline static FChunk GenerateSphere(ivec3 StartLocation, float BlockSize, unsigned char ChunkResolution, uint32_t MipmapLevel)
     {
         FChunk Result;
@@ -131,7 +522,7 @@ struct FGeneratorHelper
                     dvec3 ChunkStartLocation = (dvec3)StartLocation * (double)BlockSize * (double)ChunkResolution;
                     dvec3 BlockCenterLocation = ChunkStartLocation + dvec3{ X,Y,Z } *(double)BlockSize;
 
-                    double d = length(BlockCenterLocation - dvec3{100.0, 0.0, 0.0}) - 50.0;
+                    double d = SphereSdf(BlockCenterLocation);
                     if (d < 0.0)
                     {
                         Result.AddBlock(
@@ -145,7 +536,191 @@ struct FGeneratorHelper
                 }
             }
         }
-        Result.CalculateOccupancyErodeMipmaps();
+        Result.CalculateOccupancyInteriorDepth();
         return Result;// Result;
     }
+    // Exact, nearest and farthest point of the box against the GenerateSphere sphere
+    inline static EGeneratorRegion ClassifySphereRegion(dvec3 SampleMin, dvec3 SampleMax)
+    {
+        const dvec3 Center = dvec3{ 100.0, 0.0, 0.0 };
+        const double Radius = 50.0;
+        const dvec3 Nearest = glm::clamp(Center, SampleMin, SampleMax);
+        const dvec3 Farthest = glm::max(abs(SampleMin - Center), abs(SampleMax - Center));
+        if (length(Nearest - Center) - Radius >= 0.0)
+        {
+            return EGeneratorRegion::Empty;
+        }
+        if (length(Farthest) - Radius < 0.0)
+        {
+            return EGeneratorRegion::Solid;
+        }
+        return EGeneratorRegion::Mixed;
+    }
+    inline static EGeneratorRegion ClassifySphere(ivec3 StartLocation, float BlockSize, unsigned char ChunkResolution, uint32_t MipmapLevel)
+    {
+        const auto [SampleMin, SampleMax] = GetChunkSampleBounds(StartLocation, BlockSize, ChunkResolution);
+        return ClassifySphereRegion(SampleMin, SampleMax);
+    }
+
+    // Octree evaluation of the voxels [Start, Start + Size) (clamped to the chunk) with one Sdf call per node.
+    // Any sample p of the node has |Sdf(p) - Sdf(Center)| <= Lipschitz * |p - Center|, so the node is filled or skipped once the centre is far enough from the surface.
+    // Single voxels are evaluated at the exact brute-force location, the output matches it for any valid Lipschitz.
+    template<typename FSdf>
+    inline static void SubdivideLipschitz(FChunkOccupancyVolume& Occupancy, const FSdf& Sdf, double Lipschitz, dvec3 ChunkStartLocation, float BlockSize, uint32_t ChunkResolution, ivec3 Start, uint32_t Size)
+    {
+        if (Size == 1)
+        {
+            const dvec3 BlockCenterLocation = ChunkStartLocation + dvec3(Start) * (double)BlockSize;
+            if (Sdf(BlockCenterLocation) < 0.0)
+            {
+                Occupancy.Set(true, Start);
+            }
+            return;
+        }
+        const ivec3 End = glm::min(Start + (int32_t)Size, ivec3((int32_t)ChunkResolution));
+        const dvec3 Extent = dvec3(End - Start - 1) * (double)BlockSize;
+        const dvec3 Center = ChunkStartLocation + dvec3(Start) * (double)BlockSize + Extent * 0.5;
+        const double Bound = Lipschitz * length(Extent) * 0.5 * (1.0 + 1e-9) + 1e-9;//Slack for the rounding of Center
+        const double d = Sdf(Center);
+        if (d - Bound >= 0.0)
+        {
+            return;
+        }
+        if (d + Bound < 0.0)
+        {
+            for (int32_t X = Start.x; X < End.x; X++)
+            {
+                for (int32_t Y = Start.y; Y < End.y; Y++)
+                {
+                    for (int32_t Z = Start.z; Z < End.z; Z++)
+                    {
+                        Occupancy.Set(true, { X, Y, Z });
+                    }
+                }
+            }
+            return;
+        }
+        const uint32_t HalfSize = Size / 2;
+        for (uint32_t i = 0; i < 8; i++)
+        {
+            const ivec3 ChildStart = Start + ivec3(i & 1, (i >> 1) & 1, (i >> 2) & 1) * (int32_t)HalfSize;
+            if (ChildStart.x < End.x && ChildStart.y < End.y && ChildStart.z < End.z)
+            {
+                SubdivideLipschitz(Occupancy, Sdf, Lipschitz, ChunkStartLocation, BlockSize, ChunkResolution, ChildStart, HalfSize);
+            }
+        }
+    }
+    // Occupancy version of GenerateLipschitz, Occupancy must be cleared
+    template<typename FSdf>
+    inline static void GenerateLipschitzOccupancy(FChunkOccupancyVolume& Occupancy, ivec3 StartLocation, float BlockSize, unsigned char ChunkResolution, uint32_t MipmapLevel, const FSdf& Sdf, double Lipschitz)
+    {
+        const dvec3 ChunkStartLocation = (dvec3)StartLocation * (double)BlockSize * (double)ChunkResolution;
+        uint32_t RootSize = 1;
+        while (RootSize < ChunkResolution)
+        {
+            RootSize *= 2;
+        }
+        SubdivideLipschitz(Occupancy, Sdf, Lipschitz, ChunkStartLocation, BlockSize, ChunkResolution, ivec3(0), RootSize);
+    }
+    // Generate from any Sdf (solid where < 0) with a declared Lipschitz constant (world units), blocks come out in the brute-force X, Y, Z order
+    template<typename FSdf>
+    inline static FChunk GenerateLipschitz(ivec3 StartLocation, float BlockSize, unsigned char ChunkResolution, uint32_t MipmapLevel, const FSdf& Sdf, double Lipschitz)
+    {
+        FChunk Result;
+        Result.ChunkLocation = StartLocation;
+        FChunkOccupancyVolume Occupancy;
+        GenerateLipschitzOccupancy(Occupancy, StartLocation, BlockSize, ChunkResolution, MipmapLevel, Sdf, Lipschitz);
+        Result.AddBlocksFromOccupancy(Occupancy);
+        return Result;
+    }
+    // Same output as GenerateSphere, a distance field is 1-Lipschitz
+    inline static FChunk GenerateSphereLipschitz(ivec3 StartLocation, float BlockSize, unsigned char ChunkResolution, uint32_t MipmapLevel)
+    {
+        FChunk Result = GenerateLipschitz(StartLocation, BlockSize, ChunkResolution, MipmapLevel, &SphereSdf, 1.0);
+        Result.CalculateOccupancyInteriorDepth();
+        return Result;
+    }
+    inline static void GenerateSphereOccupancy(FChunkOccupancyVolume& Occupancy, ivec3 StartLocation, float BlockSize, unsigned char ChunkResolution, uint32_t MipmapLevel)
+    {
+        GenerateLipschitzOccupancy(Occupancy, StartLocation, BlockSize, ChunkResolution, MipmapLevel, &SphereSdf, 1.0);
+    }
+
+    // Heightfield terrain, fbm of noised without domain warp (the TestGenerator warp makes its Lipschitz bound too loose to cull anything)
+    inline static constexpr double FbmTerrainAmplitude = 16.0;
+    inline static constexpr double FbmTerrainFrequency = 1.0 / 128.0;
+    inline static constexpr int FbmTerrainOctaveNum = 4;
+    template<ENoiseHashMode HashMode = GeneratorHashMode>
+    inline static double FbmTerrainSdf(dvec3 Location)
+    {
+        double Height = 0.0;
+        double mgn = 0.5;
+        double Frequency = FbmTerrainFrequency;
+        for (int i = 0; i < FbmTerrainOctaveNum; i++)
+        {
+            Height += noised<double, HashMode>(dvec3{ Location.x * Frequency, 0.0, Location.z * Frequency }).w * mgn;
+            Frequency *= 2.0;
+            mgn *= 0.5;
+        }
+        return Location.y - Height * FbmTerrainAmplitude;
+    }
+    // Each noised partial derivative is 2 * du * (edge difference) <= 2 * 1.875, every octave has mgn * Frequency = FbmTerrainFrequency / 2
+    inline static double GetFbmTerrainLipschitz()
+    {
+        const double HeightSlope = FbmTerrainAmplitude * FbmTerrainFrequency * 0.5 * FbmTerrainOctaveNum * 3.75 * std::sqrt(2.0);
+        return std::sqrt(1.0 + HeightSlope * HeightSlope);
+    }
+    template<ENoiseHashMode HashMode = GeneratorHashMode>
+    inline static FChunk GenerateFbmTerrain(ivec3 StartLocation, float BlockSize, unsigned char ChunkResolution, uint32_t MipmapLevel)
+    {
+        FChunk Result;
+        Result.ChunkLocation = StartLocation;
+        using uchar = unsigned char;
+        const dvec3 ChunkStartLocation = (dvec3)StartLocation * (double)BlockSize * (double)ChunkResolution;
+        for (uint32_t X = 0; X < ChunkResolution; X++)
+        {
+            for (uint32_t Y = 0; Y < ChunkResolution; Y++)
+            {
+                for (uint32_t Z = 0; Z < ChunkResolution; Z++)
+                {
+                    dvec3 BlockCenterLocation = ChunkStartLocation + dvec3{ X,Y,Z } *(double)BlockSize;
+                    if (FbmTerrainSdf<HashMode>(BlockCenterLocation) < 0.0)
+                    {
+                        Result.AddBlock(
+                            {
+                                .ChunkIndex = 0,
+                                .BlockLocation = {(uchar)X,(uchar)Y,(uchar)Z},
+                                .VolumeIndex = 0,
+                            }
+                        );
+                    }
+                }
+            }
+        }
+        return Result;
+    }
+    template<ENoiseHashMode HashMode = GeneratorHashMode>
+    inline static FChunk GenerateFbmTerrainLipschitz(ivec3 StartLocation, float BlockSize, unsigned char ChunkResolution, uint32_t MipmapLevel)
+    {
+        return GenerateLipschitz(StartLocation, BlockSize, ChunkResolution, MipmapLevel, &FbmTerrainSdf<HashMode>, GetFbmTerrainLipschitz());
+    }
+    template<ENoiseHashMode HashMode = GeneratorHashMode>
+    inline static void GenerateFbmTerrainOccupancy(FChunkOccupancyVolume& Occupancy, ivec3 StartLocation, float BlockSize, unsigned char ChunkResolution, uint32_t MipmapLevel)
+    {
+        GenerateLipschitzOccupancy(Occupancy, StartLocation, BlockSize, ChunkResolution, MipmapLevel, &FbmTerrainSdf<HashMode>, GetFbmTerrainLipschitz());
+    }
+    // The height stays inside +-FbmTerrainAmplitude * (1 - 2^-FbmTerrainOctaveNum)
+    inline static EGeneratorRegion ClassifyFbmTerrain(ivec3 StartLocation, float BlockSize, unsigned char ChunkResolution, uint32_t MipmapLevel)
+    {
+        const auto [SampleMin, SampleMax] = GetChunkSampleBounds(StartLocation, BlockSize, ChunkResolution);
+        const double MaxHeight = FbmTerrainAmplitude * (1.0 - 1.0 / (double)(1 << FbmTerrainOctaveNum));
+        if (SampleMin.y >= MaxHeight)
+        {
+            return EGeneratorRegion::Empty;
+        }
+        if (SampleMax.y < -MaxHeight)
+        {
+            return EGeneratorRegion::Solid;
+        }
+        return EGeneratorRegion::Mixed;
+    }
 };
\ No newline at end of file
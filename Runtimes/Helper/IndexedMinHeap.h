@@ -0,0 +1,143 @@
+// Meso Engine 2024
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/*
+Binary min heap over ids [0, IdNum) with a float key each, the position of every id is tracked so a key can change in O(log n).
+Min is O(1), Rebuild re-keys everything in O(n) (bottom up heapify) when all keys move at once.
+*/
+class FIndexedMinHeap
+{
+public:
+    static constexpr uint32_t InvalidPosition = UINT32_MAX;
+
+    void Reset(uint32_t IdNum)
+    {
+        Heap.clear();
+        Heap.reserve(IdNum);
+        Keys.assign(IdNum, INFINITY);
+        Positions.assign(IdNum, InvalidPosition);
+    }
+    uint32_t Size() const
+    {
+        return (uint32_t)Heap.size();
+    }
+    bool bEmpty() const
+    {
+        return Heap.empty();
+    }
+    bool bContains(uint32_t Id) const
+    {
+        return Positions[Id] != InvalidPosition;
+    }
+    float GetKey(uint32_t Id) const
+    {
+        return Keys[Id];
+    }
+    uint32_t GetMin() const
+    {
+        return Heap.front();
+    }
+    float GetMinKey() const
+    {
+        return Keys[Heap.front()];
+    }
+    //Insert or change the key
+    void Set(uint32_t Id, float Key)
+    {
+        const float OldKey = Keys[Id];
+        Keys[Id] = Key;
+        if (!bContains(Id))
+        {
+            Positions[Id] = (uint32_t)Heap.size();
+            Heap.push_back(Id);
+            SiftUp(Positions[Id]);
+        }
+        else if (Key < OldKey)
+        {
+            SiftUp(Positions[Id]);
+        }
+        else
+        {
+            SiftDown(Positions[Id]);
+        }
+    }
+    void Remove(uint32_t Id)
+    {
+        const uint32_t Position = Positions[Id];
+        if (Position == InvalidPosition)
+        {
+            return;
+        }
+        Swap(Position, (uint32_t)Heap.size() - 1);
+        Heap.pop_back();
+        Positions[Id] = InvalidPosition;
+        Keys[Id] = INFINITY;
+        if (Position < Heap.size())
+        {
+            const uint32_t Moved = Heap[Position];
+            SiftUp(Position);
+            SiftDown(Positions[Moved]);
+        }
+    }
+    //GetKey(uint32_t Id) -> float for every id in the heap
+    template<typename FGetKey>
+    void Rebuild(FGetKey&& GetNewKey)
+    {
+        for (uint32_t Id : Heap)
+        {
+            Keys[Id] = GetNewKey(Id);
+        }
+        for (uint32_t Position = (uint32_t)Heap.size() / 2; Position-- > 0;)
+        {
+            SiftDown(Position);
+        }
+    }
+private:
+    std::vector<uint32_t> Heap;
+    std::vector<float> Keys;
+    std::vector<uint32_t> Positions;
+
+    void Swap(uint32_t A, uint32_t B)
+    {
+        std::swap(Heap[A], Heap[B]);
+        Positions[Heap[A]] = A;
+        Positions[Heap[B]] = B;
+    }
+    void SiftUp(uint32_t Position)
+    {
+        while (Position > 0)
+        {
+            const uint32_t Parent = (Position - 1) / 2;
+            if (!(Keys[Heap[Position]] < Keys[Heap[Parent]]))
+            {
+                break;
+            }
+            Swap(Position, Parent);
+            Position = Parent;
+        }
+    }
+    void SiftDown(uint32_t Position)
+    {
+        const uint32_t Num = (uint32_t)Heap.size();
+        while (true)
+        {
+            const uint32_t Left = Position * 2 + 1;
+            if (Left >= Num)
+            {
+                break;
+            }
+            const uint32_t Right = Left + 1;
+            const uint32_t Child = (Right < Num && Keys[Heap[Right]] < Keys[Heap[Left]]) ? Right : Left;
+            if (!(Keys[Heap[Child]] < Keys[Heap[Position]]))
+            {
+                break;
+            }
+            Swap(Position, Child);
+            Position = Child;
+        }
+    }
+};
@@ -0,0 +1,44 @@
+// Meso Engine 2024
+#pragma once
+#include <cstdint>
+
+// Lane width of the batched generator kernels, counted in floats per register.
+// Kernels are written as fixed-width lane loops, the compiler maps them onto SSE4/AVX2/AVX-512 registers (doubles take two registers per lane group).
+// Select the instruction set with MESO_SIMD_INSTRUCTION_SET in cmake, None (or no SSE4 and up) is scalar with 1 lane.
+#if !defined(MESO_SIMD_LANE_NUM)
+#if defined(__AVX512F__)
+#define MESO_SIMD_LANE_NUM 16
+#elif defined(__AVX2__) || defined(__AVX__)
+#define MESO_SIMD_LANE_NUM 8
+#elif defined(__SSE4_1__)
+#define MESO_SIMD_LANE_NUM 4
+#else
+#define MESO_SIMD_LANE_NUM 1
+#endif
+#endif
+
+#if defined(_MSC_VER)
+#define MESO_FORCEINLINE __forceinline
+#else
+#define MESO_FORCEINLINE inline __attribute__((always_inline))
+#endif
+
+constexpr uint32_t kSimdLaneNum = MESO_SIMD_LANE_NUM;
+
+//Structure of arrays, one vector per lane
+template<typename T, uint32_t LaneNum = kSimdLaneNum>
+struct TVec3Lanes
+{
+	alignas(64) T X[LaneNum];
+	alignas(64) T Y[LaneNum];
+	alignas(64) T Z[LaneNum];
+};
+
+template<typename T, uint32_t LaneNum = kSimdLaneNum>
+struct TVec4Lanes
+{
+	alignas(64) T X[LaneNum];
+	alignas(64) T Y[LaneNum];
+	alignas(64) T Z[LaneNum];
+	alignas(64) T W[LaneNum];
+};
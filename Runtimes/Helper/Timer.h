@@ -1,7 +1,7 @@
 // Meso Engine 2024
 #pragma once
 
-#include <lvk/LVK.h>
+#include <chrono>
 
 class FTimer
 {
@@ -12,9 +12,14 @@ public:
 	{
 		Start();
 	}
+	//Seconds on a monotonic clock. Was glfwGetTime, which needs glfwInit and kept headless tools off the runtime
+	static double Now()
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
 	double Start()
 	{
-		StartTime = glfwGetTime();
+		StartTime = Now();
 		return StartTime;
 	}
 	double Step(bool bOverride = true)
@@ -22,12 +27,12 @@ public:
 		if (bOverride)
 		{
 			double StartTimeOld = StartTime;
-			StartTime = glfwGetTime();
+			StartTime = Now();
 			return StartTime - StartTimeOld;
 		}
 		else
 		{
-			return glfwGetTime() - StartTime;
+			return Now() - StartTime;
 		}
 	}
-};
\ No newline at end of file
+};
@@ -21,27 +21,27 @@ public:
 			TotalTime[Key] = 0.0;
 			TempTime[Key] = 0.0;
 		}
-		StartTime[Key] = glfwGetTime();
+		StartTime[Key] = FTimer::Now();
 	}
 	void Record(const std::string& Key, uint32_t RecordTimes = 1)
 	{
-		double EndTime = glfwGetTime();
+		double EndTime = FTimer::Now();
 		TotalTime[Key] += EndTime - StartTime[Key];
 		TotalRecordCount[Key] += RecordTimes;
-		StartTime[Key] = glfwGetTime();
+		StartTime[Key] = FTimer::Now();
 	}
 	void Stage(const std::string& Key)
 	{
-		double EndTime = glfwGetTime();
+		double EndTime = FTimer::Now();
 		TempTime[Key] = EndTime - StartTime[Key];
-		StartTime[Key] = glfwGetTime();
+		StartTime[Key] = FTimer::Now();
 	}
 	void RecordStage(const std::string& Key, uint32_t RecordTimes = 1)
 	{
 		TotalTime[Key] += TempTime[Key];
 		TotalRecordCount[Key] += RecordTimes;
 		TempTime[Key] = 0.0;
-		StartTime[Key] = glfwGetTime();
+		StartTime[Key] = FTimer::Now();
 	}
 	double GetAverage(const std::string& Key)
 	{
@@ -0,0 +1,114 @@
+// Meso Engine 2024
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "Helper/DirtySpans.h"
+
+/*
+Modified index ranges of a buffer, each tagged with the version it was made at. Versions only grow.
+Every copy of the buffer (one per buffered frame) remembers the last version it got and Gathers what came after,
+once all copies are past a version its entries are Truncated. A change is logged once however many copies there are.
+*/
+class FVersionedSpanLog
+{
+public:
+    static constexpr size_t MaxEntryNum = FDirtySpans::MaxSpanNum;
+
+    //Room for the most entries there can be, logging never allocates after it
+    void Reserve()
+    {
+        Entries.reserve(MaxEntryNum);
+    }
+    void AddRange(uint64_t Version, uint32_t Begin, uint32_t End)
+    {
+        if (Begin >= End)
+        {
+            return;
+        }
+        //Same version and touching, a pushed chunk's blocks stay one entry
+        if (Head < Entries.size() && Entries.back().Version == Version && Begin >= Entries.back().Begin && Begin <= Entries.back().End)
+        {
+            Entries.back().End = std::max(Entries.back().End, End);
+            return;
+        }
+        if (Entries.size() == MaxEntryNum)
+        {
+            Compact(Version);
+        }
+        Entries.push_back({ Version, Begin, End });
+    }
+    //Everything logged after SinceVersion
+    void Gather(uint64_t SinceVersion, FDirtySpans& Spans) const
+    {
+        for (size_t i = FindAfter(SinceVersion); i < Entries.size(); i++)
+        {
+            Spans.AddRange(Entries[i].Begin, Entries[i].End);
+        }
+    }
+    //Drops everything up to Version, every copy has it
+    void Truncate(uint64_t Version)
+    {
+        Head = FindAfter(Version);
+        //Compacted once the dead half is big enough, no allocation
+        if (Head == Entries.size())
+        {
+            Entries.clear();
+            Head = 0;
+        }
+        else if (Head * 2 >= Entries.size())
+        {
+            Entries.erase(Entries.begin(), Entries.begin() + Head);
+            Head = 0;
+        }
+    }
+    size_t Size() const
+    {
+        return Entries.size() - Head;
+    }
+private:
+    struct FEntry
+    {
+        uint64_t Version;
+        uint32_t Begin;
+        uint32_t End;//Exclusive
+    };
+    std::vector<FEntry> Entries;
+    size_t Head = 0;//Entries before it are truncated
+
+    //Full, drops the truncated entries or else merges the live ones at Version. Copies past an older entry only get it again
+    void Compact(uint64_t Version)
+    {
+        if (Head > 0)
+        {
+            Entries.erase(Entries.begin(), Entries.begin() + Head);
+            Head = 0;
+            return;
+        }
+        std::sort(Entries.begin(), Entries.end(), [](const FEntry& A, const FEntry& B) { return A.Begin < B.Begin; });
+        for (uint32_t MaxGap = 0; Entries.size() > MaxEntryNum / 2; MaxGap = MaxGap * 2 + 1)
+        {
+            size_t Last = 0;
+            for (size_t i = 1; i < Entries.size(); i++)
+            {
+                if ((uint64_t)Entries[i].Begin <= (uint64_t)Entries[Last].End + MaxGap)
+                {
+                    Entries[Last].End = std::max(Entries[Last].End, Entries[i].End);
+                }
+                else
+                {
+                    Entries[++Last] = Entries[i];
+                }
+            }
+            Entries.resize(Last + 1);
+        }
+        for (FEntry& Entry : Entries)
+        {
+            Entry.Version = Version;
+        }
+    }
+    size_t FindAfter(uint64_t Version) const
+    {
+        return std::upper_bound(Entries.begin() + Head, Entries.end(), Version, [](uint64_t Value, const FEntry& Entry) { return Value < Entry.Version; }) - Entries.begin();
+    }
+};
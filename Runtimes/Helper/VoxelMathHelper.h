@@ -3,6 +3,9 @@
 #include <glm/ext.hpp>
 #include <glm/glm.hpp>
 #include <tuple>
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
 using glm::vec3;
 using glm::vec2;
 using glm::ivec3;
@@ -10,6 +13,14 @@ using glm::ivec4;
 using glm::u8vec3;
 using glm::u8vec4;
 
+// Sine: fract(sin(dot)), the shadertoy classic, libm dependent
+// Integer: PCG3D on the integer lattice, bit exact everywhere and vectorizes
+enum class ENoiseHashMode : uint8_t
+{
+	Sine = 0,
+	Integer = 1,
+};
+
 #define _USE_MATH_DEFINES
 struct FVoxelMathHelper
 {
@@ -32,6 +43,37 @@ struct FVoxelMathHelper
 		return Fract(sin(dot(Position, glm::tvec3<T, glm::defaultp>(127.1, 311.7, 74.7))) * static_cast<T>(43758.5453123));
 	}
 
+	// https://jcgt.org/published/0009/03/02/ (pcg3d), output in [0, 1) with 24 bits
+	template<typename T>
+	inline static T HashInteger(int32_t X, int32_t Y, int32_t Z)
+	{
+		uint32_t HX = (uint32_t)X * 1664525u + 1013904223u;
+		uint32_t HY = (uint32_t)Y * 1664525u + 1013904223u;
+		uint32_t HZ = (uint32_t)Z * 1664525u + 1013904223u;
+		HX += HY * HZ; HY += HZ * HX; HZ += HX * HY;
+		HX ^= HX >> 16u; HY ^= HY >> 16u; HZ ^= HZ >> 16u;
+		HX += HY * HZ; HY += HZ * HX; HZ += HX * HY;
+		return static_cast<T>(HX >> 8u) * static_cast<T>(1.0 / 16777216.0);
+	}
+	template<typename T>
+	inline static T HashInteger(const ivec3& Lattice)
+	{
+		return HashInteger<T>(Lattice.x, Lattice.y, Lattice.z);
+	}
+	// Hash of the lattice corner Lattice + Offset, Lattice comes from floor() so the integer cast is exact (valid for |Lattice| < 2^31)
+	template<typename T, ENoiseHashMode HashMode>
+	inline static T HashLattice(const glm::tvec3<T, glm::defaultp>& Lattice, int32_t OffsetX, int32_t OffsetY, int32_t OffsetZ)
+	{
+		if constexpr (HashMode == ENoiseHashMode::Integer)
+		{
+			return HashInteger<T>((int32_t)Lattice.x + OffsetX, (int32_t)Lattice.y + OffsetY, (int32_t)Lattice.z + OffsetZ);
+		}
+		else
+		{
+			return Hash(Lattice + glm::tvec3<T, glm::defaultp>(OffsetX, OffsetY, OffsetZ));
+		}
+	}
+
 	template<typename T>
 	inline static T Hash(glm::tvec2<T, glm::defaultp> Position)
 	{
@@ -79,6 +121,46 @@ struct FVoxelMathHelper
 		ivec3 LocationClamped = Clamp3D(Location, Resolution - ivec3{ 1,1,1 });
 		return LocationClamped.x + LocationClamped.y * Resolution.x + LocationClamped.z * Resolution.x * Resolution.y;
 	}
+	// Z-order index, X in the lowest of every 3 bits, 10 bits per axis. pdep/pext with BMI2, magic number shifts otherwise
+	inline static uint32_t MortonEncode3D(uint32_t X, uint32_t Y, uint32_t Z)
+	{
+#if defined(__BMI2__)
+		return _pdep_u32(X, 0x09249249u) | _pdep_u32(Y, 0x12492492u) | _pdep_u32(Z, 0x24924924u);
+#else
+		return SpreadBits3(X) | (SpreadBits3(Y) << 1) | (SpreadBits3(Z) << 2);
+#endif
+	}
+	inline static uint32_t MortonEncode3D(const ivec3& Location)
+	{
+		return MortonEncode3D((uint32_t)Location.x, (uint32_t)Location.y, (uint32_t)Location.z);
+	}
+	inline static ivec3 MortonDecode3D(uint32_t Index)
+	{
+#if defined(__BMI2__)
+		return { (int32_t)_pext_u32(Index, 0x09249249u), (int32_t)_pext_u32(Index, 0x12492492u), (int32_t)_pext_u32(Index, 0x24924924u) };
+#else
+		return { (int32_t)CompactBits3(Index), (int32_t)CompactBits3(Index >> 1), (int32_t)CompactBits3(Index >> 2) };
+#endif
+	}
+	// Low 10 bits to every third bit and back
+	inline static uint32_t SpreadBits3(uint32_t Value)
+	{
+		Value &= 0x000003FFu;
+		Value = (Value | (Value << 16)) & 0x030000FFu;
+		Value = (Value | (Value << 8)) & 0x0300F00Fu;
+		Value = (Value | (Value << 4)) & 0x030C30C3u;
+		Value = (Value | (Value << 2)) & 0x09249249u;
+		return Value;
+	}
+	inline static uint32_t CompactBits3(uint32_t Value)
+	{
+		Value &= 0x09249249u;
+		Value = (Value | (Value >> 2)) & 0x030C30C3u;
+		Value = (Value | (Value >> 4)) & 0x0300F00Fu;
+		Value = (Value | (Value >> 8)) & 0x030000FFu;
+		Value = (Value | (Value >> 16)) & 0x000003FFu;
+		return Value;
+	}
 	template<typename T>
 	inline static T Clamp(T Value, T Min, T Max)
 	{
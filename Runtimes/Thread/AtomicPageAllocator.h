@@ -0,0 +1,84 @@
+// Meso Engine 2024
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+/*
+Lock-free free list of page ids [0, PageNum), any thread can take or give back a page.
+The head packs a tag with the page id so a page taken and given back between a load and the CAS (ABA) makes the CAS fail.
+*/
+class FAtomicPageAllocator
+{
+public:
+    static constexpr uint32_t InvalidPage = UINT32_MAX;
+
+    //Not thread safe, every page starts free
+    void Initialize(uint32_t PageNum_)
+    {
+        PageNum = PageNum_;
+        Next = std::make_unique<std::atomic<uint32_t>[]>(PageNum);
+        for (uint32_t Page = 0; Page < PageNum; Page++)
+        {
+            Next[Page].store(Page + 1 < PageNum ? Page + 1 : InvalidPage, std::memory_order_relaxed);
+        }
+        Head.store(Pack(0, PageNum > 0 ? 0 : InvalidPage));
+        FreeNum.store(PageNum);
+    }
+    //InvalidPage when everything is taken
+    uint32_t Allocate()
+    {
+        uint64_t OldHead = Head.load(std::memory_order_acquire);
+        while (true)
+        {
+            const uint32_t Page = GetPage(OldHead);
+            if (Page == InvalidPage)
+            {
+                return InvalidPage;
+            }
+            //Next may be stale if the page got taken meanwhile, the tag then fails the CAS
+            const uint64_t NewHead = Pack(GetTag(OldHead) + 1, Next[Page].load(std::memory_order_relaxed));
+            if (Head.compare_exchange_weak(OldHead, NewHead, std::memory_order_acq_rel, std::memory_order_acquire))
+            {
+                FreeNum.fetch_sub(1, std::memory_order_relaxed);
+                return Page;
+            }
+        }
+    }
+    void Free(uint32_t Page)
+    {
+        FreeNum.fetch_add(1, std::memory_order_relaxed);//Before the page shows up, so the count never drops below 0
+        uint64_t OldHead = Head.load(std::memory_order_relaxed);
+        do
+        {
+            Next[Page].store(GetPage(OldHead), std::memory_order_relaxed);
+        } while (!Head.compare_exchange_weak(OldHead, Pack(GetTag(OldHead) + 1, Page), std::memory_order_release, std::memory_order_relaxed));
+    }
+    uint32_t GetPageNum() const
+    {
+        return PageNum;
+    }
+    //A hint, other threads may take or give back pages right after
+    uint32_t GetFreeNum() const
+    {
+        return FreeNum.load(std::memory_order_relaxed);
+    }
+private:
+    std::unique_ptr<std::atomic<uint32_t>[]> Next;
+    std::atomic<uint64_t> Head = Pack(0, InvalidPage);
+    std::atomic<uint32_t> FreeNum = 0;
+    uint32_t PageNum = 0;
+
+    static constexpr uint64_t Pack(uint32_t Tag, uint32_t Page)
+    {
+        return ((uint64_t)Tag << 32) | Page;
+    }
+    static constexpr uint32_t GetTag(uint64_t Value)
+    {
+        return (uint32_t)(Value >> 32);
+    }
+    static constexpr uint32_t GetPage(uint64_t Value)
+    {
+        return (uint32_t)Value;
+    }
+};
@@ -0,0 +1,79 @@
+// Meso Engine 2024
+#pragma once
+#include <mutex>
+#include <utility>
+#include <vector>
+
+/*
+Double buffer queue that hands its items back once consumed. Producers Acquire an item (a recycled one when there is any), fill it and Push it,
+the consumer Swaps and Consumes, every consumed item is Reset and kept for the next Acquire.
+Items are moved around, never copied, so once the vectors (and the ones inside the items) have grown nothing is allocated. T needs Reset().
+*/
+template <typename T>
+class TRecyclingDoubleBufferQueue
+{
+private:
+    std::vector<T> Queues[2];
+    std::vector<T>* WriteQueue;
+    std::vector<T>* ReadQueue;
+    std::vector<T> FreeItems;
+    mutable std::mutex QueueMutex; // For push and swap
+    std::mutex FreeMutex;
+
+public:
+    TRecyclingDoubleBufferQueue() : WriteQueue(&Queues[0]), ReadQueue(&Queues[1])
+    {
+    }
+
+    T Acquire()
+    {
+        std::lock_guard<std::mutex> Lock(FreeMutex);
+        if (FreeItems.empty())
+        {
+            return T();
+        }
+        T Item = std::move(FreeItems.back());
+        FreeItems.pop_back();
+        return Item;
+    }
+    //For an acquired item that won't be pushed
+    void Recycle(T&& Item)
+    {
+        Item.Reset();
+        std::lock_guard<std::mutex> Lock(FreeMutex);
+        FreeItems.push_back(std::move(Item));
+    }
+    void Push(T&& Item)
+    {
+        std::lock_guard<std::mutex> Lock(QueueMutex);
+        WriteQueue->push_back(std::move(Item));
+    }
+
+    void Swap()
+    {
+        std::lock_guard<std::mutex> Lock(QueueMutex);
+        std::swap(WriteQueue, ReadQueue);
+    }
+
+    //Consumer only, Fn(T&) for every item in push order, then they are all recycled
+    template<typename FConsume>
+    void Consume(FConsume&& Fn)
+    {
+        for (T& Item : *ReadQueue)
+        {
+            Fn(Item);
+            Item.Reset();
+        }
+        std::lock_guard<std::mutex> Lock(FreeMutex);
+        for (T& Item : *ReadQueue)
+        {
+            FreeItems.push_back(std::move(Item));
+        }
+        ReadQueue->clear();
+    }
+
+    size_t Size() const
+    {
+        return ReadQueue->size();
+    }
+};
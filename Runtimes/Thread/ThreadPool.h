@@ -1,4 +1,5 @@
 // Meso Engine 2024
+#pragma once
 #include <boost/asio.hpp>
 #include <boost/thread/thread.hpp>
 #include <iostream>
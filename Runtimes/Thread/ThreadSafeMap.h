@@ -3,21 +3,52 @@
 #include <iostream>
 #include <map>
 #include <mutex>
+#include <shared_mutex>
+#include <vector>
 
+//Erased nodes are kept and reused by the inserts, a map whose keys come and go stops allocating once it has reached its size.
+//Reads share the lock, lookups from many threads only wait on a writer
 template<typename K, typename V, typename Comp = std::less<K>>
 class TThreadSafeMap 
 {
 private:
     using MapType = std::map<K, V, Comp>;
-    using LockType = std::lock_guard<std::mutex>;
+    using LockType = std::lock_guard<std::shared_mutex>;
+    using ReadLockType = std::shared_lock<std::shared_mutex>;
     MapType map_;
-    mutable std::mutex mutex_;
+    std::vector<typename MapType::node_type> free_nodes_;
+    mutable std::shared_mutex mutex_;
+
+    typename MapType::iterator assign_(const K& key, const V& value)
+    {
+        auto it = map_.lower_bound(key);
+        if (it != map_.end() && !map_.key_comp()(key, it->first))
+        {
+            it->second = value;
+            return it;
+        }
+        if (free_nodes_.empty())
+        {
+            return map_.emplace_hint(it, key, value);
+        }
+        auto node = std::move(free_nodes_.back());
+        free_nodes_.pop_back();
+        node.key() = key;
+        node.mapped() = value;
+        return map_.insert(it, std::move(node));
+    }
+    void erase_(typename MapType::iterator it)
+    {
+        auto node = map_.extract(it);
+        node.mapped() = V();//Don't keep what the value holds alive
+        free_nodes_.push_back(std::move(node));
+    }
 
 public:
     void ATOMIC_insert(const K& key, const V& value)
     {
         LockType lock(mutex_);
-        map_[key] = value;
+        assign_(key, value);
     }
 
     bool ATOMIC_not_contains_insert(const K& key, const V& value, V& original_value) //return true if not contains, then add. if contains, return false, and do nothing
@@ -27,7 +58,7 @@ public:
         bool contains = it != map_.end();
         if (!contains)
         {
-            map_[key] = value;
+            assign_(key, value);
             return true;
         }
         else
@@ -43,7 +74,7 @@ public:
 
     bool ATOMIC_get(const K& key, V& value) const
     {
-        LockType lock(mutex_);
+        ReadLockType lock(mutex_);
         auto it = map_.find(key);
         if (it != map_.end()) 
         {
@@ -59,7 +90,19 @@ public:
         auto it = map_.find(key);
         if (it != map_.end()) 
         {
-            map_.erase(it);
+            erase_(it);
+            return true;
+        }
+        return false;
+    }
+    bool ATOMIC_extract(const K& key, V& value) //Removes key and hands its value back
+    {
+        LockType lock(mutex_);
+        auto it = map_.find(key);
+        if (it != map_.end())
+        {
+            value = std::move(it->second);
+            erase_(it);
             return true;
         }
         return false;
@@ -85,11 +128,26 @@ public:
         auto it = map_.find(key);
         if (it != map_.end() && fn(it->second))
         {
-            map_.erase(it);
+            erase_(it);
             return true;
         }
         return false;
     }
+    //Takes in <bool>(V&), a missing key starts from V{}, the entry is removed when fn returns false
+    template<typename Functor>
+    void ATOMIC_update(const K& key, Functor fn)
+    {
+        LockType lock(mutex_);
+        auto it = map_.find(key);
+        if (it == map_.end())
+        {
+            it = assign_(key, V());
+        }
+        if (!fn(it->second))
+        {
+            erase_(it);
+        }
+    }
     template<typename Functor>
     bool ATOMIC_remove_insert_by_condition(const K& key, const K& key2, const V& value, Functor fn)
     {
@@ -99,14 +157,14 @@ public:
         {
             if (fn(it->second))
             {
-                map_.erase(it);
+                erase_(it);
             }
             else
             {
                 return false;
             }
         }
-        map_[key2] = value;
+        assign_(key2, value);
         return true;
     }
     bool ATOMIC_remove_and_insert(const K& key, const K& key2, const V& value)
@@ -115,23 +173,23 @@ public:
         auto it = map_.find(key);
         if (it != map_.end()) 
         {
-            map_.erase(it);
-            map_[key2] = value;
+            erase_(it);
+            assign_(key2, value);
             return true;
         }
-        map_[key2] = value;
+        assign_(key2, value);
         return false;
     }
 
     size_t ATOMIC_size() const
     {
-        LockType lock(mutex_);
+        ReadLockType lock(mutex_);
         return map_.size();
     }
 
     bool ATOMIC_contains(const K& key) const
     {
-        LockType lock(mutex_);
+        ReadLockType lock(mutex_);
         return map_.find(key) != map_.end();
     }
 
@@ -139,11 +197,12 @@ public:
     {
         LockType lock(mutex_);
         map_.clear();
+        free_nodes_.clear();
     }
 
     MapType ATOMIC_get_copy() const
     {
-        LockType lock(mutex_);
+        ReadLockType lock(mutex_);
         return map_;
     }
 };
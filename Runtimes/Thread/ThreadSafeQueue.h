@@ -1,55 +1,66 @@
 #include <mutex>
-#include <queue>
+#include <vector>
 
+//Vector backed, popped entries are dropped in bulk so a queue that keeps being drained stops allocating
 template<typename T>
-class TThreadSafeQueue 
+class TThreadSafeQueue
 {
 private:
-    std::queue<T> Queue;
+    std::vector<T> Queue;
+    size_t Head = 0;//Entries before it are popped
     std::mutex Lock;
 
 public:
     void AssertNotEmpty() const
     {
 #if not defined(NDEBUG)
-        assert(!Queue.empty() && "Index out of empty!");
+        assert(Head < Queue.size() && "Index out of empty!");
 #endif
     }
 
-    void Push(const T& Value) 
+    void Push(const T& Value)
     {
         std::lock_guard<std::mutex> Lock_(Lock);
-        Queue.push(Value);
+        Queue.push_back(Value);
     }
-    
-    void Push(T&& Value) 
+
+    void Push(T&& Value)
     {
         std::lock_guard<std::mutex> Lock_(Lock);
-        Queue.push(std::move(Value));
+        Queue.push_back(std::move(Value));
     }
 
-    bool Pop(T& OutValue) 
+    bool Pop(T& OutValue)
     {
         std::lock_guard<std::mutex> Lock_(Lock);
-        if (Queue.empty())
+        if (Head == Queue.size())
         {
             return false;
         }
-        OutValue = Queue.front();
-        Queue.pop();
+        OutValue = std::move(Queue[Head++]);
+        if (Head == Queue.size())
+        {
+            Queue.clear();
+            Head = 0;
+        }
+        else if (Head * 2 >= Queue.size())
+        {
+            Queue.erase(Queue.begin(), Queue.begin() + Head);
+            Head = 0;
+        }
         return true;
     }
 
     size_t Size()
     {
         std::lock_guard<std::mutex> Lock_(Lock);
-        return Queue.size();
+        return Queue.size() - Head;
     }
 
     T& Front()
     {
         std::lock_guard<std::mutex> Lock_(Lock);
         AssertNotEmpty();
-        return Queue.front();
+        return Queue[Head];
     }
 };
\ No newline at end of file
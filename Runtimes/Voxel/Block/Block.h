@@ -21,7 +21,7 @@ struct FBlock
 struct FGPUBlock
 {
 	uint32_t ChunkIndex = INT_MAX; //This refer to GPU chunk ssbo
-    u8vec4 BlockLocation = {255u,255u,255u,255u};
+    u8vec4 BlockLocation = {255u,255u,255u,255u}; //w: exposed faces, bit f for -X, +X, -Y, +Y, -Z, +Z (255 = all)
 	uint32_t BlockFrameStamp = 0;
 	//uint32_t VolumeIndex; //This refer to GPU Volume virtual index
 
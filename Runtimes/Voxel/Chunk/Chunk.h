@@ -12,6 +12,8 @@
 #include "Voxel/VoxelSceneConfig.h"
 #include "Voxel/Block/Block.h"
 #include "Voxel/Occupancy/BinaryOccupancyVolume.h"
+#include "Voxel/Occupancy/InteriorDepthVolume.h"
+#include "Voxel/Occupancy/OccupancyPyramid.h"
 #include "Helper/Comparator.h"
 
 #include <LVK.h>
@@ -24,10 +26,20 @@ using glm::ivec4;
 using glm::u8vec3;
 using glm::u8vec4;
 
+// Answer of a generator bounds query, Empty and Solid must be conservative (every voxel in the region agrees)
+enum class EGeneratorRegion : uint8_t
+{
+	Empty = 0,
+	Solid = 1,
+	Mixed = 2,
+};
+
 struct FGPUChunk
 {
 	ivec3 ChunkLocation = { INT_MAX, INT_MAX, INT_MAX };
 	uint32_t ChunkFrameStamp = 0;
+	uint32_t MipmapLevel = 0;
+	uint32_t Padding[3] = { 0, 0, 0 };//std430 array stride of ivec3 structs is 16 aligned
 
 	static std::string GetStructureShader()
 	{
@@ -37,6 +49,10 @@ struct GPUChunk
 {
 	ivec3 ChunkLocation;
 	uint ChunkFrameStamp;
+	uint MipmapLevel;
+	uint Padding0;
+	uint Padding1;
+	uint Padding2;
 };
 )";
 	}
@@ -44,21 +60,45 @@ struct GPUChunk
 struct FChunkBase 
 {
 public:
-	ivec3 ChunkLocation = { INT_MAX, INT_MAX, INT_MAX };
+	ivec3 ChunkLocation = { INT_MAX, INT_MAX, INT_MAX };//In level 0 chunk units, aligned to 2^MipmapLevel
 	uint32_t ChunkFrameStamp = 0;
+	uint32_t MipmapLevel = 0;//Covers 2^MipmapLevel level 0 chunks per axis
 public:
 	//FChunkBase() : ChunkLocation({ INT_MAX, INT_MAX, INT_MAX }) {}
 	bool bIsValid() const
 	{
 		return ChunkLocation != ivec3{ INT_MAX, INT_MAX, INT_MAX };
 	}
+	ivec4 GetChunkKey() const
+	{
+		return ivec4(ChunkLocation, (int32_t)MipmapLevel);
+	}
 };
 
+using FChunkOccupancyVolume = TBinaryOccupancyVolume<kChunkResolution>;
+using FChunkInteriorDepthVolume = TInteriorDepthVolume<kChunkResolution>;
+using FChunkOccupancyPyramid = TOccupancyPyramid<kChunkResolution>;
+using FChunkMortonOccupancyVolume = TMortonOccupancyVolume<kChunkResolution>;
+
+/*
+Chunk faces in -X, +X, -Y, +Y, -Z, +Z order, the neighbour across face f touches us with its face f ^ 1.
+A border slice is the solid bits of one face layer, bit u + v * Resolution with (u, v) the two other axes in X, Y, Z order.
+*/
+inline static constexpr uint32_t ChunkFaceNum = 6;
+inline static constexpr uint8_t ChunkAllFacesMask = (1u << ChunkFaceNum) - 1u;//Face f exposed is bit f
+using FChunkBorderSlice = std::array<uint64_t, (kChunkResolution * kChunkResolution + 63) / 64>;
+using FChunkBorderSlices = std::array<FChunkBorderSlice, ChunkFaceNum>;
+using FChunkNeighbourSlices = std::array<const FChunkBorderSlice*, ChunkFaceNum>;//Facing slice of each neighbour, nullptr when it isn't resident
+
 struct FChunk : public FChunkBase
 {
 	std::vector<FBlock> Blocks;
 	//std::set<ivec3, FIVec3Comparator> OccupancyVolume;
-	std::vector<FBinaryOccupancyVolume> OccupancyVolumeErodeMipmaps;
+	FChunkOccupancyVolume Occupancy;//Solid voxels
+	FChunkInteriorDepthVolume InteriorDepth;//Per voxel depth inside the chunk, answers every cull threshold
+	FChunkOccupancyPyramid OccupancyPyramid;//OR mips for skipping empty space in ray and sweep queries
+	FChunkBorderSlices BorderSlices = {};//Kept so resident neighbours can cull their border shells against us
+	std::map<uint32_t, uint32_t> SparseVolumeIndices;//Occupancy path only, linear voxel index -> VolumeIndex, voxels not in here use 0
 	
 	void AddBlock(const FBlock& NewBlock)
 	{
@@ -70,33 +110,221 @@ struct FChunk : public FChunkBase
 		//OccupancyVolume.insert(NewBlock.BlockLocation);
 		Blocks.push_back(std::move(NewBlock));
 	}
-	void CalculateOccupancyErodeMipmaps(const uint32_t Resolution = 16, const uint32_t MaxDepth = 4)
+	//Every solid voxel of the volume, in X, Y, Z order like the brute-force generators
+	void AddBlocksFromOccupancy(const FChunkOccupancyVolume& Occupancy_)
 	{
-		OccupancyVolumeErodeMipmaps.clear();
-		FBinaryOccupancyVolume Mip0(Resolution);
+		using uchar = unsigned char;
+		constexpr int32_t Resolution = (int32_t)FChunkOccupancyVolume::Resolution;
+		for (int32_t X = 0; X < Resolution; X++)
+		{
+			for (int32_t Y = 0; Y < Resolution; Y++)
+			{
+				for (int32_t Z = 0; Z < Resolution; Z++)
+				{
+					if (Occupancy_.Get({ X, Y, Z }))
+					{
+						AddBlock({ .ChunkIndex = 0, .BlockLocation = {(uchar)X,(uchar)Y,(uchar)Z}, .VolumeIndex = 0 });
+					}
+				}
+			}
+		}
+	}
+	//Block list path, occupancy and interior depth from Blocks
+	void CalculateOccupancyInteriorDepth()
+	{
+		Occupancy.Reset();
 		for (uint32_t i = 0; i < Blocks.size(); i++)
 		{
-			Mip0.Set(true, ivec3(Blocks[i].BlockLocation));
+			Occupancy.Set(true, ivec3(Blocks[i].BlockLocation));
 		}
-		OccupancyVolumeErodeMipmaps.push_back(std::move(Mip0));
-		for (uint32_t d = 1; d < MaxDepth; d++)
+		CalculateInteriorDepthFromOccupancy();
+	}
+
+	/*
+	Occupancy path, the generator writes the occupancy directly and never touches Blocks:
+	InitializeOccupancy -> write GetOccupancy() -> CalculateInteriorDepthFromOccupancy -> GatherSurfaceBlocks.
+	Blocks then only hold the voxels the block pool keeps, so don't call CalculateOccupancyInteriorDepth afterwards.
+	*/
+	FChunkOccupancyVolume& InitializeOccupancy()
+	{
+		Blocks.clear();
+		SparseVolumeIndices.clear();
+		Occupancy.Reset();
+		return Occupancy;
+	}
+	FChunkOccupancyVolume& GetOccupancy()
+	{
+		return Occupancy;
+	}
+	void CalculateInteriorDepthFromOccupancy()
+	{
+		InteriorDepth.Calculate(Occupancy);
+		OccupancyPyramid.Calculate(Occupancy);
+		CalculateBorderSlices();
+	}
+	void CalculateBorderSlices()
+	{
+		constexpr uint32_t Resolution = FChunkOccupancyVolume::Resolution;
+		for (FChunkBorderSlice& Slice : BorderSlices)
+		{
+			Slice.fill(0ull);
+		}
+		for (uint32_t Z = 0; Z < Resolution; Z++)
 		{
-			const FBinaryOccupancyVolume& LastMipmap = OccupancyVolumeErodeMipmaps.back();
-			FBinaryOccupancyVolume CurrentMip(Resolution);
-			for (uint32_t i = 0; i < Blocks.size(); i++)
+			for (uint32_t Y = 0; Y < Resolution; Y++)
 			{
-				const ivec3& CurrentLocation = ivec3(Blocks[i].BlockLocation);
-				FBinaryOccupancyVolume::FOccupancyValue Solid = FOccupancyHelper::ErodeSingleVoxel(LastMipmap, CurrentLocation);
-				CurrentMip.Set(Solid, CurrentLocation);
+				//X faces take one bit of every row, Y and Z faces take whole rows
+				const uint64_t Row = Occupancy.GetRow(Y + Z * Resolution);
+				SetSliceBit(BorderSlices[0], Y + Z * Resolution, Row & 1ull);
+				SetSliceBit(BorderSlices[1], Y + Z * Resolution, (Row >> (Resolution - 1)) & 1ull);
+				if (Y == 0 || Y == Resolution - 1)
+				{
+					SetSliceRow(BorderSlices[Y == 0 ? 2 : 3], Z, Row);
+				}
+				if (Z == 0 || Z == Resolution - 1)
+				{
+					SetSliceRow(BorderSlices[Z == 0 ? 4 : 5], Y, Row);
+				}
 			}
-			OccupancyVolumeErodeMipmaps.push_back(std::move(CurrentMip));
 		}
 	}
+	static bool bIsBorderVoxel(u8vec3 BlockLocation)
+	{
+		constexpr uint32_t Last = FChunkOccupancyVolume::Resolution - 1;
+		return BlockLocation.x == 0 || BlockLocation.y == 0 || BlockLocation.z == 0 || BlockLocation.x == Last || BlockLocation.y == Last || BlockLocation.z == Last;
+	}
+	static bool GetSliceBit(const FChunkBorderSlice& Slice, uint32_t Bit)
+	{
+		return (Slice[Bit >> 6] >> (Bit & 63)) & 1ull;
+	}
+	static uint64_t GetSliceRow(const FChunkBorderSlice& Slice, uint32_t RowIndex)
+	{
+		const uint32_t Bit = RowIndex * FChunkOccupancyVolume::Resolution;
+		return (Slice[Bit >> 6] >> (Bit & 63)) & FChunkOccupancyVolume::RowMask;
+	}
+	//Exposed faces of row (Y, Z), neighbours across the chunk faces come from the slices, a missing neighbour is empty
+	std::array<uint64_t, ChunkFaceNum> GetExposedFaceRows(uint32_t Y, uint32_t Z, const FChunkNeighbourSlices& NeighbourSlices) const
+	{
+		constexpr uint32_t Resolution = FChunkOccupancyVolume::Resolution;
+		auto GetOutsideRow = [&NeighbourSlices](uint32_t Face, uint32_t RowIndex)
+			{
+				return NeighbourSlices[Face] ? GetSliceRow(*NeighbourSlices[Face], RowIndex) : 0ull;
+			};
+		const uint32_t Row = Y + Z * Resolution;
+		return FOccupancyHelper::GetExposedFaceRows(Occupancy.GetRow(Row),
+			NeighbourSlices[0] ? (uint64_t)GetSliceBit(*NeighbourSlices[0], Row) : 0ull,
+			NeighbourSlices[1] ? (uint64_t)GetSliceBit(*NeighbourSlices[1], Row) : 0ull,
+			Y > 0 ? Occupancy.GetRow(Row - 1) : GetOutsideRow(2, Z),
+			Y + 1 < Resolution ? Occupancy.GetRow(Row + 1) : GetOutsideRow(3, Z),
+			Z > 0 ? Occupancy.GetRow(Row - Resolution) : GetOutsideRow(4, Y),
+			Z + 1 < Resolution ? Occupancy.GetRow(Row + Resolution) : GetOutsideRow(5, Y),
+			Resolution);
+	}
+	static uint8_t GetFaceMask(const std::array<uint64_t, ChunkFaceNum>& ExposedRows, uint32_t X)
+	{
+		uint8_t FaceMask = 0;
+		for (uint32_t Face = 0; Face < ChunkFaceNum; Face++)
+		{
+			FaceMask |= (uint8_t)(((ExposedRows[Face] >> X) & 1ull) << Face);
+		}
+		return FaceMask;
+	}
+	uint8_t GetFaceMask(u8vec3 BlockLocation, const FChunkNeighbourSlices& NeighbourSlices) const
+	{
+		return GetFaceMask(GetExposedFaceRows(BlockLocation.y, BlockLocation.z, NeighbourSlices), BlockLocation.x);
+	}
+	//Face mask of every block, blocks sharing a row (the occupancy path gathers them row by row) reuse its exposed rows
+	void CalculateFaceMasks(const FChunkNeighbourSlices& NeighbourSlices, std::vector<uint8_t>& FaceMasks) const
+	{
+		FaceMasks.resize(Blocks.size());
+		std::array<uint64_t, ChunkFaceNum> ExposedRows = {};
+		uint32_t CachedRow = UINT_MAX;
+		for (size_t i = 0; i < Blocks.size(); i++)
+		{
+			const u8vec3 BlockLocation = Blocks[i].BlockLocation;
+			const uint32_t Row = BlockLocation.y + BlockLocation.z * FChunkOccupancyVolume::Resolution;
+			if (Row != CachedRow)
+			{
+				ExposedRows = GetExposedFaceRows(BlockLocation.y, BlockLocation.z, NeighbourSlices);
+				CachedRow = Row;
+			}
+			FaceMasks[i] = GetFaceMask(ExposedRows, BlockLocation.x);
+		}
+	}
+	//Border voxel hidden by its neighbours, no exposed face once the resident neighbours are taken into account
+	bool bShouldBorderVoxelCull(u8vec3 BlockLocation, const FChunkNeighbourSlices& NeighbourSlices) const
+	{
+		return GetFaceMask(BlockLocation, NeighbourSlices) == 0;
+	}
+	//Derive Blocks from the occupancy, skipping the voxels bShouldVoxelOccupancyCull would drop at ThresholdDepth. Deeper thresholds need this to be as deep
+	//bMortonOrder emits them in Z-order, so blocks next to each other in the chunk stay close in the block list and the block pool
+	void GatherSurfaceBlocks(const uint32_t ThresholdDepth = 1, const bool bMortonOrder = false)
+	{
+		using uchar = unsigned char;
+		Blocks.clear();
+		auto GatherVoxel = [&](uint32_t i)
+			{
+				if (InteriorDepth.GetDepth(i) > ThresholdDepth)
+				{
+					return;
+				}
+				const ivec3 BlockLocation = FChunkOccupancyVolume::GetLocation(i);
+				auto VolumeIndex = SparseVolumeIndices.find(i);
+				AddBlock(
+					{
+						.ChunkIndex = 0,
+						.BlockLocation = {(uchar)BlockLocation.x,(uchar)BlockLocation.y,(uchar)BlockLocation.z},
+						.VolumeIndex = VolumeIndex == SparseVolumeIndices.end() ? 0u : VolumeIndex->second,
+					}
+				);
+			};
+		if (bMortonOrder)
+		{
+			FChunkMortonOccupancyVolume MortonOccupancy;
+			MortonOccupancy.FromLinear(Occupancy);
+			MortonOccupancy.ForEachSet([&](uint32_t MortonIndex)
+				{
+					GatherVoxel(FChunkOccupancyVolume::GetIndex(FChunkMortonOccupancyVolume::GetLocation(MortonIndex)));
+				});
+			return;
+		}
+		Occupancy.ForEachSet(GatherVoxel);
+	}
+	//Rough size of the chunk (blocks, occupancy, depth, pyramid, border slices and sparse attributes)
+	size_t GetMemorySize() const
+	{
+		size_t Size = Blocks.capacity() * sizeof(FBlock) + sizeof(FChunkOccupancyVolume) + sizeof(FChunkInteriorDepthVolume) + sizeof(FChunkOccupancyPyramid) + sizeof(FChunkBorderSlices);
+		return Size + SparseVolumeIndices.size() * (sizeof(std::pair<const uint32_t, uint32_t>) + 3 * sizeof(void*));
+	}
+	//Deeper than ThresholdDepth inside the chunk, what mip ThresholdDepth of the erode chain used to answer
+	bool bShouldVoxelOccupancyCull(u8vec3 BlockLocation, uint32_t ThresholdDepth = 2) const
+	{
+		return InteriorDepth.GetDepth(FChunkOccupancyVolume::GetIndex(BlockLocation.x, BlockLocation.y, BlockLocation.z)) > ThresholdDepth;
+	}
+
+private:
+	static void SetSliceBit(FChunkBorderSlice& Slice, uint32_t Bit, uint64_t Value)
+	{
+		Slice[Bit >> 6] |= Value << (Bit & 63);
+	}
+	static void SetSliceRow(FChunkBorderSlice& Slice, uint32_t RowIndex, uint64_t Row)
+	{
+		const uint32_t Bit = RowIndex * FChunkOccupancyVolume::Resolution;
+		Slice[Bit >> 6] |= (Row & FChunkOccupancyVolume::RowMask) << (Bit & 63);
+	}
+};
+
+//Immutable copy of what spatial queries and neighbours read, shared between the owning pool thread and everyone else
+struct FChunkQueryData
+{
+	ivec4 ChunkKey = { INT_MAX, INT_MAX, INT_MAX, 0 };
+	FChunkOccupancyVolume Occupancy;
+	FChunkOccupancyPyramid OccupancyPyramid;
+	FChunkBorderSlices BorderSlices = {};
 
-	bool bShouldVoxelOccupancyCull(ivec3 BlockLocation, uint32_t ThresholdDepth = 2) const
+	static FChunkQueryData FromChunk(const FChunk& Chunk)
 	{
-		const FBinaryOccupancyVolume& CurrentOccupancyMipmap = OccupancyVolumeErodeMipmaps[ThresholdDepth];
-		return CurrentOccupancyMipmap.GetWithBoundaryCondition(BlockLocation, true);
+		return { .ChunkKey = Chunk.GetChunkKey(), .Occupancy = Chunk.Occupancy, .OccupancyPyramid = Chunk.OccupancyPyramid, .BorderSlices = Chunk.BorderSlices };
 	}
 };
 
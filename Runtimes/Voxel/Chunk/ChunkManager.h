@@ -23,6 +23,7 @@
 #include "ChunkManagerHelper.h"
 #include "Chunk.h"
 #include "ChunkPool.h"
+#include "Voxel/Spatial/VoxelQueryService.h"
 using glm::ivec3;
 using glm::ivec4;
 using glm::vec3;
@@ -44,6 +45,9 @@ class FChunkManage
 	double DebugAllMultiThreadGenerationTime = 0.0;
 	uint32_t DebugAllMultiThreadGeneratedChunkNum = 0;
 
+	std::atomic<uint32_t> DebugClassifiedEmptyChunkNum = 0;
+	std::atomic<uint32_t> DebugClassifiedSolidChunkNum = 0;
+
 	inline static std::string DebugMarkFindAllVisibleChunkTime = "FindAllVisibleChunkTime";
 	inline static std::string DebugMarkGatherAllChunkTime = "GatherAllChunkTime";
 	inline static std::string DebugMarkSumitRenderingDebugChunkTime = "SumitRenderingDebugChunkTime";
@@ -57,6 +61,7 @@ class FChunkManage
 	/* 
 	Generator, takes in start location, block size, chunk resolution, uint32_t mipmap_level; 
 	Start location lays in the most [left down back] voxel's most [left down back]'s vertex location
+	At mipmap level N the start location is in level N chunk units and block size is already BlockSize * 2^N, so generators sample the coarser grid as is
 	*/
 	using GeneratorType = std::function<FChunk(ivec3, float, unsigned char, uint32_t)>;
 	GeneratorType Generator;
@@ -64,10 +69,29 @@ class FChunkManage
 	{
 		Generator = std::move(Generator_);
 	}
+	/*
+	Occupancy generator, same arguments as the generator after a cleared ChunkResolution^3 volume to write solid voxels into.
+	Skips the per voxel block list, only the surface blocks are derived afterwards. Used instead of Generator when set.
+	*/
+	using OccupancyGeneratorType = std::function<void(FChunkOccupancyVolume&, ivec3, float, unsigned char, uint32_t)>;
+	OccupancyGeneratorType OccupancyGenerator;
+	void SetOccupancyGenerator(OccupancyGeneratorType OccupancyGenerator_)
+	{
+		OccupancyGenerator = std::move(OccupancyGenerator_);
+	}
+	/*
+	Optional bounds query of the generator, same arguments as the generator.
+	Empty or solid chunks are pushed without running the generator.
+	*/
+	using RegionClassifierType = std::function<EGeneratorRegion(ivec3, float, unsigned char, uint32_t)>;
+	RegionClassifierType RegionClassifier;
+	FChunk SolidChunkTemplate;//Every voxel set, occupancy mipmaps included, surface blocks only
 
 	TNearestMap<FChunkManageHelper::FImportanceChunkQueue> BakedVisibility;
 public:
 	ThreadPool GeneratorThreadPool;
+	ThreadPool QueryThreadPool;
+	FVoxelQueryService QueryService;
 	//Pool
 	FChunkPool ChunkPool;
 	//Queue
@@ -93,9 +117,17 @@ public:
 		BufferedFramesNum = BufferedFramesNum_;
 
 		GeneratorThreadPool.Initialize(ThreadCount);// leave some cores for youtube
+		if (VoxelSceneConfig.QueryThreadCount > 0)
+		{
+			QueryThreadPool.Initialize(VoxelSceneConfig.QueryThreadCount);
+		}
 		ChunkPool.Initialize(LVKContext, VoxelSceneConfig, ThreadCount, bDebugReverseZ, BufferedFramesNum);
 		//
 		SetGenerator(std::move(Generator_));
+		SolidChunkTemplate = FChunk();
+		SolidChunkTemplate.InitializeOccupancy().Fill();
+		SolidChunkTemplate.CalculateInteriorDepthFromOccupancy();
+		SolidChunkTemplate.GatherSurfaceBlocks(VoxelSceneConfig.ChunkMaxCullDepthThreshold, VoxelSceneConfig.bMortonBlockOrder);
 		//Bake visibility
 		BakeVisibilityViewNum = VoxelSceneConfig.BakeVisibilityViewNum;
 		BakedVisibility = FChunkManageHelper::BakeVisibilityByView(VoxelSceneConfig, BakeVisibilityViewNum);
@@ -143,7 +175,7 @@ public:
 		{
 			return;
 		}
-		if (!Generator)
+		if (!Generator && !OccupancyGenerator)
 		{
 			//Warning
 			printf("UpdateChunks: Generator is empty.\n");
@@ -157,21 +189,73 @@ public:
 		std::queue<ivec3>().swap(RestDesiredToLoadChunkLocations);
 		ChunkPool.IncreaseFrameStamp();
 	}
-	void MultiThreadGenerator(const ivec3 CurrentDesiredChunkLocation, const uint32_t MipmapLevel, const FImportanceComputeInfo& CameraInfo, const FVoxelSceneConfig& VoxelSceneConfig)
+	void SetRegionClassifier(RegionClassifierType RegionClassifier_)
 	{
-		const uint32_t ThreadId = GeneratorThreadPool.GetCurrentThreadID();
-		if (ThreadId > GeneratorThreadPool.GetSize())
+		RegionClassifier = std::move(RegionClassifier_);
+	}
+	// First solid block along the ray over the resident chunks, LocalOrigin is in world units from OriginChunk's corner. Safe from any thread
+	FRayCastHit RayCast(const ivec3 OriginChunk, const vec3 LocalOrigin, const vec3 Direction, const float MaxDistance, const FVoxelSceneConfig& VoxelSceneConfig) const
+	{
+		return ::RayCast([&](ivec3 ChunkLocation) { return ChunkPool.FindRayChunk(ChunkLocation, VoxelSceneConfig.MaxChunkMipmapLevel); },
+			OriginChunk, LocalOrigin, Direction, MaxDistance, VoxelSceneConfig.BlockSize);
+	}
+	// Swept boxes against the resident chunks, Hits is only resized when it is too small so a reused vector doesn't allocate. Safe from any thread
+	void SweepBoxes(const std::vector<FBoxSweep>& Sweeps, std::vector<FSweepHit>& Hits, const FVoxelSceneConfig& VoxelSceneConfig) const
+	{
+		if (Hits.size() < Sweeps.size())
 		{
-			printf("Unknown thread id %d, max %d\n", ThreadId, GeneratorThreadPool.GetSize());
+			Hits.resize(Sweeps.size());
+		}
+		auto FindChunk = [&](ivec3 ChunkLocation) { return ChunkPool.FindRayChunk(ChunkLocation, VoxelSceneConfig.MaxChunkMipmapLevel); };
+		FChunkLookupCache Cache;//Agents are close to each other, the whole batch shares the lookups
+		for (size_t i = 0; i < Sweeps.size(); i++)
+		{
+			Hits[i] = SweepBox(FindChunk, Cache, Sweeps[i], VoxelSceneConfig.BlockSize);
+		}
+	}
+	// Batch of rays, sweeps and overlaps in parallel, Results[i] answers Queries[i]. One batch at a time.
+	// Without query threads it borrows up to QueryBorrowedThreadCount free generator threads, generation slows down while the batch runs
+	void RunQueries(std::span<const FVoxelQuery> Queries, std::span<FVoxelQueryResult> Results, const FVoxelSceneConfig& VoxelSceneConfig)
+	{
+		const bool bOwnThreads = QueryThreadPool.GetSize() > 0;
+		QueryService.Run([&](ivec3 ChunkLocation) { return ChunkPool.FindRayChunk(ChunkLocation, VoxelSceneConfig.MaxChunkMipmapLevel); },
+			Queries, Results, VoxelSceneConfig.BlockSize, bOwnThreads ? &QueryThreadPool : &GeneratorThreadPool, bOwnThreads ? SIZE_MAX : VoxelSceneConfig.QueryBorrowedThreadCount);
+	}
+	// CurrentDesiredChunkLocation is in level 0 chunk units, aligned to 2^MipmapLevel
+	void GenerateAndPushChunk(const ivec3 CurrentDesiredChunkLocation, const uint32_t MipmapLevel, const uint32_t ThreadId, const FImportanceComputeInfo& CameraInfo, const FVoxelSceneConfig& VoxelSceneConfig)
+	{
+		const ivec3 LevelChunkLocation = ivec3(CurrentDesiredChunkLocation.x >> MipmapLevel, CurrentDesiredChunkLocation.y >> MipmapLevel, CurrentDesiredChunkLocation.z >> MipmapLevel);
+		const float LevelBlockSize = VoxelSceneConfig.BlockSize * (float)(1u << MipmapLevel);
+		const EGeneratorRegion Region = RegionClassifier ? RegionClassifier(LevelChunkLocation, LevelBlockSize, VoxelSceneConfig.ChunkResolution, MipmapLevel) : EGeneratorRegion::Mixed;
+		FChunk NewChunk;
+		if (Region == EGeneratorRegion::Solid)
+		{
+			NewChunk = SolidChunkTemplate;
+			DebugClassifiedSolidChunkNum++;
+		}
+		else if (Region == EGeneratorRegion::Mixed && OccupancyGenerator)
+		{
+			OccupancyGenerator(NewChunk.InitializeOccupancy(), LevelChunkLocation, LevelBlockSize, VoxelSceneConfig.ChunkResolution, MipmapLevel);
+			NewChunk.CalculateInteriorDepthFromOccupancy();
+			NewChunk.GatherSurfaceBlocks(VoxelSceneConfig.ChunkMaxCullDepthThreshold, VoxelSceneConfig.bMortonBlockOrder);
+		}
+		else if (Region == EGeneratorRegion::Mixed)
+		{
+			NewChunk = Generator(LevelChunkLocation, LevelBlockSize, VoxelSceneConfig.ChunkResolution, MipmapLevel);
+			NewChunk.CalculateOccupancyInteriorDepth();//Calculate inner properties
+		}
+		else
+		{
+			DebugClassifiedEmptyChunkNum++;
 		}
-		FChunk NewChunk = Generator(CurrentDesiredChunkLocation, VoxelSceneConfig.BlockSize, VoxelSceneConfig.ChunkResolution, MipmapLevel);
 		NewChunk.ChunkLocation = CurrentDesiredChunkLocation;// just make sure
-		NewChunk.CalculateOccupancyErodeMipmaps(VoxelSceneConfig.ChunkResolution, VoxelSceneConfig.ChunkOccupancyDepth);//Calculate inner properties
+		NewChunk.MipmapLevel = MipmapLevel;
 		bool bChunkEmpty = NewChunk.Blocks.size() <= 0;
 		if (bChunkEmpty) //Empty
 		{
 			FEmptyChunk NewEmptyChunk;
 			NewEmptyChunk.ChunkLocation = CurrentDesiredChunkLocation;//Just ensure
+			NewEmptyChunk.MipmapLevel = MipmapLevel;
 
 			ChunkPool.PushEmptyChunk(std::move(NewEmptyChunk), ThreadId, ChunkPool.GetFrameStamp(), VoxelSceneConfig.ChunkResolution, CameraInfo, VoxelSceneConfig.GetChunkSize(), VoxelSceneConfig.ChunkOverrideMode);
 		}
@@ -180,6 +264,15 @@ public:
 			ChunkPool.PushChunk(std::move(NewChunk), ThreadId, ChunkPool.GetFrameStamp(), VoxelSceneConfig.ChunkResolution, CameraInfo, VoxelSceneConfig.GetChunkSize(), VoxelSceneConfig.ChunkOverrideMode);
 		}
 	}
+	void MultiThreadGenerator(const ivec3 CurrentDesiredChunkLocation, const uint32_t MipmapLevel, const FImportanceComputeInfo& CameraInfo, const FVoxelSceneConfig& VoxelSceneConfig)
+	{
+		const uint32_t ThreadId = GeneratorThreadPool.GetCurrentThreadID();
+		if (ThreadId > GeneratorThreadPool.GetSize())
+		{
+			printf("Unknown thread id %d, max %d\n", ThreadId, GeneratorThreadPool.GetSize());
+		}
+		GenerateAndPushChunk(CurrentDesiredChunkLocation, MipmapLevel, ThreadId, CameraInfo, VoxelSceneConfig);
+	}
 	void MultiThreadGeneratorBatched(const std::vector<ivec3> CurrentDesiredChunkLocations, const std::vector<uint32_t> MipmapLevels, const FImportanceComputeInfo& CameraInfo, const FVoxelSceneConfig& VoxelSceneConfig)
 	{
 		const uint32_t ThreadId = GeneratorThreadPool.GetCurrentThreadID();
@@ -189,23 +282,7 @@ public:
 		}
 		for (uint32_t i=0;i< CurrentDesiredChunkLocations.size();i++)
 		{
-			const ivec3 CurrentDesiredChunkLocation = CurrentDesiredChunkLocations[i];
-			const uint32_t MipmapLevel = MipmapLevels[i];
-			FChunk NewChunk = Generator(CurrentDesiredChunkLocation, VoxelSceneConfig.BlockSize, VoxelSceneConfig.ChunkResolution, MipmapLevel);
-			NewChunk.ChunkLocation = CurrentDesiredChunkLocation;// just make sure
-			NewChunk.CalculateOccupancyErodeMipmaps(VoxelSceneConfig.ChunkResolution, VoxelSceneConfig.ChunkOccupancyDepth);//Calculate inner properties
-			bool bChunkEmpty = NewChunk.Blocks.size() <= 0;
-			if (bChunkEmpty) //Empty
-			{
-				FEmptyChunk NewEmptyChunk;
-				NewEmptyChunk.ChunkLocation = CurrentDesiredChunkLocation;//Just ensure
-
-				ChunkPool.PushEmptyChunk(std::move(NewEmptyChunk), ThreadId, ChunkPool.GetFrameStamp(), VoxelSceneConfig.ChunkResolution, CameraInfo, VoxelSceneConfig.GetChunkSize(), VoxelSceneConfig.ChunkOverrideMode);
-			}
-			else
-			{
-				ChunkPool.PushChunk(std::move(NewChunk), ThreadId, ChunkPool.GetFrameStamp(), VoxelSceneConfig.ChunkResolution, CameraInfo, VoxelSceneConfig.GetChunkSize(), VoxelSceneConfig.ChunkOverrideMode);
-			}
+			GenerateAndPushChunk(CurrentDesiredChunkLocations[i], MipmapLevels[i], ThreadId, CameraInfo, VoxelSceneConfig);
 		}
 	}
 	void UpdateLoadingQueue(lvk::IContext* LVKContext, ivec3 CameraChunkLocation, vec3 CameraForwardVector, const FVoxelSceneConfig& VoxelSceneConfig, uint32_t RenderFrameIndex_)
@@ -223,16 +300,20 @@ public:
 		FImportanceComputeInfo CameraInfo = 
 		{ 
 			.CameraChunk = CameraChunkLocation , 
-			.CameraForwardVector = CameraForwardVector 
+			.CameraForwardVector = CameraForwardVector,
+			.MaxChunkMipmapLevel = VoxelSceneConfig.MaxChunkMipmapLevel,
+			.LodDistance = VoxelSceneConfig.LodDistance,
 		};
 		if (VoxelSceneConfig.ChunkTaskPerCore <= 1)
 		{
 			for (uint32_t i = 0; i < TotalNum; i++)
 			{
 				ivec3 CurrentDesiredChunkLocation = DesiredToLoadChunkLocations.top().second + CameraChunkLocation;
-				uint32_t MipmapLevel = 0;
+				const uint32_t MipmapLevel = CameraInfo.CalculateChunkMipmapLevel(CurrentDesiredChunkLocation);
+				CurrentDesiredChunkLocation = FImportanceComputeInfo::AlignChunkLocation(CurrentDesiredChunkLocation, MipmapLevel);//Many desired locations share one coarse chunk
+				const ivec4 CurrentDesiredChunkKey = ivec4(CurrentDesiredChunkLocation, (int32_t)MipmapLevel);
 				EChunkState OldState = EChunkState::Computing;
-				if (ChunkPool.ChunksLookupTable.ATOMIC_not_contains_insert(CurrentDesiredChunkLocation, EChunkState::Computing, OldState)) //Not found
+				if (ChunkPool.ChunksLookupTable.ATOMIC_not_contains_insert(CurrentDesiredChunkKey, EChunkState::Computing, OldState)) //Not found
 				{
 					if (CurrentSyncedChunkCount >= VoxelSceneConfig.MaxSyncedLoadChunkCount && CurrentMultiThreadChunkCount >= VoxelSceneConfig.MaxUnsyncedLoadChunkCount)//If reach limit
 					{
@@ -269,7 +350,7 @@ public:
 					}
 				FailedToDispatch:
 					{
-						ChunkPool.ChunksLookupTable.ATOMIC_remove(CurrentDesiredChunkLocation);// Modify back
+						ChunkPool.ChunksLookupTable.ATOMIC_remove(CurrentDesiredChunkKey);// Modify back
 						break;
 					}
 				}
@@ -288,10 +369,11 @@ public:
 			{
 				const bool bIsResetChunk = RestDesiredToLoadChunkLocations.size() > 0;
 				ivec3 CurrentDesiredChunkLocation = bIsResetChunk ? RestDesiredToLoadChunkLocations.front() : (DesiredToLoadChunkLocations.top().second + CameraChunkLocation);
-				uint32_t MipmapLevel = 0;
+				const uint32_t MipmapLevel = CameraInfo.CalculateChunkMipmapLevel(CurrentDesiredChunkLocation);
+				CurrentDesiredChunkLocation = FImportanceComputeInfo::AlignChunkLocation(CurrentDesiredChunkLocation, MipmapLevel);
 				EChunkState OldState = EChunkState::Computing;
 
-				if (ChunkPool.ChunksLookupTable.ATOMIC_not_contains_insert(CurrentDesiredChunkLocation, EChunkState::Computing, OldState)) //Not found
+				if (ChunkPool.ChunksLookupTable.ATOMIC_not_contains_insert(ivec4(CurrentDesiredChunkLocation, (int32_t)MipmapLevel), EChunkState::Computing, OldState)) //Not found
 				{
 					BatchedChunkLocations.push_back(CurrentDesiredChunkLocation);
 					BatchedMipmapLevels.push_back(MipmapLevel);
@@ -363,10 +445,10 @@ public:
 							DesiredToLoadChunkLocations.pop();
 						}
 						//ChunkPool.ChunksLookupTable.ATOMIC_remove(CurrentDesiredChunkLocation);// Modify back
-						for (auto CurrentLoadedDesiredChunkLocation : BatchedChunkLocations)
+						for (uint32_t j = 0; j < BatchedChunkLocations.size(); j++)
 						{
-							RestDesiredToLoadChunkLocations.push(CurrentLoadedDesiredChunkLocation);
-							ChunkPool.ChunksLookupTable.ATOMIC_remove(CurrentLoadedDesiredChunkLocation);
+							RestDesiredToLoadChunkLocations.push(BatchedChunkLocations[j]);
+							ChunkPool.ChunksLookupTable.ATOMIC_remove(ivec4(BatchedChunkLocations[j], (int32_t)BatchedMipmapLevels[j]));
 						}
 						break;
 					}
@@ -394,6 +476,8 @@ public:
 			DebugNewVisibleChunkNum = CurrentTotallyAddedChunkNum;
 			//printf("Chunk %d Loaded\n", CurrentTotallyAddedChunkNum);
 		}
+		//Evictions and re-culls of the threads left without work
+		ChunkPool.ProcessIdleChunkSlotRequests(CameraInfo, VoxelSceneConfig.ChunkResolution);
 		//Visualize
 		//For Debug
 		ChunkPool.UpdateDebugVisibleChunk(LVKContext, VoxelSceneConfig, RenderFrameIndex);
@@ -480,6 +564,10 @@ public:
 		ImGui::SameLine(Offset);
 		ImGui::Text("%d", ChunkPool.CurrentBlockCount);
 
+		ImGui::Text("Free Block Page:");
+		ImGui::SameLine(Offset);
+		ImGui::Text("%u / %u", ChunkPool.BlockPagePool.Allocator.GetFreeNum(), ChunkPool.BlockPagePool.Allocator.GetPageNum());
+
 		ImGui::Text("Newly Added Visible Chunk:");
 		ImGui::SameLine(Offset);
 		ImGui::Text("%d", DebugNewVisibleChunkNum);
@@ -488,6 +576,10 @@ public:
 		ImGui::SameLine(Offset);
 		ImGui::Text("%d", DebugMaxSyncedLoadChunkNum);
 
+		ImGui::Text("Classified Empty/Solid Chunk:");
+		ImGui::SameLine(Offset);
+		ImGui::Text("%d / %d", DebugClassifiedEmptyChunkNum.load(), DebugClassifiedSolidChunkNum.load());
+
 		ImGui::Separator();
 		ImGui::Text("Computation Time:");
 
@@ -526,6 +618,10 @@ public:
 		ImGui::SameLine(Offset);
 		ImGui::Text("%.4lf ms", UploadBlockTime * 1000.0);
 
+		ImGui::Text("Debug Upload Size:");
+		ImGui::SameLine(Offset);
+		ImGui::Text("%.1lf KB", ChunkPool.LastUploadBytes / 1024.0);
+
 		double GatherAllChunkTime = DebugTimerSet.GetAverage(DebugMarkGatherAllChunkTime);
 		ImGui::Text("Gather All Chunk Time:");
 		ImGui::SameLine(Offset);
@@ -536,6 +632,15 @@ public:
 		ImGui::SameLine(Offset);
 		ImGui::Text("%.4lf ms", SumitRenderingDebugChunkTime * 1000.0);
 
+		const FVoxelQueryService::FStats& QueryStats = QueryService.GetStats();
+		ImGui::Text("Spatial Queries Per Second:");
+		ImGui::SameLine(Offset);
+		ImGui::Text("%.0lf", QueryStats.GetQueriesPerSecond());
+
+		ImGui::Text("Spatial Query Batch Time (Last/Max):");
+		ImGui::SameLine(Offset);
+		ImGui::Text("%.4lf / %.4lf ms", QueryStats.LastBatchSeconds * 1000.0, QueryStats.MaxBatchSeconds * 1000.0);
+
 		ImGui::End();
 		ImGui::PopStyleColor();
 	}
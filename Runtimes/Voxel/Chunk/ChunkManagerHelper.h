@@ -13,6 +13,7 @@
 #include "Voxel/VoxelSceneConfig.h"
 #include "Voxel/Spatial/NearestMap.h"
 #include "Helper/VoxelMathHelper.h"
+#include "Helper/Timer.h"
 using glm::ivec3;
 using glm::vec3;
 using glm::ivec4;
@@ -22,35 +23,86 @@ struct FImportanceComputeInfo
 {
 	ivec3 CameraChunk = { 0,0,0 };
 	vec3 CameraForwardVector = {};
+	//LOD
+	uint32_t MaxChunkMipmapLevel = 0;
+	float LodDistance = 8.0f;
 
-	inline static float CalculateChunkImportance(const FImportanceComputeInfo& CameraInfo, ivec3 ChunkLocation)
+	bool operator==(const FImportanceComputeInfo&) const = default;
+
+	// Level 0 chunk location -> location of the level N chunk holding it (floor to 2^N)
+	inline static ivec3 AlignChunkLocation(ivec3 ChunkLocation, uint32_t MipmapLevel)
+	{
+		return ivec3((ChunkLocation.x >> MipmapLevel) << MipmapLevel, (ChunkLocation.y >> MipmapLevel) << MipmapLevel, (ChunkLocation.z >> MipmapLevel) << MipmapLevel);
+	}
+	// Highest level whose chunk holding ChunkLocation is far enough from the camera.
+	// Every level 0 chunk inside a level N chunk tests the same nested chunks, so they all agree and picked chunks never overlap.
+	inline static uint32_t CalculateChunkMipmapLevel(const FImportanceComputeInfo& CameraInfo, ivec3 ChunkLocation)
+	{
+		for (uint32_t Level = CameraInfo.MaxChunkMipmapLevel; Level > 0; Level--)
+		{
+			const float LevelScale = (float)(1u << Level);
+			const vec3 CenterOffset = vec3(AlignChunkLocation(ChunkLocation, Level) - CameraInfo.CameraChunk) + (LevelScale - 1.0f) * 0.5f;
+			if (length(CenterOffset) >= CameraInfo.LodDistance * LevelScale * 0.5f)
+			{
+				return Level;
+			}
+		}
+		return 0;
+	}
+	inline uint32_t CalculateChunkMipmapLevel(ivec3 ChunkLocation) const
+	{
+		return CalculateChunkMipmapLevel(*this, ChunkLocation);
+	}
+
+	inline static float CalculateChunkImportance(const FImportanceComputeInfo& CameraInfo, ivec3 ChunkLocation, uint32_t MipmapLevel = 0)
 	{
 		float Importance = 0.0f;
 		ivec3 CurrentOffset = ChunkLocation - CameraInfo.CameraChunk;
 		const float Far = 64.0f;
-		if (CurrentOffset.x >= -2 && CurrentOffset.x <= 2 && CurrentOffset.y >= -2 && CurrentOffset.y <= 2 && CurrentOffset.z >= -2 && CurrentOffset.z <= 2)
+		if (MipmapLevel != CalculateChunkMipmapLevel(CameraInfo, ChunkLocation))
+		{
+			Importance = 0.0f;//Wrong level for the current camera, first to be overridden
+		}
+		else if (CurrentOffset.x >= -2 && CurrentOffset.x <= 2 && CurrentOffset.y >= -2 && CurrentOffset.y <= 2 && CurrentOffset.z >= -2 && CurrentOffset.z <= 2)
 		{
 			Importance = 1.0e6f;
 		}
 		else
 		{
-			vec3 Direction = normalize(vec3(CurrentOffset));
-			float Distance = length(vec3(CurrentOffset));
+			vec3 CenterOffset = vec3(CurrentOffset) + ((float)(1u << MipmapLevel) - 1.0f) * 0.5f;
+			vec3 Direction = normalize(CenterOffset);
+			float Distance = length(CenterOffset);
 			float AngleImportance = std::max((std::max(0.0f, dot(Direction, CameraInfo.CameraForwardVector)) - 0.5f) * 2.0f, 0.75f);
 			float DistanceImportance = std::max(0.25f, Far - Distance);
 			Importance = AngleImportance * DistanceImportance;
 		}
 		return Importance;
 	}
-	inline float CalculateChunkImportance(ivec3 ChunkLocation) const
+	inline float CalculateChunkImportance(ivec3 ChunkLocation, uint32_t MipmapLevel = 0) const
+	{
+		return CalculateChunkImportance(*this, ChunkLocation, MipmapLevel);
+	}
+	// Lowest importance the chunk can get whatever way the camera looks, it only moves when the camera chunk does
+	inline float CalculateChunkImportanceFloor(ivec3 ChunkLocation, uint32_t MipmapLevel = 0) const
 	{
-		return CalculateChunkImportance(*this, ChunkLocation);
+		ivec3 CurrentOffset = ChunkLocation - CameraChunk;
+		const float Far = 64.0f;
+		if (MipmapLevel != CalculateChunkMipmapLevel(*this, ChunkLocation))
+		{
+			return 0.0f;
+		}
+		if (CurrentOffset.x >= -2 && CurrentOffset.x <= 2 && CurrentOffset.y >= -2 && CurrentOffset.y <= 2 && CurrentOffset.z >= -2 && CurrentOffset.z <= 2)
+		{
+			return 1.0e6f;
+		}
+		vec3 CenterOffset = vec3(CurrentOffset) + ((float)(1u << MipmapLevel) - 1.0f) * 0.5f;
+		return 0.75f * std::max(0.25f, Far - length(CenterOffset));//Least angle importance
 	}
 
-	inline static float CalculateBlockImportance(const FImportanceComputeInfo& CameraInfo, ivec3 ChunkLocation, u8vec3 BlockLocation, uint32_t ChunkResolution = 16)
+	inline static float CalculateBlockImportance(const FImportanceComputeInfo& CameraInfo, ivec3 ChunkLocation, u8vec3 BlockLocation, uint32_t ChunkResolution = 16, uint32_t MipmapLevel = 0)
 	{
 		float Importance = 0.0f;
-		ivec3 CurrentOffset = (ChunkLocation - CameraInfo.CameraChunk) * (int)ChunkResolution + ivec3(BlockLocation);
+		ivec3 CurrentOffset = (ChunkLocation - CameraInfo.CameraChunk) * (int)ChunkResolution + (ivec3(BlockLocation) << (int)MipmapLevel);
 		const float Far = 64.0f * ChunkResolution;
 		if (CurrentOffset.x >= -2 * ChunkResolution && CurrentOffset.x <= 2 * ChunkResolution && 
 			CurrentOffset.y >= -2 * ChunkResolution && CurrentOffset.y <= 2 * ChunkResolution && 
@@ -68,9 +120,9 @@ struct FImportanceComputeInfo
 		}
 		return Importance;
 	}
-	inline float CalculateBlockImportance(ivec3 ChunkLocation, u8vec3 BlockLocation, uint32_t ChunkResolution = 16) const
+	inline float CalculateBlockImportance(ivec3 ChunkLocation, u8vec3 BlockLocation, uint32_t ChunkResolution = 16, uint32_t MipmapLevel = 0) const
 	{
-		return CalculateBlockImportance(*this, ChunkLocation, BlockLocation, ChunkResolution);
+		return CalculateBlockImportance(*this, ChunkLocation, BlockLocation, ChunkResolution, MipmapLevel);
 	}
 };
 struct FChunkManageHelper
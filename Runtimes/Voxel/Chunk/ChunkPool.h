@@ -4,6 +4,9 @@
 #include <queue>
 #include <set>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <bit>
 
 #include <glm/ext.hpp>
 #include <glm/glm.hpp>
@@ -12,6 +15,8 @@
 #include "Voxel/VoxelSceneConfig.h"
 #include "Voxel/Block/Block.h"
 #include "Chunk.h"
+#include "Voxel/Spatial/VoxelRayCast.h"
+#include "Voxel/Spatial/VoxelSweep.h"
 #include "ChunkManagerHelper.h"
 #include "Shape/Shape.h"
 #include "Shape/Octahedron.h"
@@ -19,6 +24,8 @@
 #include "Helper/TimerSet.h"
 #include "Helper/Comparator.h"
 #include "Helper/VoxelMathHelper.h"
+#include "Helper/IndexedMinHeap.h"
+#include "Helper/VersionedSpanLog.h"
 
 #include "Shader/ShaderWireFrame.h"
 #include "Thread/ThreadSafeMap.h"
@@ -26,6 +33,8 @@
 #include "Thread/MemoryPool.h"
 #include "Thread/ThreadSafeQueue.h"
 #include "Thread/DoubleBufferQueue.h"
+#include "Thread/RecyclingDoubleBufferQueue.h"
+#include "Thread/AtomicPageAllocator.h"
 
 #include <functional>
 #include <climits>
@@ -61,49 +70,215 @@ public:
 	}
 };
 
+//A page of the block buffer taken (Page) or handed back (Page is INT_MAX) by a thread pool at LocalPage of its block slots.
+//Stamp grows with every page taken, so the newest owner wins while a page changing hands is in two pools
+struct FBlockPageChange
+{
+	uint32_t LocalPage = INT_MAX;
+	uint32_t Page = INT_MAX;
+	uint32_t Stamp = 0;
+};
+
+//What the render thread has to mirror from one push. Chunk payloads stay in the writing pool (the reading pool only uploads),
+//buffers are recycled by the queue so the vectors keep their capacity
 class FTLSModifyBuffer
 {
 public:
-	FChunk ModifyChunk;
-	uint32_t ModifyChunkIndex = INT_MAX;
-
-	FEmptyChunk ModifyEmptyChunk;
-	uint32_t ModifyEmptyChunkIndex = INT_MAX;
-
 	FGPUChunk ModifyGPUChunk;
 	uint32_t ModifyGPUChunkIndex = INT_MAX;
 
 	FGPUSimpleInstanceData ModifyGPUInstance;
 	uint32_t ModifyGPUInstanceIndex = INT_MAX;
 
+	std::vector<FBlockPageChange> ModifyBlockPages;//Applied before the blocks
 	std::vector<FGPUBlock> ModifyGPUBlock;
 	std::vector<uint32_t> ModifyGPUBlockIndex;
+
+	void Reset()
+	{
+		ModifyGPUChunkIndex = INT_MAX;
+		ModifyGPUInstanceIndex = INT_MAX;
+		ModifyBlockPages.clear();
+		ModifyGPUBlock.clear();
+		ModifyGPUBlockIndex.clear();
+	}
+	bool bEmpty() const
+	{
+		return ModifyGPUChunkIndex == INT_MAX && ModifyGPUInstanceIndex == INT_MAX && ModifyBlockPages.empty() && ModifyGPUBlock.empty();
+	}
+};
+
+//Block slots held by one chunk are linked through the slots, so the bookkeeping never outgrows the block buffer whatever the chunks push
+struct FBlockSlotLink
+{
+	uint32_t Prev = INT_MAX;
+	uint32_t Next = INT_MAX;
+	uint32_t BlockIndex = INT_MAX;//Into the Blocks of the chunk
+};
+
+/*
+Filled slots of one chunk pool by eviction order. A slot keys at the importance floor of its chunk (the importance with the camera looking away),
+which only moves when the camera changes chunk, so turning the camera or a new frame re-keys nothing.
+FindVictim takes candidates off the top until the next floor can't beat the best real importance found, chunks stamped this frame are skipped there.
+A camera crossing chunks faster than the pool pushes waits for the floors to be rebuilt, each push pays for as many floors as the old ring probe checked.
+Until then the old ring probe runs next to the heap, it catches the chunks whose LOD level went wrong under their older floors.
+*/
+struct FChunkEvictionIndex
+{
+	static constexpr uint32_t MaxCandidateNum = 128;//Bounds a push on a pool full of chunks facing the camera, as the old ring probe did
+
+	FIndexedMinHeap Heap;
+	uint32_t FilledNum = 0;//Slots [0, FilledNum) hold a chunk, the rest were never used
+	FImportanceComputeInfo KeyCameraInfo;//Forward vector left zero, only what the floors depend on
+	uint32_t RebuildCredit = UINT32_MAX;//Floors paid by the pushes since the last rebuild
+	uint32_t ProbeCursor = 0;
+	std::vector<std::pair<uint32_t, float>> CandidateScratch;
+
+	void Initialize(const uint32_t SlotNum)
+	{
+		Heap.Reset(SlotNum);
+		FilledNum = 0;
+		KeyCameraInfo = FImportanceComputeInfo();
+		RebuildCredit = UINT32_MAX;
+		ProbeCursor = 0;
+		CandidateScratch.clear();
+		CandidateScratch.reserve(MaxCandidateNum);
+	}
+	float GetKey(const FChunkBase& Chunk) const
+	{
+		if (!Chunk.bIsValid())//Evicted, reused first
+		{
+			return -INFINITY;
+		}
+		return KeyCameraInfo.CalculateChunkImportanceFloor(Chunk.ChunkLocation, Chunk.MipmapLevel);
+	}
+	// Least important filled slot not stamped with FrameStamp (INT_MAX if none) and its importance.
+	// The floors are rebuilt here once the camera changed chunk, a pool still filling never pays for it
+	template<typename T>
+	std::pair<uint32_t, float> FindVictim(const std::vector<T>& Slots, const FImportanceComputeInfo& CameraInfo, const uint32_t FrameStamp)
+	{
+		RebuildCredit = RebuildCredit > UINT32_MAX - MaxCandidateNum ? UINT32_MAX : RebuildCredit + MaxCandidateNum;
+		FImportanceComputeInfo NewKeyCameraInfo = CameraInfo;
+		NewKeyCameraInfo.CameraForwardVector = vec3(0.0f);
+		if (!(NewKeyCameraInfo == KeyCameraInfo) && RebuildCredit >= Heap.Size())
+		{
+			KeyCameraInfo = NewKeyCameraInfo;
+			RebuildCredit = 0;
+			Heap.Rebuild([&](uint32_t Slot) { return GetKey(Slots[Slot]); });
+		}
+		uint32_t Victim = INT_MAX;
+		float VictimImportance = INFINITY;
+		CandidateScratch.clear();
+		while (!Heap.bEmpty() && Heap.GetMinKey() < VictimImportance && CandidateScratch.size() < MaxCandidateNum)
+		{
+			const uint32_t Slot = Heap.GetMin();
+			CandidateScratch.emplace_back(Slot, Heap.GetMinKey());
+			Heap.Remove(Slot);
+			const T& Chunk = Slots[Slot];
+			if (Chunk.bIsValid() && Chunk.ChunkFrameStamp >= FrameStamp)//Pushed this frame, never overridden
+			{
+				continue;
+			}
+			const float Importance = Chunk.bIsValid() ? CameraInfo.CalculateChunkImportance(Chunk.ChunkLocation, Chunk.MipmapLevel) : -INFINITY;
+			if (Importance < VictimImportance)
+			{
+				Victim = Slot;
+				VictimImportance = Importance;
+			}
+		}
+		for (const auto& [Slot, Key] : CandidateScratch)
+		{
+			Heap.Set(Slot, Key);
+		}
+		if (!(NewKeyCameraInfo == KeyCameraInfo) && FilledNum > 0)
+		{
+			for (uint32_t i = 0; i < std::min(MaxCandidateNum, FilledNum); i++)
+			{
+				const uint32_t Slot = (ProbeCursor + i) % FilledNum;
+				const T& Chunk = Slots[Slot];
+				if (Chunk.bIsValid() && Chunk.ChunkFrameStamp < FrameStamp)
+				{
+					const float Importance = CameraInfo.CalculateChunkImportance(Chunk.ChunkLocation, Chunk.MipmapLevel);
+					if (Importance < VictimImportance)
+					{
+						Victim = Slot;
+						VictimImportance = Importance;
+					}
+				}
+			}
+			ProbeCursor = (ProbeCursor + MaxCandidateNum) % FilledNum;
+		}
+		return { Victim, VictimImportance };
+	}
+};
+
+/*
+The block buffer cut in pages of PageSize slots, shared by the thread pools. A pool takes a page when it has no free slot left and hands back
+the pages it emptied, so a thread generating dense terrain can use the room the others don't need.
+A pool under its fair share that finds nothing left is hungry, the pools over their share then stop taking pages and give back their emptiest one.
+*/
+struct FBlockPagePool
+{
+	FAtomicPageAllocator Allocator;
+	uint32_t PageSize = 0;
+	uint32_t FairPageNum = 0;
+	std::atomic<uint32_t> HungryPoolNum = 0;
+	std::atomic<uint32_t> PageStamp = 0;
+
+	//A page is never bigger than an even split, the tail of MaxBlockCount short of a page is left out
+	void Initialize(const uint32_t MaxBlockCount, const uint32_t PageSize_, const uint32_t ThreadCount)
+	{
+		PageSize = std::max(1u, std::min(PageSize_, MaxBlockCount / std::max(1u, ThreadCount)));
+		Allocator.Initialize(MaxBlockCount / PageSize);
+		FairPageNum = Allocator.GetPageNum() / std::max(1u, ThreadCount);
+		HungryPoolNum.store(0);
+		PageStamp.store(0);
+	}
 };
 
 class FTLSChunkPool
 {
 public:
-	using FModifyBufferQueue = TDoubleBufferQueue<FTLSModifyBuffer>;
+	using FModifyBufferQueue = TRecyclingDoubleBufferQueue<FTLSModifyBuffer>;
 	std::vector<FChunk> ChunksPool;
-	uint32_t CurrentChunkIndex = 0;
+	FChunkEvictionIndex ChunkEvictionIndex;
 
 	std::vector<FEmptyChunk> EmptyChunksPool;
-	uint32_t CurrentEmptyChunkIndex = 0;
+	FChunkEvictionIndex EmptyChunkEvictionIndex;
 
 	std::vector<FGPUChunk> GPUChunksPool; //simulate gpu chunk first
-	std::vector<FGPUBlock> GPUBlockPool;
+	std::vector<FGPUBlock> GPUBlockPool;//Local page k holds the slots of block buffer page BlockPages[k]
 	uint32_t CurrentGPUBlockIndex = 0;
+	std::vector<uint32_t> ChunkFirstBlockSlot;//Per chunk slot, first of the block slots it holds, freed when the chunk is replaced
+	std::vector<FBlockSlotLink> BlockSlotLinks;//Per block slot, writing pool only
+	std::vector<std::shared_ptr<FChunkQueryData>> ChunkQueryData;//Per chunk slot, what the resident cache hands out
+
+	//Block pages, INT_MAX for a local page handed back
+	std::vector<uint32_t> BlockPages;
+	std::vector<uint32_t> BlockPageStamps;
+	std::vector<uint32_t> BlockPageLiveNum;
+	std::vector<uint32_t> FreeBlockSlots;
+	uint32_t BlockPageSize = 0;
+	uint32_t BlockPageNum = 0;
+	bool bBlockPageHungry = false;
 
 	std::vector<FGPUSimpleInstanceData> GPUInstanceData;
+	//Sized for the worst chunk and page when the pool is made, a push never grows them
+	std::vector<uint8_t> FaceMaskScratch;//Face masks of the chunk being pushed
+	std::vector<uint32_t> BorderSlotScratch;//Block index to the slot of a resident border block, INT_MAX between re-culls
+	std::vector<std::pair<float, uint32_t>> DrainBlockScratch;//Importance and slot of the blocks on the page being drained
+
+	//Reading pool only, what changed at which version for the buffered frames to catch up on. Blocks are in block buffer indices
+	FVersionedSpanLog GPUChunkLog;
+	FVersionedSpanLog GPUInstanceLog;
+	FVersionedSpanLog GPUBlockLog;
 
 	uint32_t SubMaxChunkCount = 0;
 	uint32_t SubMaxEmptyChunkCount = 0;
-	uint32_t SubMaxBlockCount = 0;
 	uint32_t SubMaxGPUInstanceCount = 0;
 
 	uint32_t ChunkCountOffset = 0;
 	uint32_t EmptyChunkCountOffset = 0;
-	uint32_t BlockCountOffset = 0;
 	uint32_t GPUInstanceOffset = 0;
 
 	uint32_t SubCurrentDebugDrawInstanceCount = 0;
@@ -112,101 +287,1055 @@ public:
 	{
 
 	}
-	void Initialize(const uint32_t& SubMaxChunkCount_, const uint32_t& SubMaxEmptyChunkCount_, const uint32_t& SubMaxBlockCount_, 
-		const uint32_t& ChunkCountOffset_, const uint32_t& EmptyChunkCountOffset_, const uint32_t& BlockCountOffset_)
+	//Block slots start empty, pages are taken from the FBlockPagePool on demand. A reading pool has no chunk payloads
+	void Initialize(const uint32_t& SubMaxChunkCount_, const uint32_t& SubMaxEmptyChunkCount_, const uint32_t& BlockPageSize_, 
+		const uint32_t& ChunkCountOffset_, const uint32_t& EmptyChunkCountOffset_, const bool bReading = false)
 	{
 		SubMaxChunkCount = SubMaxChunkCount_;
 		SubMaxEmptyChunkCount = SubMaxEmptyChunkCount_;
-		SubMaxBlockCount = SubMaxBlockCount_;
 		SubMaxGPUInstanceCount = SubMaxChunkCount + SubMaxEmptyChunkCount;
 
 		ChunkCountOffset = ChunkCountOffset_;
 		EmptyChunkCountOffset = EmptyChunkCountOffset_;
-		BlockCountOffset = BlockCountOffset_;
 		GPUInstanceOffset = ChunkCountOffset + EmptyChunkCountOffset;
 
-		ChunksPool.resize(SubMaxChunkCount);
-		EmptyChunksPool.resize(SubMaxEmptyChunkCount);
+		ChunksPool.resize(bReading ? 0 : SubMaxChunkCount);
+		EmptyChunksPool.resize(bReading ? 0 : SubMaxEmptyChunkCount);
+		ChunkEvictionIndex.Initialize(bReading ? 0 : SubMaxChunkCount);
+		EmptyChunkEvictionIndex.Initialize(bReading ? 0 : SubMaxEmptyChunkCount);
 
 		GPUChunksPool.resize(SubMaxChunkCount);
-		GPUBlockPool.resize(SubMaxBlockCount);
+		ChunkFirstBlockSlot.assign(bReading ? 0 : SubMaxChunkCount, INT_MAX);
+		ChunkQueryData.assign(bReading ? 0 : SubMaxChunkCount, nullptr);
+		BlockSlotLinks.clear();
+		FaceMaskScratch.reserve(bReading ? 0 : FChunkOccupancyVolume::VoxelNum);
+		BorderSlotScratch.assign(bReading ? 0 : FChunkOccupancyVolume::VoxelNum, INT_MAX);
+		DrainBlockScratch.reserve(bReading ? 0 : BlockPageSize_);
+		if (bReading)
+		{
+			GPUChunkLog.Reserve();
+			GPUInstanceLog.Reserve();
+			GPUBlockLog.Reserve();
+		}
+
+		GPUBlockPool.clear();
+		BlockPages.clear();
+		BlockPageStamps.clear();
+		BlockPageLiveNum.clear();
+		FreeBlockSlots.clear();
+		BlockPageSize = BlockPageSize_;
+		BlockPageNum = 0;
+		CurrentGPUBlockIndex = 0;
+		bBlockPageHungry = false;
 
 		FGPUSimpleInstanceData DefaultInstanceData = { .ChunkLocation = {INT_MAX,INT_MAX,INT_MAX} };
 		GPUInstanceData.resize(SubMaxChunkCount + SubMaxEmptyChunkCount_, DefaultInstanceData);
 	}
-	void ConsumeQueue(FModifyBufferQueue& Queue)
+	//The buffers are created without data, everything is logged at the first version
+	void StartUploadLog(const uint64_t Version)
+	{
+		GPUChunkLog.AddRange(Version, 0, (uint32_t)GPUChunksPool.size());
+		GPUInstanceLog.AddRange(Version, 0, (uint32_t)GPUInstanceData.size());
+	}
+	//Changes are logged at Version, 0 for a pool nobody uploads
+	void ConsumeQueue(FModifyBufferQueue& Queue, const uint64_t Version = 0)
+	{
+		auto MarkDirty = [Version](FVersionedSpanLog& Log, const uint32_t Begin, const uint32_t End)
+			{
+				if (Version != 0)
+				{
+					Log.AddRange(Version, Begin, End);
+				}
+			};
+		Queue.Consume([&](const FTLSModifyBuffer& CurrentModifyBuffer)
+			{
+				if (CurrentModifyBuffer.ModifyGPUChunkIndex != INT_MAX)
+				{
+					GPUChunksPool[CurrentModifyBuffer.ModifyGPUChunkIndex] = CurrentModifyBuffer.ModifyGPUChunk;
+					MarkDirty(GPUChunkLog, CurrentModifyBuffer.ModifyGPUChunkIndex, CurrentModifyBuffer.ModifyGPUChunkIndex + 1);
+				}
+				if (CurrentModifyBuffer.ModifyGPUInstanceIndex != INT_MAX)
+				{
+					GPUInstanceData[CurrentModifyBuffer.ModifyGPUInstanceIndex] = CurrentModifyBuffer.ModifyGPUInstance;
+					MarkDirty(GPUInstanceLog, CurrentModifyBuffer.ModifyGPUInstanceIndex, CurrentModifyBuffer.ModifyGPUInstanceIndex + 1);
+				}
+				//A page changing hands is sent whole, from its new owner or cleared
+				for (const FBlockPageChange& Change : CurrentModifyBuffer.ModifyBlockPages)
+				{
+					const uint32_t OldPage = Change.LocalPage < BlockPages.size() ? BlockPages[Change.LocalPage] : INT_MAX;
+					ApplyBlockPageChange(Change);
+					for (const uint32_t Page : { OldPage, Change.Page })
+					{
+						if (Page != INT_MAX)
+						{
+							MarkDirty(GPUBlockLog, Page * BlockPageSize, (Page + 1) * BlockPageSize);
+						}
+					}
+				}
+				for (uint32_t i = 0; i < CurrentModifyBuffer.ModifyGPUBlock.size(); i++)
+				{
+					const uint32_t Slot = CurrentModifyBuffer.ModifyGPUBlockIndex[i];
+					GPUBlockPool[Slot] = CurrentModifyBuffer.ModifyGPUBlock[i];
+					const uint32_t Page = BlockPages[Slot / BlockPageSize];
+					if (Page != INT_MAX)
+					{
+						const uint32_t BlockIndex = Page * BlockPageSize + Slot % BlockPageSize;
+						MarkDirty(GPUBlockLog, BlockIndex, BlockIndex + 1);
+					}
+				}
+			});
+	}
+	//Ring over the slots of the pages we own, skips the ones handed back. Needs a page
+	void IncreaseGPUBlockIndex()
+	{
+		CurrentGPUBlockIndex = (CurrentGPUBlockIndex + 1) % (uint32_t)GPUBlockPool.size();
+		while (BlockPages[CurrentGPUBlockIndex / BlockPageSize] == INT_MAX)
+		{
+			CurrentGPUBlockIndex = (CurrentGPUBlockIndex / BlockPageSize + 1) * BlockPageSize % (uint32_t)GPUBlockPool.size();
+		}
+	}
+	uint32_t GetBlockCapacity() const
+	{
+		return BlockPageNum * BlockPageSize;
+	}
+	//Same on the writing and the reading pool, the local page starts with invalid blocks either way
+	void ApplyBlockPageChange(const FBlockPageChange& Change)
+	{
+		if (Change.LocalPage >= BlockPages.size())
+		{
+			BlockPages.resize(Change.LocalPage + 1, INT_MAX);
+			BlockPageStamps.resize(Change.LocalPage + 1, 0);
+			BlockPageLiveNum.resize(Change.LocalPage + 1, 0);
+			GPUBlockPool.resize((size_t)(Change.LocalPage + 1) * BlockPageSize);
+		}
+		BlockPageNum += (Change.Page != INT_MAX ? 1 : 0) - (BlockPages[Change.LocalPage] != INT_MAX ? 1 : 0);
+		BlockPages[Change.LocalPage] = Change.Page;
+		BlockPageStamps[Change.LocalPage] = Change.Stamp;
+		BlockPageLiveNum[Change.LocalPage] = 0;
+		std::fill_n(GPUBlockPool.begin() + (size_t)Change.LocalPage * BlockPageSize, BlockPageSize, FGPUBlock());
+	}
+	//Takes a page from the shared pool into the first local page handed back (or a new one), its slots become free
+	bool BorrowBlockPage(FBlockPagePool& PagePool, FTLSModifyBuffer& ModifyBuffer)
+	{
+		const bool bUnderShare = BlockPageNum < PagePool.FairPageNum;
+		if (!bUnderShare && PagePool.HungryPoolNum.load(std::memory_order_relaxed) > 0)//Leave them to the hungry pools
+		{
+			return false;
+		}
+		const uint32_t Page = PagePool.Allocator.Allocate();
+		if (Page == FAtomicPageAllocator::InvalidPage)
+		{
+			if (bUnderShare && !bBlockPageHungry)
+			{
+				bBlockPageHungry = true;
+				PagePool.HungryPoolNum.fetch_add(1);
+			}
+			return false;
+		}
+		if (bBlockPageHungry)
+		{
+			bBlockPageHungry = false;
+			PagePool.HungryPoolNum.fetch_sub(1);
+		}
+		const FBlockPageChange Change = {
+			.LocalPage = (uint32_t)(std::find(BlockPages.begin(), BlockPages.end(), INT_MAX) - BlockPages.begin()),
+			.Page = Page,
+			.Stamp = PagePool.PageStamp.fetch_add(1) + 1 };
+		ApplyBlockPageChange(Change);
+		BlockSlotLinks.resize(GPUBlockPool.size());
+		ModifyBuffer.ModifyBlockPages.push_back(Change);
+		for (uint32_t Slot = BlockPageSize; Slot-- > 0;)
+		{
+			FreeBlockSlots.push_back(Change.LocalPage * BlockPageSize + Slot);
+		}
+		return true;
+	}
+	//An empty page only, the block buffer shows it empty until its next owner uploads it
+	void ReleaseBlockPage(const uint32_t LocalPage, FBlockPagePool& PagePool, FTLSModifyBuffer& ModifyBuffer)
+	{
+		assert(BlockPageLiveNum[LocalPage] == 0 && "Releasing a block page with live blocks");
+		const uint32_t Page = BlockPages[LocalPage];
+		std::erase_if(FreeBlockSlots, [&](uint32_t Slot) { return Slot / BlockPageSize == LocalPage; });
+		const FBlockPageChange Change = { .LocalPage = LocalPage, .Page = INT_MAX, .Stamp = BlockPageStamps[LocalPage] };
+		ApplyBlockPageChange(Change);
+		ModifyBuffer.ModifyBlockPages.push_back(Change);
+		PagePool.Allocator.Free(Page);
+	}
+	//A free slot, taking a page when there is none left. INT_MAX when the shared pool has nothing for us either.
+	//Under our share the next page is taken a page ahead, so we go hungry before running dry
+	uint32_t AllocateBlockSlot(FBlockPagePool& PagePool, FTLSModifyBuffer& ModifyBuffer)
+	{
+		if (FreeBlockSlots.size() < (BlockPageNum < PagePool.FairPageNum ? BlockPageSize : 1))
+		{
+			BorrowBlockPage(PagePool, ModifyBuffer);
+		}
+		if (FreeBlockSlots.empty())
+		{
+			return INT_MAX;
+		}
+		const uint32_t Slot = FreeBlockSlots.back();
+		FreeBlockSlots.pop_back();
+		return Slot;
+	}
+	//A live slot is linked to the chunk in its GPU block
+	void LinkBlockSlot(const uint32_t Slot, const uint32_t BlockIndex)
+	{
+		uint32_t& First = ChunkFirstBlockSlot[GPUBlockPool[Slot].ChunkIndex - ChunkCountOffset];
+		BlockSlotLinks[Slot] = { .Prev = INT_MAX, .Next = First, .BlockIndex = BlockIndex };
+		if (First != INT_MAX)
+		{
+			BlockSlotLinks[First].Prev = Slot;
+		}
+		First = Slot;
+	}
+	void UnlinkBlockSlot(const uint32_t Slot)
+	{
+		const FBlockSlotLink& Link = BlockSlotLinks[Slot];
+		if (Link.Prev != INT_MAX)
+		{
+			BlockSlotLinks[Link.Prev].Next = Link.Next;
+		}
+		else
+		{
+			ChunkFirstBlockSlot[GPUBlockPool[Slot].ChunkIndex - ChunkCountOffset] = Link.Next;
+		}
+		if (Link.Next != INT_MAX)
+		{
+			BlockSlotLinks[Link.Next].Prev = Link.Prev;
+		}
+	}
+	//Visit(uint32_t Slot) may free the slot it is given
+	template<typename FVisit>
+	void ForEachChunkBlockSlot(const uint32_t ChunkIndex, FVisit&& Visit) const
+	{
+		for (uint32_t Slot = ChunkFirstBlockSlot[ChunkIndex]; Slot != INT_MAX;)
+		{
+			const uint32_t Next = BlockSlotLinks[Slot].Next;
+			Visit(Slot);
+			Slot = Next;
+		}
+	}
+	//Block is BlockIndex of the chunk it names, a block still in the slot goes first
+	void WriteBlock(const uint32_t Slot, const FGPUBlock& Block, const uint32_t BlockIndex)
+	{
+		if (GPUBlockPool[Slot].ChunkIndex == INT_MAX)
+		{
+			BlockPageLiveNum[Slot / BlockPageSize]++;
+			SubCurrentBlockCount++;
+		}
+		else
+		{
+			UnlinkBlockSlot(Slot);
+		}
+		GPUBlockPool[Slot] = Block;
+		LinkBlockSlot(Slot, BlockIndex);
+	}
+	//Hands the page back once it is empty, unless it is the only room we have left
+	void FreeBlockSlot(const uint32_t Slot, FBlockPagePool& PagePool, FTLSModifyBuffer& ModifyBuffer)
+	{
+		const uint32_t LocalPage = Slot / BlockPageSize;
+		UnlinkBlockSlot(Slot);
+		GPUBlockPool[Slot] = FGPUBlock();
+		SubCurrentBlockCount--;
+		FreeBlockSlots.push_back(Slot);
+		if (--BlockPageLiveNum[LocalPage] == 0 && GetBlockCapacity() - SubCurrentBlockCount >= 2 * BlockPageSize)
+		{
+			ReleaseBlockPage(LocalPage, PagePool, ModifyBuffer);
+		}
+	}
+	//Query data of the chunk in ChunkIndex, rewritten in place once the resident cache and the readers dropped the old one
+	std::shared_ptr<const FChunkQueryData> UpdateChunkQueryData(const uint32_t ChunkIndex, const FChunk& Chunk)
+	{
+		std::shared_ptr<FChunkQueryData>& Data = ChunkQueryData[ChunkIndex];
+		if (Data && Data.use_count() == 1)
+		{
+			std::atomic_thread_fence(std::memory_order_acquire);//Pairs with the last reader's release
+			*Data = FChunkQueryData::FromChunk(Chunk);
+		}
+		else
+		{
+			Data = std::make_shared<FChunkQueryData>(FChunkQueryData::FromChunk(Chunk));
+		}
+		return Data;
+	}
+	//The slots still holding blocks of the chunk in ChunkIndex (others may have evicted some)
+	void FreeChunkBlocks(const uint32_t ChunkIndex, FBlockPagePool& PagePool, FTLSModifyBuffer& ModifyBuffer)
+	{
+		ForEachChunkBlockSlot(ChunkIndex, [&](const uint32_t Slot) { FreeBlockSlot(Slot, PagePool, ModifyBuffer); });
+	}
+	//Empties a local page before it is handed back. The blocks still drawn move to our free slots on the other pages, the most important first,
+	//the ones left without room are dropped with the stale ones. The moved blocks are linked to their chunk in their new slot
+	void DrainBlockPage(const uint32_t LocalPage, const FImportanceComputeInfo& CameraInfo, const uint32_t ChunkResolution, FTLSModifyBuffer& ModifyBuffer)
+	{
+		const uint32_t PageBegin = LocalPage * BlockPageSize;
+		std::erase_if(FreeBlockSlots, [&](uint32_t Slot) { return Slot / BlockPageSize == LocalPage; });
+		std::vector<std::pair<float, uint32_t>>& Drawn = DrainBlockScratch;
+		Drawn.clear();
+		for (uint32_t Slot = PageBegin; Slot < PageBegin + BlockPageSize; Slot++)
+		{
+			const FGPUBlock& Block = GPUBlockPool[Slot];
+			if (Block.ChunkIndex != INT_MAX && GPUChunksPool[Block.ChunkIndex - ChunkCountOffset].ChunkFrameStamp == Block.BlockFrameStamp)
+			{
+				const FGPUChunk& GPUChunk = GPUChunksPool[Block.ChunkIndex - ChunkCountOffset];
+				Drawn.push_back({ CameraInfo.CalculateBlockImportance(GPUChunk.ChunkLocation, u8vec3(Block.BlockLocation), ChunkResolution, GPUChunk.MipmapLevel), Slot });
+			}
+		}
+		const size_t MoveNum = std::min(Drawn.size(), FreeBlockSlots.size());
+		std::nth_element(Drawn.begin(), Drawn.begin() + MoveNum, Drawn.end(), [](const auto& A, const auto& B) { return A.first > B.first; });
+		for (uint32_t Slot = PageBegin; Slot < PageBegin + BlockPageSize; Slot++)
+		{
+			if (GPUBlockPool[Slot].ChunkIndex != INT_MAX)
+			{
+				UnlinkBlockSlot(Slot);
+			}
+		}
+		for (size_t i = 0; i < MoveNum; i++)
+		{
+			const uint32_t OldSlot = Drawn[i].second;
+			const uint32_t NewSlot = FreeBlockSlots.back();
+			FreeBlockSlots.pop_back();
+			WriteBlock(NewSlot, GPUBlockPool[OldSlot], BlockSlotLinks[OldSlot].BlockIndex);
+			ModifyBuffer.ModifyGPUBlock.push_back(GPUBlockPool[OldSlot]);
+			ModifyBuffer.ModifyGPUBlockIndex.push_back(NewSlot);
+		}
+		//Moved, dropped or stale, nothing is left on the page
+		SubCurrentBlockCount -= BlockPageLiveNum[LocalPage];
+		BlockPageLiveNum[LocalPage] = 0;
+		std::fill_n(GPUBlockPool.begin() + PageBegin, BlockPageSize, FGPUBlock());
+	}
+	//Over our share while pools are hungry and nothing is free, give back our emptiest pages, one per hungry pool.
+	//Only an empty page goes back, the emptiest one is drained first
+	void RebalanceBlockPages(FBlockPagePool& PagePool, FTLSModifyBuffer& ModifyBuffer, const FImportanceComputeInfo& CameraInfo, const uint32_t ChunkResolution)
+	{
+		while (BlockPageNum > PagePool.FairPageNum && PagePool.Allocator.GetFreeNum() < PagePool.HungryPoolNum.load(std::memory_order_relaxed))
+		{
+			uint32_t Emptiest = INT_MAX;
+			for (uint32_t LocalPage = 0; LocalPage < BlockPages.size(); LocalPage++)
+			{
+				if (BlockPages[LocalPage] != INT_MAX && (Emptiest == INT_MAX || BlockPageLiveNum[LocalPage] < BlockPageLiveNum[Emptiest]))
+				{
+					Emptiest = LocalPage;
+				}
+			}
+			if (BlockPageLiveNum[Emptiest] > 0)
+			{
+				DrainBlockPage(Emptiest, CameraInfo, ChunkResolution, ModifyBuffer);
+			}
+			ReleaseBlockPage(Emptiest, PagePool, ModifyBuffer);
+		}
+	}
+};
+//Everything but the GPU side, the writing and reading pools run headless
+class FChunkPoolCore
+{
+public:
+	std::vector<FTLSChunkPool> TLSChunkPool;
+	std::vector<std::unique_ptr<FTLSChunkPool::FModifyBufferQueue>> TLSChunkPoolModifyBufferQueue;
+	std::vector<FTLSChunkPool> TLSChunkPoolRead;
+	uint32_t ThreadCount = 0;
+	//For multi thread
+	using FChunkLookupTable = TThreadSafeMap<ivec4, EChunkState, FIVec4Comparator>;//Key: ChunkLocation, MipmapLevel
+	FChunkLookupTable ChunksLookupTable; 
+	// Before computing, mark as COMPUTING
+	// After computing, mask as NonEmpty/Empty
+	// Before reading, [threadsafe] read if not computing then mark as reading
+	// read
+	// After reading, set to original
+	std::atomic<uint64_t> AtomicVisibilityChunkFrameStamp = 0;
+	//Constant
+	uint32_t MaxChunkCount = 0;
+	uint32_t MaxEmptyChunkCount = 0;
+	uint32_t MaxBlockCount = 0;
+	//Try
+	uint32_t MaxBlockCheckTimes = 0;
+	//Block slots move between the thread pools a page at a time
+	FBlockPagePool BlockPagePool;
+	struct FBlockPageOwner
+	{
+		uint32_t ThreadId = INT_MAX;
+		uint32_t LocalPage = INT_MAX;
+		uint32_t Stamp = 0;
+	};
+	std::vector<FBlockPageOwner> BlockPageOwners;
+	std::vector<FGPUBlock> InvalidBlockPage;
+	//Uploads
+	uint32_t UploadMergeGapBytes = 0;
+	size_t LastUploadBytes = 0;
+	//Inner voxel cull, read once per pushed chunk so it can change between frames
+	std::atomic<uint32_t> AtomicCullDepthThreshold = 1;
+	uint32_t MaxCullDepthThreshold = 1;
+	//Every resident chunk with solid voxels, its query data (border slices for the cross chunk cull, occupancy for ray casts) and the thread owning it
+	struct FResidentChunkEntry
+	{
+		std::shared_ptr<const FChunkQueryData> Data;
+		uint32_t ThreadId = INT_MAX;
+		uint32_t ChunkIndex = INT_MAX;
+	};
+	//Work on a chunk slot of another thread's pool, the owner checks the key first as the slot may have been reused meanwhile
+	struct FChunkSlotRequest
+	{
+		ivec4 ChunkKey;
+		uint32_t ChunkIndex = INT_MAX;
+	};
+	TThreadSafeMap<ivec4, FResidentChunkEntry, FIVec4Comparator> ResidentChunkCache;
+	//Per thread, only the owner touches its pools
+	std::vector<std::unique_ptr<TThreadSafeQueue<FChunkSlotRequest>>> BorderRecullQueues;
+	std::vector<std::unique_ptr<TThreadSafeQueue<FChunkSlotRequest>>> LodEvictQueues;//Chunks a pushed chunk of another mip level overlaps
+	std::vector<std::unique_ptr<std::mutex>> WritingPoolLocks;//Held by a push and by the frame boundary drain, a pool changes on one thread at a time
+	//Coarse occupancy across resident chunks, one 4x4x4 chunk brick of a mip level per key and a bit per chunk with solid voxels
+	inline static constexpr int32_t ResidentBrickShift = 2;
+	TThreadSafeMap<ivec4, uint64_t, FIVec4Comparator> ResidentChunkBricks;
+
+	//Runtime
+	std::atomic<uint64_t> AtomicPushVersion = 0;//Bumped by every push, a frame whose buffers saw an older one catches up
+	std::vector<uint64_t> FramePushVersion;
+	//Reading pool logs are at UploadVersion, every buffered frame replays the entries after its own and they are dropped once all frames have them
+	uint64_t UploadVersion = 0;
+	std::vector<uint64_t> FrameUploadVersion;
+	FDirtySpans UploadSpansScratch;
+	//Debug
+	uint32_t CurrentDebugDrawInstanceCount = 0;
+	uint32_t CurrentBlockCount = 0;
+	//Buffer Num
+	uint32_t BufferedFramesNum = 1;
+	uint64_t AtomicGetCurrentChunkFrameStamp() const
+	{
+		return AtomicVisibilityChunkFrameStamp.load();
+	}
+	void IncreaseFrameStamp()
+	{
+		AtomicVisibilityChunkFrameStamp.fetch_add(1);
+	}
+	//Occupancy generated chunks only hold blocks up to MaxCullDepthThreshold deep, so it is clamped
+	void SetCullDepthThreshold(uint32_t CullDepthThreshold)
+	{
+		AtomicCullDepthThreshold.store(std::min(CullDepthThreshold, MaxCullDepthThreshold));
+	}
+	void InitializePools(const FVoxelSceneConfig& VoxelSceneConfig, uint32_t ThreadCount_, uint32_t BufferedFramesNum_ = 1)
+	{
+		BufferedFramesNum = BufferedFramesNum_;
+		ThreadCount = ThreadCount_;
+		AtomicVisibilityChunkFrameStamp.store(0);
+		MaxChunkCount = VoxelSceneConfig.MaxChunkCount;
+		MaxEmptyChunkCount = VoxelSceneConfig.MaxEmptyChunkCount;
+		MaxBlockCount = VoxelSceneConfig.MaxBlockCount;
+
+		TLSChunkPool.resize(ThreadCount);
+		TLSChunkPoolRead.resize(ThreadCount);
+		for (size_t i = 0; i < ThreadCount; ++i) 
+		{
+			TLSChunkPoolModifyBufferQueue.push_back(std::make_unique<FTLSChunkPool::FModifyBufferQueue>());
+			BorderRecullQueues.push_back(std::make_unique<TThreadSafeQueue<FChunkSlotRequest>>());
+			LodEvictQueues.push_back(std::make_unique<TThreadSafeQueue<FChunkSlotRequest>>());
+			WritingPoolLocks.push_back(std::make_unique<std::mutex>());
+		}
+		uint32_t AvgSubMaxChunkCount = MaxChunkCount / ThreadCount;
+		uint32_t AvgSubMaxEmptyChunkCount = MaxEmptyChunkCount / ThreadCount;
+		BlockPagePool.Initialize(MaxBlockCount, VoxelSceneConfig.BlockPageSize, ThreadCount);
+		InvalidBlockPage.assign(BlockPagePool.PageSize, FGPUBlock());
+		UploadMergeGapBytes = VoxelSceneConfig.UploadMergeGapBytes;
+		UploadSpansScratch.Reserve();
+
+		MaxBlockCheckTimes = std::max(1u, VoxelSceneConfig.MaxBlockCheckTimes);
+		MaxCullDepthThreshold = VoxelSceneConfig.ChunkMaxCullDepthThreshold;
+		SetCullDepthThreshold(VoxelSceneConfig.ChunkInnerVoxelCullDepthThreshold);
+		for (uint32_t i = 0; i < ThreadCount; i++)
+		{
+			uint32_t SubMaxChunkCountStart = AvgSubMaxChunkCount * i;
+			uint32_t SubMaxChunkCountEnd = (i == ThreadCount - 1) ? std::max(AvgSubMaxChunkCount * (i + 1), MaxChunkCount) : AvgSubMaxChunkCount * (i + 1);
+
+			uint32_t SubMaxEmptyChunkCountStart = AvgSubMaxEmptyChunkCount * i;
+			uint32_t SubMaxEmptyChunkCountEnd = (i == ThreadCount - 1) ? std::max(AvgSubMaxEmptyChunkCount * (i + 1), MaxEmptyChunkCount) : AvgSubMaxEmptyChunkCount * (i + 1);
+
+			TLSChunkPool[i].Initialize(
+				(SubMaxChunkCountEnd - SubMaxChunkCountStart), (SubMaxEmptyChunkCountEnd - SubMaxEmptyChunkCountStart), BlockPagePool.PageSize,
+				SubMaxChunkCountStart, SubMaxEmptyChunkCountStart);
+			TLSChunkPoolRead[i].Initialize(
+				(SubMaxChunkCountEnd - SubMaxChunkCountStart), (SubMaxEmptyChunkCountEnd - SubMaxEmptyChunkCountStart), BlockPagePool.PageSize,
+				SubMaxChunkCountStart, SubMaxEmptyChunkCountStart, true);
+		}
+		//Block buffer is cleared whole by the first uploads, the tail short of a page included
+		UploadVersion = 1;
+		for (uint32_t i = 0; i < ThreadCount; i++)
+		{
+			TLSChunkPoolRead[i].StartUploadLog(UploadVersion);
+		}
+		TLSChunkPoolRead[0].GPUBlockLog.AddRange(UploadVersion, 0, MaxBlockCount);
+		FramePushVersion.assign(BufferedFramesNum, 0);
+		FrameUploadVersion.assign(BufferedFramesNum, 0);
+	}
+	//Finds a slot for one block, returns the GPU block index or INT_MAX when there is no free slot and every checked slot is more important
+	uint32_t PushBlockToBlockPool(const FImportanceComputeInfo& CameraInfo, FTLSChunkPool& MemoryPool, const FChunk& Chunk, const uint32_t BlockIndex, const uint8_t FaceMask, const uint32_t ChunkIndex, const uint32_t ChunkResolution, FTLSModifyBuffer& ModifyBuffer, const uint32_t MaxBlockCheckTimes)
+	{
+		const FBlock& NewBlock = Chunk.Blocks[BlockIndex];
+		//Free slots first (ours or a page taken from the shared pool), then the ring over our pages
+		uint32_t OverrideBlockLocationIndex = MemoryPool.AllocateBlockSlot(BlockPagePool, ModifyBuffer);
+		if (OverrideBlockLocationIndex == INT_MAX && MemoryPool.BlockPageNum > 0)
+		{
+			const float NewBlockImportance = CameraInfo.CalculateBlockImportance(Chunk.ChunkLocation, { NewBlock.BlockLocation.x, NewBlock.BlockLocation.y, NewBlock.BlockLocation.z }, ChunkResolution, Chunk.MipmapLevel);
+			if (MemoryPool.BlockPages[MemoryPool.CurrentGPUBlockIndex / MemoryPool.BlockPageSize] == INT_MAX)
+			{
+				MemoryPool.IncreaseGPUBlockIndex();
+			}
+			for (uint32_t i = 0; i < MaxBlockCheckTimes; i++)
+			{
+				auto& OldGPUBlock = MemoryPool.GPUBlockPool[MemoryPool.CurrentGPUBlockIndex];
+				if (OldGPUBlock.ChunkIndex == INT_MAX || MemoryPool.GPUChunksPool[OldGPUBlock.ChunkIndex - MemoryPool.ChunkCountOffset].ChunkFrameStamp != OldGPUBlock.BlockFrameStamp)//Invalid
+				{
+					OverrideBlockLocationIndex = MemoryPool.CurrentGPUBlockIndex;
+					break;
+				}
+				else//Valid
+				{
+					//Calculate importance
+					const FGPUChunk& OldGPUChunk = MemoryPool.GPUChunksPool[OldGPUBlock.ChunkIndex - MemoryPool.ChunkCountOffset];
+					const u8vec3 OldBlockLocation = u8vec3(OldGPUBlock.BlockLocation);
+					const float OldBlockImportance = CameraInfo.CalculateBlockImportance(OldGPUChunk.ChunkLocation, OldBlockLocation, ChunkResolution, OldGPUChunk.MipmapLevel);
+					if ((OldBlockImportance >= NewBlockImportance) || (OldGPUBlock.BlockFrameStamp >= Chunk.ChunkFrameStamp))
+					{
+						MemoryPool.IncreaseGPUBlockIndex();
+						continue;
+					}
+					else
+					{
+						OverrideBlockLocationIndex = MemoryPool.CurrentGPUBlockIndex;
+						break;
+					}
+				}
+			}
+			if (OverrideBlockLocationIndex != INT_MAX)
+			{
+				MemoryPool.IncreaseGPUBlockIndex();
+			}
+		}
+		if (OverrideBlockLocationIndex != INT_MAX)
+		{
+			FGPUBlock NewGPUBlock = { .ChunkIndex = ChunkIndex + MemoryPool.ChunkCountOffset, .BlockLocation = {NewBlock.BlockLocation, FaceMask} , .BlockFrameStamp = Chunk.ChunkFrameStamp };
+			MemoryPool.WriteBlock(OverrideBlockLocationIndex, NewGPUBlock, BlockIndex); //copy
+			ModifyBuffer.ModifyGPUBlock.push_back(std::move(NewGPUBlock)); //move
+			ModifyBuffer.ModifyGPUBlockIndex.push_back(OverrideBlockLocationIndex);
+		}
+		return OverrideBlockLocationIndex;
+	}
+	void PushToBlockPool(const FImportanceComputeInfo& CameraInfo, FTLSChunkPool& MemoryPool, const FChunk& Chunk, const uint32_t ChunkIndex, const uint32_t ChunkResolution, FTLSModifyBuffer& ModifyBuffer, const uint32_t BlockCheckTimes,
+		const FChunkNeighbourSlices& NeighbourSlices)
+	{
+		MemoryPool.RebalanceBlockPages(BlockPagePool, ModifyBuffer, CameraInfo, ChunkResolution);
+		const uint32_t MaxBlockCheckTimes = BlockCheckTimes;
+		const uint32_t CullDepthThreshold = AtomicCullDepthThreshold.load(std::memory_order_relaxed);
+		std::vector<uint8_t>& FaceMasks = MemoryPool.FaceMaskScratch;
+		Chunk.CalculateFaceMasks(NeighbourSlices, FaceMasks);
+		for (uint32_t BlockIndex = 0; BlockIndex < Chunk.Blocks.size(); BlockIndex++)
+		{
+			const FBlock& NewBlock = Chunk.Blocks[BlockIndex];
+			if (Chunk.bShouldVoxelOccupancyCull(NewBlock.BlockLocation, CullDepthThreshold))
+			{
+				continue;
+			}
+			//Border blocks are only hidden by the resident neighbours, RecullChunkBorder brings them back when a neighbour leaves
+			const bool bBorder = CullDepthThreshold > 0 && FChunk::bIsBorderVoxel(NewBlock.BlockLocation);
+			if (bBorder && FaceMasks[BlockIndex] == 0)
+			{
+				continue;
+			}
+			PushBlockToBlockPool(CameraInfo, MemoryPool, Chunk, BlockIndex, FaceMasks[BlockIndex], ChunkIndex, ChunkResolution, ModifyBuffer, MaxBlockCheckTimes);
+		}
+	}
+	//Neighbours only count at the same mip level, a coarser or finer neighbour doesn't line up voxel to voxel
+	static ivec4 GetNeighbourChunkKey(const ivec4& ChunkKey, const uint32_t Face)
+	{
+		ivec4 NeighbourKey = ChunkKey;
+		NeighbourKey[Face >> 1] += ((Face & 1) ? 1 : -1) * (1 << ChunkKey.w);
+		return NeighbourKey;
+	}
+	static ivec4 GetResidentBrickKey(const ivec4& ChunkKey, uint32_t& Bit)
+	{
+		const ivec3 Cell = ivec3(ChunkKey) >> ChunkKey.w;
+		const ivec3 Brick = Cell >> ResidentBrickShift;
+		const ivec3 Local = Cell - (Brick << ResidentBrickShift);
+		Bit = (uint32_t)(Local.x + ((Local.y + (Local.z << ResidentBrickShift)) << ResidentBrickShift));
+		return ivec4(Brick, ChunkKey.w);
+	}
+	void SetResidentChunk(const ivec4& ChunkKey, bool bSolid)
+	{
+		uint32_t Bit = 0;
+		ResidentChunkBricks.ATOMIC_update(GetResidentBrickKey(ChunkKey, Bit), [&](uint64_t& Bits)
+			{
+				Bits = bSolid ? (Bits | (1ull << Bit)) : (Bits & ~(1ull << Bit));
+				return Bits != 0;
+			});
+	}
+	bool bIsResidentChunkSolid(const ivec4& ChunkKey) const
+	{
+		uint32_t Bit = 0;
+		uint64_t Bits = 0;
+		return ResidentChunkBricks.ATOMIC_get(GetResidentBrickKey(ChunkKey, Bit), Bits) && ((Bits >> Bit) & 1ull);
+	}
+	//Resident solid chunks of the other mip levels overlapping ChunkKey, the coarser ones holding it and the finer ones inside it
+	template<typename FVisit>
+	void ForEachOverlappingResidentChunk(const ivec4& ChunkKey, const uint32_t MaxMipmapLevel, FVisit&& Visit) const
+	{
+		constexpr int32_t BrickMask = (1 << ResidentBrickShift) - 1;
+		for (int32_t MipmapLevel = 0; MipmapLevel <= (int32_t)MaxMipmapLevel; MipmapLevel++)
+		{
+			if (MipmapLevel == ChunkKey.w)
+			{
+				continue;
+			}
+			//Cells of MipmapLevel in both, a single one when it is coarser
+			const ivec3 CellBegin = ivec3(ChunkKey) >> MipmapLevel;
+			const ivec3 CellEnd = CellBegin + (MipmapLevel > ChunkKey.w ? 1 : 1 << (ChunkKey.w - MipmapLevel));
+			const ivec3 BrickBegin = CellBegin >> ResidentBrickShift;
+			const ivec3 BrickEnd = ((CellEnd - 1) >> ResidentBrickShift) + 1;
+			for (int32_t z = BrickBegin.z; z < BrickEnd.z; z++)
+			{
+				for (int32_t y = BrickBegin.y; y < BrickEnd.y; y++)
+				{
+					for (int32_t x = BrickBegin.x; x < BrickEnd.x; x++)
+					{
+						uint64_t Bits = 0;
+						if (!ResidentChunkBricks.ATOMIC_get(ivec4(x, y, z, MipmapLevel), Bits))
+						{
+							continue;
+						}
+						for (; Bits != 0; Bits &= Bits - 1)
+						{
+							const int32_t Bit = std::countr_zero(Bits);
+							const ivec3 Cell = (ivec3(x, y, z) << ResidentBrickShift) + ivec3(Bit & BrickMask, (Bit >> ResidentBrickShift) & BrickMask, Bit >> (2 * ResidentBrickShift));
+							if (Cell.x >= CellBegin.x && Cell.y >= CellBegin.y && Cell.z >= CellBegin.z && Cell.x < CellEnd.x && Cell.y < CellEnd.y && Cell.z < CellEnd.z)
+							{
+								Visit(ivec4(Cell << MipmapLevel, MipmapLevel));
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+	//Only one mip level of a place is resident: the chunks a pushed one overlaps leave the queries and the bricks at once, their owners free the rest
+	void EvictOverlappingChunks(const ivec4& ChunkKey, const uint32_t MaxMipmapLevel)
+	{
+		ForEachOverlappingResidentChunk(ChunkKey, MaxMipmapLevel, [&](const ivec4& OverlapKey)
+			{
+				FResidentChunkEntry Entry;
+				if (ResidentChunkCache.ATOMIC_extract(OverlapKey, Entry))
+				{
+					SetResidentChunk(OverlapKey, false);
+					NotifyBorderNeighbours(OverlapKey);
+					LodEvictQueues[Entry.ThreadId]->Push({ .ChunkKey = OverlapKey, .ChunkIndex = Entry.ChunkIndex });
+				}
+			});
+	}
+	//Owner side of EvictOverlappingChunks, the slot is left invalid and is the first to be reused
+	void EvictChunk(FTLSChunkPool& MemoryPool, const FChunkSlotRequest& Request, FTLSModifyBuffer& ModifyBuffer)
+	{
+		FChunk& Chunk = MemoryPool.ChunksPool[Request.ChunkIndex];
+		if (!Chunk.bIsValid() || Chunk.GetChunkKey() != Request.ChunkKey)//Replaced meanwhile
+		{
+			return;
+		}
+		ChunksLookupTable.ATOMIC_remove(Request.ChunkKey);
+		MemoryPool.FreeChunkBlocks(Request.ChunkIndex, BlockPagePool, ModifyBuffer);
+		Chunk = FChunk();
+		MemoryPool.ChunkEvictionIndex.Heap.Set(Request.ChunkIndex, MemoryPool.ChunkEvictionIndex.GetKey(Chunk));
+		MemoryPool.SubCurrentDebugDrawInstanceCount--;
+		//No block can match the stamp any more
+		const FGPUChunk InvalidGPUChunk = { .ChunkFrameStamp = UINT32_MAX };
+		ModifyBuffer.ModifyGPUChunkIndex = Request.ChunkIndex;
+		ModifyBuffer.ModifyGPUChunk = InvalidGPUChunk;
+		MemoryPool.GPUChunksPool[Request.ChunkIndex] = InvalidGPUChunk;
+		const FGPUSimpleInstanceData InvalidInstanceData = { .ChunkLocation = {INT_MAX,INT_MAX,INT_MAX} };
+		ModifyBuffer.ModifyGPUInstanceIndex = Request.ChunkIndex;
+		ModifyBuffer.ModifyGPUInstance = InvalidInstanceData;
+		MemoryPool.GPUInstanceData[Request.ChunkIndex] = InvalidInstanceData;
+	}
+	//Resident chunk of any mip level covering the level 0 chunk, else the largest aligned cube (in level 0 chunks) known to hold nothing resident.
+	//Only solid chunks are in the cache and their brick bit says so, a level without one costs a single shared lock
+	FChunkRayLookup FindRayChunk(const ivec3& ChunkLocation, const uint32_t MaxMipmapLevel) const
+	{
+		FChunkRayLookup Lookup;
+		bool bBrickEmpty = true;
+		for (uint32_t MipmapLevel = 0; MipmapLevel <= MaxMipmapLevel; MipmapLevel++)
+		{
+			const ivec4 ChunkKey = ivec4((ChunkLocation >> (int32_t)MipmapLevel) << (int32_t)MipmapLevel, (int32_t)MipmapLevel);
+			uint32_t Bit = 0;
+			uint64_t Bits = 0;
+			if (!ResidentChunkBricks.ATOMIC_get(GetResidentBrickKey(ChunkKey, Bit), Bits))
+			{
+				continue;
+			}
+			bBrickEmpty = false;
+			FResidentChunkEntry Entry;
+			if (((Bits >> Bit) & 1ull) && ResidentChunkCache.ATOMIC_get(ChunkKey, Entry))
+			{
+				Lookup.Data = std::move(Entry.Data);
+				return Lookup;
+			}
+		}
+		Lookup.EmptyCubeShift = bBrickEmpty ? ResidentBrickShift : 0;
+		return Lookup;
+	}
+	//Facing slices of the resident neighbours, Entries keeps them alive while NeighbourSlices points into them
+	void GatherNeighbourSlices(const ivec4& ChunkKey, std::array<FResidentChunkEntry, ChunkFaceNum>& Entries, FChunkNeighbourSlices& NeighbourSlices) const
+	{
+		for (uint32_t Face = 0; Face < ChunkFaceNum; Face++)
+		{
+			NeighbourSlices[Face] = nullptr;
+			if (ResidentChunkCache.ATOMIC_get(GetNeighbourChunkKey(ChunkKey, Face), Entries[Face]) && Entries[Face].Data)
+			{
+				NeighbourSlices[Face] = &Entries[Face].Data->BorderSlices[Face ^ 1];
+			}
+		}
+	}
+	//Tell the owners of the resident neighbours to re-cull their border shells against us
+	void NotifyBorderNeighbours(const ivec4& ChunkKey)
+	{
+		for (uint32_t Face = 0; Face < ChunkFaceNum; Face++)
+		{
+			const ivec4 NeighbourKey = GetNeighbourChunkKey(ChunkKey, Face);
+			FResidentChunkEntry Entry;
+			if (ResidentChunkCache.ATOMIC_get(NeighbourKey, Entry))
+			{
+				BorderRecullQueues[Entry.ThreadId]->Push({ .ChunkKey = NeighbourKey, .ChunkIndex = Entry.ChunkIndex });
+			}
+		}
+	}
+	//Evicts border blocks the neighbours hide now, pushes back the ones they stopped hiding and refreshes the face masks of the rest
+	void RecullChunkBorder(const FImportanceComputeInfo& CameraInfo, FTLSChunkPool& MemoryPool, const FChunkSlotRequest& Request, const uint32_t ChunkResolution, FTLSModifyBuffer& ModifyBuffer)
+	{
+		const FChunk& Chunk = MemoryPool.ChunksPool[Request.ChunkIndex];
+		if (!Chunk.bIsValid() || Chunk.GetChunkKey() != Request.ChunkKey)//Replaced meanwhile
+		{
+			return;
+		}
+		const uint32_t MaxBlockCheckTimes_ = MaxBlockCheckTimes;
+		const uint32_t CullDepthThreshold = AtomicCullDepthThreshold.load(std::memory_order_relaxed);
+		const bool bCull = CullDepthThreshold > 0;
+		std::array<FResidentChunkEntry, ChunkFaceNum> Entries;
+		FChunkNeighbourSlices NeighbourSlices;
+		GatherNeighbourSlices(Request.ChunkKey, Entries, NeighbourSlices);
+		//Find the resident border blocks through the chunk's slots, nothing is kept for them between re-culls
+		std::vector<uint32_t>& BorderSlots = MemoryPool.BorderSlotScratch;
+		MemoryPool.ForEachChunkBlockSlot(Request.ChunkIndex, [&](const uint32_t Slot)
+			{
+				const uint32_t BlockIndex = MemoryPool.BlockSlotLinks[Slot].BlockIndex;
+				if (FChunk::bIsBorderVoxel(Chunk.Blocks[BlockIndex].BlockLocation))
+				{
+					BorderSlots[BlockIndex] = Slot;
+				}
+			});
+		const uint32_t GPUChunkIndex = Request.ChunkIndex + MemoryPool.ChunkCountOffset;
+		for (uint32_t BlockIndex = 0; BlockIndex < Chunk.Blocks.size(); BlockIndex++)
+		{
+			const FBlock& Block = Chunk.Blocks[BlockIndex];
+			if (!FChunk::bIsBorderVoxel(Block.BlockLocation) || Chunk.bShouldVoxelOccupancyCull(Block.BlockLocation, CullDepthThreshold))
+			{
+				continue;
+			}
+			const uint8_t FaceMask = Chunk.GetFaceMask(Block.BlockLocation, NeighbourSlices);
+			const bool bHidden = bCull && FaceMask == 0;
+			const uint32_t Slot = BorderSlots[BlockIndex];
+			BorderSlots[BlockIndex] = INT_MAX;
+			//A push below may have taken or handed back the slot of a block we haven't reached yet
+			const bool bResident = Slot < MemoryPool.GPUBlockPool.size() && MemoryPool.GPUBlockPool[Slot].ChunkIndex == GPUChunkIndex && MemoryPool.BlockSlotLinks[Slot].BlockIndex == BlockIndex;
+			if (bHidden && bResident)
+			{
+				ModifyBuffer.ModifyGPUBlock.push_back(FGPUBlock());
+				ModifyBuffer.ModifyGPUBlockIndex.push_back(Slot);
+				MemoryPool.FreeBlockSlot(Slot, BlockPagePool, ModifyBuffer);
+			}
+			else if (!bHidden && !bResident)
+			{
+				PushBlockToBlockPool(CameraInfo, MemoryPool, Chunk, BlockIndex, FaceMask, Request.ChunkIndex, ChunkResolution, ModifyBuffer, MaxBlockCheckTimes_);
+			}
+			else if (bResident && MemoryPool.GPUBlockPool[Slot].BlockLocation.w != FaceMask)
+			{
+				FGPUBlock& GPUBlock = MemoryPool.GPUBlockPool[Slot];
+				GPUBlock.BlockLocation.w = FaceMask;
+				ModifyBuffer.ModifyGPUBlock.push_back(GPUBlock);
+				ModifyBuffer.ModifyGPUBlockIndex.push_back(Slot);
+			}
+		}
+	}
+	void PushModifyBuffer(FTLSChunkPool::FModifyBufferQueue& ModifyQueue, FTLSModifyBuffer&& ModifyBuffer)
+	{
+		if (ModifyBuffer.bEmpty())
+		{
+			ModifyQueue.Recycle(std::move(ModifyBuffer));
+			return;
+		}
+		ModifyQueue.Push(std::move(ModifyBuffer));
+		AtomicPushVersion.fetch_add(1, std::memory_order_release);
+	}
+	//Drain this thread's evictions and re-cull requests, they change the blocks in their own modify buffers so a failed push can't drop them.
+	//An eviction has a buffer of its own, a buffer holds one GPU chunk
+	void ProcessChunkSlotRequests(const uint32_t ThreadId, const FImportanceComputeInfo& CameraInfo, const uint32_t ChunkResolution)
+	{
+		FTLSChunkPool::FModifyBufferQueue& ModifyQueue = *TLSChunkPoolModifyBufferQueue[ThreadId];
+		FChunkSlotRequest Request;
+		while (LodEvictQueues[ThreadId]->Pop(Request))
+		{
+			FTLSModifyBuffer ModifyBuffer = ModifyQueue.Acquire();
+			EvictChunk(TLSChunkPool[ThreadId], Request, ModifyBuffer);
+			PushModifyBuffer(ModifyQueue, std::move(ModifyBuffer));
+		}
+		FTLSModifyBuffer ModifyBuffer = ModifyQueue.Acquire();
+		while (BorderRecullQueues[ThreadId]->Pop(Request))
+		{
+			RecullChunkBorder(CameraInfo, TLSChunkPool[ThreadId], Request, ChunkResolution, ModifyBuffer);
+		}
+		PushModifyBuffer(ModifyQueue, std::move(ModifyBuffer));
+	}
+	//Once a frame, a thread that stopped pushing still gets its requests done. A pool being pushed to is skipped, its push drains them
+	void ProcessIdleChunkSlotRequests(const FImportanceComputeInfo& CameraInfo, const uint32_t ChunkResolution)
+	{
+		for (uint32_t ThreadId = 0; ThreadId < ThreadCount; ThreadId++)
+		{
+			if (LodEvictQueues[ThreadId]->Size() == 0 && BorderRecullQueues[ThreadId]->Size() == 0)
+			{
+				continue;
+			}
+			std::unique_lock<std::mutex> Lock(*WritingPoolLocks[ThreadId], std::try_to_lock);
+			if (Lock.owns_lock())
+			{
+				ProcessChunkSlotRequests(ThreadId, CameraInfo, ChunkResolution);
+			}
+		}
+	}
+template<typename T>
+inline void PushToPool(uint32_t MaxChunkCount, const uint32_t ThreadId, FTLSChunkPool& MemoryPool, FTLSChunkPool::FModifyBufferQueue& ModifyQueue,
+	const uint32_t BlockCheckTimes, T&& NewItem, const EChunkState& NewState,
+	const FImportanceComputeInfo& CameraInfo, const uint32_t ChunkResolution, const float ChunkSize, const EChunkOverrideMode& OverrideMode)
+	{
+		static_assert(std::is_base_of_v<FChunkBase, T>, "T must be derived from FChunkBase");
+		const ivec3 NewLocation = NewItem.ChunkLocation;
+		const ivec4 NewKey = NewItem.GetChunkKey();
+		auto NewImportance = CameraInfo.CalculateChunkImportance(NewLocation, NewItem.MipmapLevel);
+
+		auto HelperGetSlots = [&]() -> std::vector<T>&
+			{
+				if constexpr (std::is_same_v<T, FChunk>) { return MemoryPool.ChunksPool; }
+				else { return MemoryPool.EmptyChunksPool; }
+			};
+		auto HelperGetEvictionIndex = [&]() -> FChunkEvictionIndex&
+			{
+				if constexpr (std::is_same_v<T, FChunk>) { return MemoryPool.ChunkEvictionIndex; }
+				else { return MemoryPool.EmptyChunkEvictionIndex; }
+			};
+		auto GetCurrentGPUInstanceIndex = [&](uint32_t Index) -> uint32_t
+			{
+				if constexpr (std::is_same_v<T, FChunk>) { return Index; }
+				else { return MemoryPool.SubMaxChunkCount + Index; }
+			};
+		// Never used slots first, then the least important chunk not stamped this frame.
+		// FindLess and FindMin both get the true minimum, OverrideMin also takes it when it is more important than the new chunk
+		std::vector<T>& Slots = HelperGetSlots();
+		FChunkEvictionIndex& EvictionIndex = HelperGetEvictionIndex();
+		ivec4 OverrideOldKey;
+		bool OverrideInvalidIndex = false;
+		uint32_t OverrideLocationIndex = INT_MAX;
+		FTLSModifyBuffer ModifyBuffer = ModifyQueue.Acquire();
+		if (EvictionIndex.FilledNum < (uint32_t)Slots.size())
+		{
+			OverrideLocationIndex = EvictionIndex.FilledNum++;
+			OverrideInvalidIndex = true;
+			OverrideOldKey = Slots[OverrideLocationIndex].GetChunkKey();
+		}
+		else
+		{
+			const auto [Victim, VictimImportance] = EvictionIndex.FindVictim(Slots, CameraInfo, NewItem.ChunkFrameStamp);
+			if (Victim != INT_MAX && ((VictimImportance < NewImportance) || (OverrideMode == EChunkOverrideMode::OverrideMin)))
+			{
+				OverrideLocationIndex = Victim;
+				OverrideOldKey = Slots[OverrideLocationIndex].GetChunkKey();
+			}
+		}
+		if (OverrideLocationIndex != INT_MAX)
+		{
+			if (!Slots[OverrideLocationIndex].bIsValid())//Never used or evicted
+			{
+				MemoryPool.SubCurrentDebugDrawInstanceCount++;
+			}
+			auto& CurrentChunk = Slots[OverrideLocationIndex];
+			ChunksLookupTable.ATOMIC_remove_and_insert(OverrideOldKey, NewKey, NewState);
+			// Replaced chunk no longer hides its neighbours or fills its brick
+			if constexpr (std::is_same_v<T, FChunk>)
+			{
+				if (!OverrideInvalidIndex && ResidentChunkCache.ATOMIC_remove_by_condition(OverrideOldKey,
+					[&](const FResidentChunkEntry& Entry) { return Entry.ThreadId == ThreadId && Entry.ChunkIndex == OverrideLocationIndex; }))
+				{
+					SetResidentChunk(OverrideOldKey, false);
+					NotifyBorderNeighbours(OverrideOldKey);
+				}
+				if (!OverrideInvalidIndex)
+				{
+					MemoryPool.FreeChunkBlocks(OverrideLocationIndex, BlockPagePool, ModifyBuffer);
+				}
+			}
+			// Modify debug gpu instance
+			{
+				FGPUSimpleInstanceData NewInstanceData =
+				{
+					.Position = {ChunkSize,ChunkSize,ChunkSize},
+					.ChunkLocation = NewLocation,
+					.Scale = ChunkSize * (float)(1u << NewItem.MipmapLevel) * 0.1f,
+					.Marker = (std::is_same_v<T, FChunk>) ? 1.0f : 0.0f,
+				};
+				ModifyBuffer.ModifyGPUInstance = NewInstanceData; //copy
+				ModifyBuffer.ModifyGPUInstanceIndex = GetCurrentGPUInstanceIndex(OverrideLocationIndex);
+				MemoryPool.GPUInstanceData[ModifyBuffer.ModifyGPUInstanceIndex] = std::move(NewInstanceData); //move
+			}
+			// Modify GPU Chunk
+			{
+				if constexpr (std::is_same_v<T, FChunk>)
+				{
+					FGPUChunk NewGPUChunk = { .ChunkLocation = NewLocation, .ChunkFrameStamp = NewItem.ChunkFrameStamp, .MipmapLevel = NewItem.MipmapLevel };
+					ModifyBuffer.ModifyGPUChunkIndex = OverrideLocationIndex;
+					ModifyBuffer.ModifyGPUChunk = NewGPUChunk; //copy
+					MemoryPool.GPUChunksPool[ModifyBuffer.ModifyGPUChunkIndex] = std::move(NewGPUChunk); //move
+				}
+			}
+			// Modify Chunk, only the writing pool keeps it
+			{
+				CurrentChunk = std::move(NewItem); // Move
+				EvictionIndex.Heap.Set(OverrideLocationIndex, EvictionIndex.GetKey(CurrentChunk));
+			}
+			// Modify Block
+			{
+				if constexpr (std::is_same_v<T, FChunk>)
+				{
+					// Publish our slices before reading the neighbours', whichever of two neighbours comes second sees the first
+					ResidentChunkCache.ATOMIC_insert(NewKey, { .Data = MemoryPool.UpdateChunkQueryData(OverrideLocationIndex, CurrentChunk), .ThreadId = ThreadId, .ChunkIndex = OverrideLocationIndex });
+					SetResidentChunk(NewKey, CurrentChunk.OccupancyPyramid.bAny());
+					std::array<FResidentChunkEntry, ChunkFaceNum> NeighbourEntries;
+					FChunkNeighbourSlices NeighbourSlices;
+					GatherNeighbourSlices(NewKey, NeighbourEntries, NeighbourSlices);
+					PushToBlockPool(
+						CameraInfo, MemoryPool, CurrentChunk, OverrideLocationIndex,
+						ChunkResolution, ModifyBuffer, BlockCheckTimes, NeighbourSlices);
+					NotifyBorderNeighbours(NewKey);
+				}
+			}
+			// Push modify buffer to front
+			ModifyQueue.Push(std::move(ModifyBuffer));
+			// Mark dirty
+			AtomicPushVersion.fetch_add(1, std::memory_order_release);
+			// Other mip levels of the place go
+			EvictOverlappingChunks(NewKey, CameraInfo.MaxChunkMipmapLevel);
+			return;
+		}
+		else
+		{
+			//Fail
+			ChunksLookupTable.ATOMIC_remove(NewKey); //Remove new reserved location
+			ModifyQueue.Recycle(std::move(ModifyBuffer));
+		}
+	}
+	inline void PushChunk(FChunk&& NewChunk, const uint32_t ThreadId, const uint32_t FrameStamp, const uint32_t ChunkResolution, const FImportanceComputeInfo& CameraInfo, const float ChunkSize, const EChunkOverrideMode OverrideMode)
+	{
+		FChunk NewChunk_ = std::move(NewChunk);
+		NewChunk_.ChunkFrameStamp = FrameStamp;
+		std::lock_guard<std::mutex> Lock(*WritingPoolLocks[ThreadId]);
+		PushToPool<FChunk>(MaxChunkCount, ThreadId, TLSChunkPool[ThreadId], *TLSChunkPoolModifyBufferQueue[ThreadId], MaxBlockCheckTimes, std::move(NewChunk_), EChunkState::NonEmpty, CameraInfo, ChunkResolution, ChunkSize, OverrideMode);
+		ProcessChunkSlotRequests(ThreadId, CameraInfo, ChunkResolution);
+	}
+	inline void PushEmptyChunk(FEmptyChunk&& NewEmptyChunk, const uint32_t ThreadId, const uint32_t FrameStamp, const uint32_t ChunkResolution, const FImportanceComputeInfo& CameraInfo, const float ChunkSize, const EChunkOverrideMode OverrideMode)
+	{
+		FEmptyChunk NewEmptyChunk_ = std::move(NewEmptyChunk);
+		NewEmptyChunk_.ChunkFrameStamp = FrameStamp;
+		std::lock_guard<std::mutex> Lock(*WritingPoolLocks[ThreadId]);
+		PushToPool<FEmptyChunk>(MaxEmptyChunkCount, ThreadId, TLSChunkPool[ThreadId], *TLSChunkPoolModifyBufferQueue[ThreadId], MaxBlockCheckTimes, std::move(NewEmptyChunk_), EChunkState::Empty, CameraInfo, ChunkResolution, ChunkSize, OverrideMode);
+		ProcessChunkSlotRequests(ThreadId, CameraInfo, ChunkResolution);
+	}
+	inline uint32_t GetFrameStamp()
+	{
+		return FChunkManageHelper::TruncateFrameStamp(AtomicVisibilityChunkFrameStamp);
+	}
+	//
+	//
+	void GatherDebugInstanceInfo(const FVoxelSceneConfig& VoxelSceneConfig) // this can also be done in multi-thread
+	{
+		CurrentDebugDrawInstanceCount = 0;
+		CurrentBlockCount = 0;
+		UploadVersion++;
+		for (uint32_t i = 0; i < ThreadCount; i++)
+		{
+			TLSChunkPoolModifyBufferQueue[i]->Swap();
+			TLSChunkPoolRead[i].ConsumeQueue(*TLSChunkPoolModifyBufferQueue[i], UploadVersion);
+			CurrentDebugDrawInstanceCount += TLSChunkPool[i].SubCurrentDebugDrawInstanceCount;
+			CurrentBlockCount += TLSChunkPool[i].SubCurrentBlockCount;
+		}
+	}
+	//Sends the coalesced spans and clears them, Upload(const void* Data, size_t Size, size_t Offset) in bytes
+	template<typename T, typename FUpload>
+	static void UploadSpans(FDirtySpans& Spans, const std::vector<T>& Data, const uint32_t Offset, const uint32_t GapBytes, FUpload&& Upload)
+	{
+		Spans.Coalesce(GapBytes / sizeof(T));
+		for (const FIndexSpan& Span : Spans.GetSpans())
+		{
+			Upload(Data.data() + Span.Begin, sizeof(T) * (Span.End - Span.Begin), sizeof(T) * ((size_t)Offset + Span.Begin));
+		}
+		Spans.Clear();
+	}
+	//Block spans are cut at the pages, each one comes from the page's owner or is cleared
+	template<typename FUpload>
+	static void UploadBlockSpans(FDirtySpans& Spans, const std::vector<FTLSChunkPool>& Pools, const std::vector<FBlockPageOwner>& Owners, const std::vector<FGPUBlock>& InvalidBlockPage,
+		const uint32_t PageSize, const uint32_t GapBytes, FUpload&& Upload)
 	{
-		const uint32_t QueueSize = Queue.Size();
-		for (uint32_t i = 0; i < QueueSize; i++)
+		Spans.Coalesce(GapBytes / sizeof(FGPUBlock));
+		for (const FIndexSpan& Span : Spans.GetSpans())
 		{
-			FTLSModifyBuffer CurrentModifyBuffer;
-			if (!Queue.Pop(CurrentModifyBuffer))
+			for (uint32_t Begin = Span.Begin; Begin < Span.End;)
 			{
-				break;
-			}
-			if (CurrentModifyBuffer.ModifyChunkIndex != INT_MAX)
-			{
-				ChunksPool[CurrentModifyBuffer.ModifyChunkIndex] = CurrentModifyBuffer.ModifyChunk;//todo:move
-			}
-			if (CurrentModifyBuffer.ModifyEmptyChunkIndex != INT_MAX)
-			{
-				EmptyChunksPool[CurrentModifyBuffer.ModifyEmptyChunkIndex] = CurrentModifyBuffer.ModifyEmptyChunk;
-			}
-			if (CurrentModifyBuffer.ModifyGPUChunkIndex != INT_MAX)
-			{
-				GPUChunksPool[CurrentModifyBuffer.ModifyGPUChunkIndex] = CurrentModifyBuffer.ModifyGPUChunk;
-			}
-			if (CurrentModifyBuffer.ModifyGPUInstanceIndex != INT_MAX)
-			{
-				GPUInstanceData[CurrentModifyBuffer.ModifyGPUInstanceIndex] = CurrentModifyBuffer.ModifyGPUInstance;
-			}
-			for (uint32_t i = 0; i < CurrentModifyBuffer.ModifyGPUBlock.size(); i++)
-			{
-				GPUBlockPool[CurrentModifyBuffer.ModifyGPUBlockIndex[i]] = CurrentModifyBuffer.ModifyGPUBlock[i];
+				const uint32_t Page = Begin / PageSize;
+				const uint32_t End = std::min(Span.End, (Page + 1) * PageSize);
+				const uint32_t PageOffset = Begin - Page * PageSize;
+				const bool bOwned = Page < Owners.size() && Owners[Page].ThreadId != INT_MAX;
+				const FGPUBlock* Data = bOwned ? Pools[Owners[Page].ThreadId].GPUBlockPool.data() + (size_t)Owners[Page].LocalPage * PageSize + PageOffset : InvalidBlockPage.data() + PageOffset;
+				Upload(Data, sizeof(FGPUBlock) * (End - Begin), sizeof(FGPUBlock) * (size_t)Begin);
+				Begin = End;
 			}
 		}
+		Spans.Clear();
 	}
-	void IncreaseChunkIndex()
+	//What the frame's buffers missed in one pool's log
+	FDirtySpans& GatherUploadSpans(const FVersionedSpanLog& Log, uint32_t RenderFrameIndex_)
 	{
-		CurrentChunkIndex = (CurrentChunkIndex + 1) % SubMaxChunkCount;
+		UploadSpansScratch.Clear();
+		Log.Gather(FrameUploadVersion[RenderFrameIndex_], UploadSpansScratch);
+		return UploadSpansScratch;
 	}
-	void IncreaseEmptyChunkIndex()
+	void TruncateUploadLogs()
 	{
-		CurrentEmptyChunkIndex = (CurrentEmptyChunkIndex + 1) % SubMaxEmptyChunkCount;
+		const uint64_t Version = *std::min_element(FrameUploadVersion.begin(), FrameUploadVersion.end());
+		for (FTLSChunkPool& ReadPool : TLSChunkPoolRead)
+		{
+			ReadPool.GPUChunkLog.Truncate(Version);
+			ReadPool.GPUInstanceLog.Truncate(Version);
+			ReadPool.GPUBlockLog.Truncate(Version);
+		}
 	}
-	void IncreaseGPUBlockIndex()
+	//Newest owner of every block page, a page changing hands is in both reading pools until both their queues are consumed
+	static void ResolveBlockPageOwners(const std::vector<FTLSChunkPool>& Pools, const uint32_t PageNum, std::vector<FBlockPageOwner>& Owners)
 	{
-		CurrentGPUBlockIndex = (CurrentGPUBlockIndex + 1) % SubMaxBlockCount;
+		Owners.assign(PageNum, FBlockPageOwner());
+		for (uint32_t i = 0; i < Pools.size(); i++)
+		{
+			for (uint32_t LocalPage = 0; LocalPage < Pools[i].BlockPages.size(); LocalPage++)
+			{
+				const uint32_t Page = Pools[i].BlockPages[LocalPage];
+				if (Page != INT_MAX && (Owners[Page].ThreadId == INT_MAX || Pools[i].BlockPageStamps[LocalPage] > Owners[Page].Stamp))
+				{
+					Owners[Page] = { .ThreadId = i, .LocalPage = LocalPage, .Stamp = Pools[i].BlockPageStamps[LocalPage] };
+				}
+			}
+		}
 	}
 };
-class FChunkPool
+//The pools plus their GPU buffers and the debug draw
+class FChunkPool : public FChunkPoolCore
 {
 public:
-	std::vector<FTLSChunkPool> TLSChunkPool;
-	std::vector<std::unique_ptr<FTLSChunkPool::FModifyBufferQueue>> TLSChunkPoolModifyBufferQueue;
-	std::vector<FTLSChunkPool> TLSChunkPoolRead;
-	uint32_t ThreadCount = 0;
-	//For multi thread
-	using FChunkLookupTable = TThreadSafeMap<ivec3, EChunkState, FIVec3Comparator>;
-	FChunkLookupTable ChunksLookupTable; 
-	// Before computing, mark as COMPUTING
-	// After computing, mask as NonEmpty/Empty
-	// Before reading, [threadsafe] read if not computing then mark as reading
-	// read
-	// After reading, set to original
-	std::atomic<uint64_t> AtomicVisibilityChunkFrameStamp = 0;
-	//Constant
-	uint32_t MaxChunkCount = 0;
-	uint32_t MaxEmptyChunkCount = 0;
-	uint32_t MaxBlockCount = 0;
-	//Try
-	uint32_t MaxChunkCheckTimes = 0;
-	uint32_t MaxEmptyChunkCheckTimes = 0;
-	uint32_t MaxBlockCheckTimes = 0;
-
-	//Runtime
-	TAtomicVector<bool> bAtomicDebugVisibleChunkDirty;
-	TAtomicVector<bool> bAtomicVisibleChunkDirty;
 	//Debug
 	inline static std::string DebugMarkGatherVisibleChunk = "GatherVisibleChunk";
 	inline static std::string DebugMarkUploadVisibleChunk = "UploadVisibleChunk";
@@ -225,76 +1354,18 @@ public:
 	
 	FOctahedronHolder OctahedronMesh;
 
-	uint32_t CurrentDebugDrawInstanceCount = 0;
-	uint32_t CurrentBlockCount = 0;
-
 	inline static uint32_t LockOffset = 63;
 	// Debug
 	FTimerSet DebugTimerSet;
 	bool bDebugGatherChunk = true;
 	bool DebugReverseZ = true;
-	//Buffer Num
-	uint32_t BufferedFramesNum = 1;
-	FChunkPool()
-	{
-
-	}
-	uint64_t AtomicGetCurrentChunkFrameStamp() const
-	{
-		return AtomicVisibilityChunkFrameStamp.load();
-	}
-	void IncreaseFrameStamp()
-	{
-		AtomicVisibilityChunkFrameStamp.fetch_add(1);
-	}
 	void Initialize(lvk::IContext* LVKContext, const FVoxelSceneConfig& VoxelSceneConfig, uint32_t ThreadCount_, bool DebugReverseZ_ = true, uint32_t BufferedFramesNum_ = 1)
 	{
 		DebugReverseZ = DebugReverseZ_;
-		BufferedFramesNum = BufferedFramesNum_;
-		ThreadCount = ThreadCount_;
-		AtomicVisibilityChunkFrameStamp.store(0);
-		MaxChunkCount = VoxelSceneConfig.MaxChunkCount;
-		MaxEmptyChunkCount = VoxelSceneConfig.MaxEmptyChunkCount;
-		MaxBlockCount = VoxelSceneConfig.MaxBlockCount;
-
-		TLSChunkPool.resize(ThreadCount);
-		TLSChunkPoolRead.resize(ThreadCount);
-		for (size_t i = 0; i < ThreadCount; ++i) 
-		{
-			TLSChunkPoolModifyBufferQueue.push_back(std::make_unique<FTLSChunkPool::FModifyBufferQueue>());
-		}
-		uint32_t AvgSubMaxChunkCount = MaxChunkCount / ThreadCount;
-		uint32_t AvgSubMaxEmptyChunkCount = MaxEmptyChunkCount / ThreadCount;
-		uint32_t AvgSubMaxBlockCount = MaxBlockCount / ThreadCount;
-
-		MaxChunkCheckTimes = std::max(1u, VoxelSceneConfig.MaxChunkCheckTimes);
-		MaxEmptyChunkCheckTimes = std::max(1u, VoxelSceneConfig.MaxEmptyChunkCheckTimes);
-		MaxBlockCheckTimes = std::max(1u, VoxelSceneConfig.MaxBlockCheckTimes);
-		for (uint32_t i = 0; i < ThreadCount; i++)
-		{
-			uint32_t SubMaxChunkCountStart = AvgSubMaxChunkCount * i;
-			uint32_t SubMaxChunkCountEnd = (i == ThreadCount - 1) ? std::max(AvgSubMaxChunkCount * (i + 1), MaxChunkCount) : AvgSubMaxChunkCount * (i + 1);
-
-			uint32_t SubMaxEmptyChunkCountStart = AvgSubMaxEmptyChunkCount * i;
-			uint32_t SubMaxEmptyChunkCountEnd = (i == ThreadCount - 1) ? std::max(AvgSubMaxEmptyChunkCount * (i + 1), MaxEmptyChunkCount) : AvgSubMaxEmptyChunkCount * (i + 1);
-
-			uint32_t SubMaxMaxBlockCountStart = AvgSubMaxBlockCount * i;
-			uint32_t SubMaxMaxBlockCountEnd = (i == ThreadCount - 1) ? std::max(AvgSubMaxBlockCount * (i + 1), MaxBlockCount) : AvgSubMaxBlockCount * (i + 1);
-
-			TLSChunkPool[i].Initialize(
-				(SubMaxChunkCountEnd - SubMaxChunkCountStart), (SubMaxEmptyChunkCountEnd - SubMaxEmptyChunkCountStart), (SubMaxMaxBlockCountEnd - SubMaxMaxBlockCountStart),
-				SubMaxChunkCountStart, SubMaxEmptyChunkCountStart, SubMaxMaxBlockCountStart);
-			TLSChunkPoolRead[i].Initialize(
-				(SubMaxChunkCountEnd - SubMaxChunkCountStart), (SubMaxEmptyChunkCountEnd - SubMaxEmptyChunkCountStart), (SubMaxMaxBlockCountEnd - SubMaxMaxBlockCountStart),
-				SubMaxChunkCountStart, SubMaxEmptyChunkCountStart, SubMaxMaxBlockCountStart);
-		}
-		//
+		InitializePools(VoxelSceneConfig, ThreadCount_, BufferedFramesNum_);
 		//For Debug
 		OctahedronMesh.Initialize(LVKContext);
 		//
-		bAtomicDebugVisibleChunkDirty.Initialize(BufferedFramesNum);
-		bAtomicVisibleChunkDirty.Initialize(BufferedFramesNum);
-		//
 		DebugInstanceBuffer.clear();
 		for (uint32_t i = 0; i < BufferedFramesNum; i++)
 		{
@@ -378,303 +1449,41 @@ public:
 		};
 		RPLDebugInstance = LVKContext->createRenderPipeline(DebugInstanceDescriptor, nullptr);
 	}
-	void PushToBlockPool(const FImportanceComputeInfo& CameraInfo, FTLSChunkPool& MemoryPool, const FChunk& Chunk, const uint32_t ChunkIndex, const uint32_t ChunkResolution, FTLSModifyBuffer& ModifyBuffer, const uint32_t BlockCheckTimes)
-	{
-		//Todo: Invalid old block, then ...
-		const uint32_t MaxBlockCheckTimes = std::min(MemoryPool.SubMaxBlockCount, BlockCheckTimes);
-		for (auto& NewBlock : Chunk.Blocks)
-		{
-			if (Chunk.bShouldVoxelOccupancyCull(NewBlock.BlockLocation, 1)) //TODO: Read config
-			{
-				continue;
-			}
-			uint32_t OverrideBlockLocationIndex = INT_MAX;
-			bool OverrideInvalidIndex = false;
-			const float NewBlockImportance = CameraInfo.CalculateBlockImportance(Chunk.ChunkLocation, { NewBlock.BlockLocation.x, NewBlock.BlockLocation.y, NewBlock.BlockLocation.z }, ChunkResolution);
-			for (uint32_t i = 0; i < MaxBlockCheckTimes; i++)
-			{
-				auto& OldGPUBlock = MemoryPool.GPUBlockPool[MemoryPool.CurrentGPUBlockIndex];
-				if (OldGPUBlock.ChunkIndex == INT_MAX || MemoryPool.GPUChunksPool[OldGPUBlock.ChunkIndex - MemoryPool.ChunkCountOffset].ChunkFrameStamp != OldGPUBlock.BlockFrameStamp)//Invalid
-				{
-					OverrideInvalidIndex = OldGPUBlock.ChunkIndex == INT_MAX;
-					OverrideBlockLocationIndex = MemoryPool.CurrentGPUBlockIndex;
-					break;
-				}
-				else//Valid
-				{
-					//Calculate importance
-					const ivec3 OldChunkLocation = MemoryPool.GPUChunksPool[OldGPUBlock.ChunkIndex - MemoryPool.ChunkCountOffset].ChunkLocation;
-					const u8vec3 OldBlockLocation = { NewBlock.BlockLocation.x, NewBlock.BlockLocation.y, NewBlock.BlockLocation.z };
-					const float OldBlockImportance = CameraInfo.CalculateBlockImportance(OldChunkLocation, OldBlockLocation, ChunkResolution);
-					if ((OldBlockImportance >= NewBlockImportance) || (OldGPUBlock.BlockFrameStamp >= Chunk.ChunkFrameStamp))
-					{
-						MemoryPool.IncreaseGPUBlockIndex();
-						continue;
-					}
-					else
-					{
-						OverrideInvalidIndex = false;
-						OverrideBlockLocationIndex = MemoryPool.CurrentGPUBlockIndex;
-						break;
-					}
-				}
-				/*
-				if (OldGPUBlock.ChunkIndex == INT_MAX)//Invalid
-				{
-					OverrideInvalidIndex = true;
-					OverrideBlockLocationIndex = MemoryPool.CurrentGPUBlockIndex;
-					break;
-				}
-				MemoryPool.IncreaseGPUBlockIndex();
-				*/
-			}
-			if (OverrideBlockLocationIndex != INT_MAX)
-			{
-				if (OverrideInvalidIndex)
-				{
-					MemoryPool.SubCurrentBlockCount++;
-				}
-				//TODO: Count
-				FGPUBlock NewGPUBlock = { .ChunkIndex = ChunkIndex + MemoryPool.ChunkCountOffset, .BlockLocation = {NewBlock.BlockLocation, 255u} , .BlockFrameStamp = Chunk.ChunkFrameStamp };
-				MemoryPool.GPUBlockPool[OverrideBlockLocationIndex] = NewGPUBlock; //copy
-				ModifyBuffer.ModifyGPUBlock.push_back(std::move(NewGPUBlock)); //move
-				ModifyBuffer.ModifyGPUBlockIndex.push_back(OverrideBlockLocationIndex);
-				MemoryPool.IncreaseGPUBlockIndex();
-			}
-		}
-	}
-template<typename T>
-inline void PushToPool(uint32_t MaxChunkCount, FTLSChunkPool& MemoryPool, FTLSChunkPool::FModifyBufferQueue& ModifyQueue,
-	const uint32_t CheckTimes, const uint32_t BlockCheckTimes, T&& NewItem, const EChunkState& NewState,
-	const FImportanceComputeInfo& CameraInfo, const uint32_t ChunkResolution, const float ChunkSize, const EChunkOverrideMode& OverrideMode)
-	{
-		static_assert(std::is_base_of_v<FChunkBase, T>, "T must be derived from FChunkBase");
-		const ivec3 NewLocation = NewItem.ChunkLocation;
-		auto NewImportance = CameraInfo.CalculateChunkImportance(NewLocation);
-
-		auto HelperSetIndex = [&](uint32_t DesiredIndex)
-			{
-				if constexpr (std::is_same_v<T, FChunk>) { MemoryPool.CurrentChunkIndex = DesiredIndex; }
-				else { MemoryPool.CurrentEmptyChunkIndex = DesiredIndex; }
-			};
-		auto HelperGetChunk = [&]() -> T&
-			{
-				if constexpr (std::is_same_v<T, FChunk>) { return MemoryPool.ChunksPool[MemoryPool.CurrentChunkIndex]; }
-				else { return MemoryPool.EmptyChunksPool[MemoryPool.CurrentEmptyChunkIndex]; }
-			};
-		auto HelperIncrementIndex = [&]()
-			{
-				if constexpr (std::is_same_v<T, FChunk>) { MemoryPool.IncreaseChunkIndex(); }
-				else { MemoryPool.IncreaseEmptyChunkIndex(); }
-			};
-		auto HelperGetPoolSize = [&]() -> uint32_t
-			{
-				if constexpr (std::is_same_v<T, FChunk>) { return MemoryPool.SubMaxChunkCount; }
-				else { return MemoryPool.SubMaxEmptyChunkCount; }
-			};
-		auto HelperGetCurrentIndex = [&]()
-			{
-				if constexpr (std::is_same_v<T, FChunk>) { return MemoryPool.CurrentChunkIndex; }
-				else { return MemoryPool.CurrentEmptyChunkIndex; }
-			};
-		auto GetCurrentGPUInstanceIndex = [&](uint32_t Index) -> uint32_t
-			{
-				if constexpr (std::is_same_v<T, FChunk>) { return Index; }
-				else { return MemoryPool.SubMaxChunkCount + Index; }
-			};
-		//TODO: Merge this, now the FindLess mode
-		// OverrideMode
-		float MinImportance = 1e10;
-		ivec3 OverrideOldLocation;
-		bool OverrideInvalidIndex = false;
-		uint32_t OverrideLocationIndex = INT_MAX;
-		uint32_t FarLocationIndex = INT_MAX;
-		uint32_t NearLocationIndex = HelperGetCurrentIndex();
-		FTLSModifyBuffer ModifyBuffer;
-		const uint32_t MaxCheckTimes = std::min(HelperGetPoolSize(), CheckTimes);
-		for (uint32_t i = 0; i < MaxCheckTimes; i++)
-		{
-			auto& CurrentChunk = HelperGetChunk();
-			const ivec3 OldLocation = CurrentChunk.ChunkLocation;
-			if (CurrentChunk.FChunkBase::bIsValid())
-			{
-				const float OldImportance = CameraInfo.CalculateChunkImportance(OldLocation);
-				// If old location's importance larger than new location's
-				// If using regressive mode, even tho old chunk is more importance, it will still override the less importance one
-				if (((OldImportance >= NewImportance) && (OverrideMode != EChunkOverrideMode::OverrideMin)) || (CurrentChunk.ChunkFrameStamp >= NewItem.ChunkFrameStamp))
-				{
-					HelperIncrementIndex();
-					continue;
-				}
-				else
-				{
-					if (OverrideMode == EChunkOverrideMode::FindLess)
-					{
-						OverrideLocationIndex = HelperGetCurrentIndex();
-						OverrideOldLocation = OldLocation;
-						OverrideInvalidIndex = false;
-						break;
-					}
-					else if ((OverrideMode == EChunkOverrideMode::FindMin) || (OverrideMode == EChunkOverrideMode::OverrideMin))
-					{
-						FarLocationIndex = HelperGetCurrentIndex();
-						if (OldImportance < MinImportance)
-						{
-							OverrideLocationIndex = HelperGetCurrentIndex();
-							OverrideOldLocation = OldLocation;
-							MinImportance = OldImportance;
-							OverrideInvalidIndex = false;
-						}
-						HelperIncrementIndex();
-						continue;
-					}
-				}
-			}
-			else
-			{
-				OverrideLocationIndex = HelperGetCurrentIndex();
-				OverrideInvalidIndex = true;
-				OverrideOldLocation = OldLocation;
-				break;
-			}
-		}
-		if (OverrideLocationIndex != INT_MAX)
-		{
-			if (OverrideInvalidIndex)
-			{
-				MemoryPool.SubCurrentDebugDrawInstanceCount++;
-			}
-			HelperSetIndex(OverrideLocationIndex);
-			auto& CurrentChunk = HelperGetChunk();
-			ChunksLookupTable.ATOMIC_remove_and_insert(OverrideOldLocation, NewLocation, NewState);
-			// Modify debug gpu instance
-			{
-				FGPUSimpleInstanceData NewInstanceData =
-				{
-					.Position = {ChunkSize,ChunkSize,ChunkSize},
-					.ChunkLocation = NewLocation,
-					.Scale = ChunkSize * 0.1f,
-					.Marker = (std::is_same_v<T, FChunk>) ? 1.0f : 0.0f,
-				};
-				ModifyBuffer.ModifyGPUInstance = NewInstanceData; //copy
-				ModifyBuffer.ModifyGPUInstanceIndex = GetCurrentGPUInstanceIndex(OverrideLocationIndex);
-				MemoryPool.GPUInstanceData[ModifyBuffer.ModifyGPUInstanceIndex] = std::move(NewInstanceData); //move
-			}
-			// Modify GPU Chunk
-			{
-				if constexpr (std::is_same_v<T, FChunk>)
-				{
-					FGPUChunk NewGPUChunk = { .ChunkLocation = NewLocation, .ChunkFrameStamp = NewItem.ChunkFrameStamp};
-					ModifyBuffer.ModifyGPUChunkIndex = OverrideLocationIndex;
-					ModifyBuffer.ModifyGPUChunk = NewGPUChunk; //copy
-					MemoryPool.GPUChunksPool[ModifyBuffer.ModifyGPUChunkIndex] = std::move(NewGPUChunk); //move
-				}
-			}
-			// Modify Chunk
-			{
-				if constexpr (std::is_same_v<T, FChunk>)
-				{
-					ModifyBuffer.ModifyChunk = NewItem; //Copy
-					ModifyBuffer.ModifyChunkIndex = OverrideLocationIndex;
-				}
-				else
-				{
-					ModifyBuffer.ModifyEmptyChunk = NewItem; //Copy
-					ModifyBuffer.ModifyEmptyChunkIndex = OverrideLocationIndex;
-				}
-				CurrentChunk = std::move(NewItem); // Move
-			}
-			// Modify Block
-			{
-				if constexpr (std::is_same_v<T, FChunk>)
-				{
-					PushToBlockPool(
-						CameraInfo, MemoryPool, CurrentChunk, OverrideLocationIndex,
-						ChunkResolution, ModifyBuffer, BlockCheckTimes);
-				}
-			}
-			//
-			// Rest
-			if ((OverrideMode == EChunkOverrideMode::FindMin) || (OverrideMode == EChunkOverrideMode::OverrideMin))
-			{
-				if (FarLocationIndex != INT_MAX)
-				{
-					//HelperSetIndex(FarLocationIndex);
-					HelperSetIndex(NearLocationIndex);
-				}
-			}
-			HelperIncrementIndex();
-			// Push modify buffer to front
-			ModifyQueue.Push(std::move(ModifyBuffer));
-			// Mark dirty
-			for (uint32_t i = 0; i < BufferedFramesNum; i++)
-			{
-				bAtomicDebugVisibleChunkDirty.Set(i, true);
-				bAtomicVisibleChunkDirty.Set(i, true);
-			}
-			return;
-		}
-		else
-		{
-			//Fail
-			ChunksLookupTable.ATOMIC_remove(NewLocation); //Remove new reserved location
-		}
-	}
-	inline void PushChunk(FChunk&& NewChunk, const uint32_t ThreadId, const uint32_t FrameStamp, const uint32_t ChunkResolution, const FImportanceComputeInfo& CameraInfo, const float ChunkSize, const EChunkOverrideMode OverrideMode)
-	{
-		FChunk NewChunk_ = std::move(NewChunk);
-		NewChunk_.ChunkFrameStamp = FrameStamp;
-		PushToPool<FChunk>(MaxChunkCount, TLSChunkPool[ThreadId], *TLSChunkPoolModifyBufferQueue[ThreadId], MaxChunkCheckTimes, MaxBlockCheckTimes, std::move(NewChunk_), EChunkState::NonEmpty, CameraInfo, ChunkResolution, ChunkSize, OverrideMode);
-	}
-	inline void PushEmptyChunk(FEmptyChunk&& NewEmptyChunk, const uint32_t ThreadId, const uint32_t FrameStamp, const uint32_t ChunkResolution, const FImportanceComputeInfo& CameraInfo, const float ChunkSize, const EChunkOverrideMode OverrideMode)
-	{
-		FEmptyChunk NewEmptyChunk_ = std::move(NewEmptyChunk);
-		NewEmptyChunk_.ChunkFrameStamp = FrameStamp;
-		PushToPool<FEmptyChunk>(MaxEmptyChunkCount, TLSChunkPool[ThreadId], *TLSChunkPoolModifyBufferQueue[ThreadId], MaxEmptyChunkCheckTimes, MaxBlockCheckTimes, std::move(NewEmptyChunk_), EChunkState::Empty, CameraInfo, ChunkResolution, ChunkSize, OverrideMode);
-	}
-	inline uint32_t GetFrameStamp()
-	{
-		return FChunkManageHelper::TruncateFrameStamp(AtomicVisibilityChunkFrameStamp);
-	}
-	//
-	//
-	void GatherDebugInstanceInfo(const FVoxelSceneConfig& VoxelSceneConfig) // this can also be done in multi-thread
-	{
-		CurrentDebugDrawInstanceCount = 0;
-		CurrentBlockCount = 0;
-		for (uint32_t i = 0; i < ThreadCount; i++)
-		{
-			TLSChunkPoolModifyBufferQueue[i]->Swap();
-			TLSChunkPoolRead[i].ConsumeQueue(*TLSChunkPoolModifyBufferQueue[i]);
-			CurrentDebugDrawInstanceCount += TLSChunkPool[i].SubCurrentDebugDrawInstanceCount;
-			CurrentBlockCount += TLSChunkPool[i].SubCurrentBlockCount;
-		}
-	}
 	void UploadDebugInstanceInfo(lvk::IContext* LVKContext, uint32_t RenderFrameIndex_)
 	{
 		for (uint32_t i = 0; i < ThreadCount; i++)
 		{
-			LVKContext->upload(DebugInstanceBuffer[RenderFrameIndex_], TLSChunkPoolRead[i].GPUInstanceData.data(),
-				sizeof(FGPUSimpleInstanceData) * TLSChunkPoolRead[i].GPUInstanceData.size(), 
-				sizeof(FGPUSimpleInstanceData) * TLSChunkPoolRead[i].GPUInstanceOffset);
+			UploadSpans(GatherUploadSpans(TLSChunkPoolRead[i].GPUInstanceLog, RenderFrameIndex_), TLSChunkPoolRead[i].GPUInstanceData, TLSChunkPoolRead[i].GPUInstanceOffset, UploadMergeGapBytes,
+				[&](const void* Data, size_t Size, size_t Offset)
+				{
+					LVKContext->upload(DebugInstanceBuffer[RenderFrameIndex_], Data, Size, Offset);
+					LastUploadBytes += Size;
+				});
 		}
 	}
 	void UploadChunk(lvk::IContext* LVKContext, uint32_t RenderFrameIndex_)
 	{
 		for (uint32_t i = 0; i < ThreadCount; i++)
 		{
-			LVKContext->upload(ChunkBuffer[RenderFrameIndex_], TLSChunkPoolRead[i].GPUChunksPool.data(),
-				sizeof(FGPUChunk) * TLSChunkPoolRead[i].GPUChunksPool.size(),
-				sizeof(FGPUChunk) * TLSChunkPoolRead[i].ChunkCountOffset);
+			UploadSpans(GatherUploadSpans(TLSChunkPoolRead[i].GPUChunkLog, RenderFrameIndex_), TLSChunkPoolRead[i].GPUChunksPool, TLSChunkPoolRead[i].ChunkCountOffset, UploadMergeGapBytes,
+				[&](const void* Data, size_t Size, size_t Offset)
+				{
+					LVKContext->upload(ChunkBuffer[RenderFrameIndex_], Data, Size, Offset);
+					LastUploadBytes += Size;
+				});
 		}
 	}
 	void UploadBlock(lvk::IContext* LVKContext, uint32_t RenderFrameIndex_)
 	{
+		ResolveBlockPageOwners(TLSChunkPoolRead, BlockPagePool.Allocator.GetPageNum(), BlockPageOwners);
 		for (uint32_t i = 0; i < ThreadCount; i++)
 		{
-			LVKContext->upload(BlockBuffer[RenderFrameIndex_], TLSChunkPoolRead[i].GPUBlockPool.data(),
-				sizeof(FGPUBlock) * TLSChunkPoolRead[i].GPUBlockPool.size(),
-				sizeof(FGPUBlock) * TLSChunkPoolRead[i].BlockCountOffset);
+			UploadBlockSpans(GatherUploadSpans(TLSChunkPoolRead[i].GPUBlockLog, RenderFrameIndex_), TLSChunkPoolRead, BlockPageOwners, InvalidBlockPage, BlockPagePool.PageSize, UploadMergeGapBytes,
+				[&](const void* Data, size_t Size, size_t Offset)
+				{
+					LVKContext->upload(BlockBuffer[RenderFrameIndex_], Data, Size, Offset);
+					LastUploadBytes += Size;
+				});
 		}
 	}
 	void UpdateDebugVisibleChunk(lvk::IContext* LVKContext, const FVoxelSceneConfig& VoxelSceneConfig, uint32_t RenderFrameIndex_)
@@ -683,13 +1492,16 @@ inline void PushToPool(uint32_t MaxChunkCount, FTLSChunkPool& MemoryPool, FTLSCh
 		{
 			return;
 		}
-		bool Expected = true;
-		if (bAtomicDebugVisibleChunkDirty[RenderFrameIndex_].compare_exchange_strong(Expected, false))// Compare, Release
+		//Loaded before the queues are swapped, a push landing after is caught next time
+		const uint64_t PushVersion = AtomicPushVersion.load(std::memory_order_acquire);
+		if (FramePushVersion[RenderFrameIndex_] != PushVersion)
 		{
+			FramePushVersion[RenderFrameIndex_] = PushVersion;
 			DebugTimerSet.Start(DebugMarkGatherVisibleChunk);
 			GatherDebugInstanceInfo(VoxelSceneConfig);
 			DebugTimerSet.Record(DebugMarkGatherVisibleChunk);
 
+			LastUploadBytes = 0;
 			DebugTimerSet.Start(DebugMarkUploadVisibleChunk);
 			UploadDebugInstanceInfo(LVKContext, RenderFrameIndex_);
 			DebugTimerSet.Record(DebugMarkUploadVisibleChunk);
@@ -701,6 +1513,9 @@ inline void PushToPool(uint32_t MaxChunkCount, FTLSChunkPool& MemoryPool, FTLSCh
 			DebugTimerSet.Start(DebugMarkUploadBlock);
 			UploadBlock(LVKContext, RenderFrameIndex_);
 			DebugTimerSet.Record(DebugMarkUploadBlock);
+
+			FrameUploadVersion[RenderFrameIndex_] = UploadVersion;
+			TruncateUploadLogs();
 		}
 	}
-};
+};
\ No newline at end of file
@@ -1,100 +1,142 @@
-#include <boost/dynamic_bitset.hpp>
+// Meso Engine 2024
+#pragma once
+#include <array>
+#include <bit>
 #include "Helper/VoxelMathHelper.h"
 
-
-struct FBinaryOccupancyVolume
+/*
+Fixed resolution volume, the bits live inline (no heap allocation) and the index math folds to shifts.
+Bit order is X fastest, then Y, then Z. Resolution is a power of two in [8, 64] so every X row sits inside one word.
+*/
+template<uint32_t Resolution_>
+struct TBinaryOccupancyVolume
 {
     using FOccupancyValue = bool;
 
-	boost::dynamic_bitset<> OccupancyVolume;
-    uint32_t Resolution = 0;
-    FBinaryOccupancyVolume() = default;
-    FBinaryOccupancyVolume(uint32_t Resolution_) : Resolution(Resolution_), OccupancyVolume(Resolution_* Resolution_* Resolution_) {}
+    static constexpr uint32_t Resolution = Resolution_;
+    static constexpr uint32_t ResolutionShift = std::countr_zero(Resolution);
+    static constexpr uint32_t VoxelNum = Resolution * Resolution * Resolution;
+    static constexpr uint32_t RowNum = Resolution * Resolution;
+    static constexpr uint32_t WordNum = VoxelNum / 64;
+    static constexpr uint64_t RowMask = Resolution >= 64 ? ~0ull : (1ull << Resolution) - 1ull;
+    static_assert(Resolution >= 8 && Resolution <= 64 && std::has_single_bit(Resolution), "Resolution must be a power of two in [8, 64]");
+
+    std::array<uint64_t, WordNum> Words = {};
+
+    static constexpr uint32_t GetIndex(uint32_t X, uint32_t Y, uint32_t Z)
+    {
+        return X | (Y << ResolutionShift) | (Z << (2 * ResolutionShift));
+    }
+    static uint32_t GetIndex(ivec3 Location)
+    {
+        return GetIndex((uint32_t)Location.x, (uint32_t)Location.y, (uint32_t)Location.z);
+    }
+    static ivec3 GetLocation(uint32_t Index)
+    {
+        return ivec3(Index & (Resolution - 1), (Index >> ResolutionShift) & (Resolution - 1), Index >> (2 * ResolutionShift));
+    }
+    static bool bIsOutOfBound(ivec3 Location)
+    {
+        return (uint32_t)Location.x >= Resolution || (uint32_t)Location.y >= Resolution || (uint32_t)Location.z >= Resolution;
+    }
 
     void Set(FOccupancyValue Value, ivec3 Location)
     {
-        //uint32_t PhysicIndex = Location.x + Location.y * Resolution + Location.z * Resolution * Resolution;
-        uint32_t PhysicIndex = FVoxelMathHelper::Convert3DTo1DClamped(Location, { Resolution ,Resolution ,Resolution });
-        OccupancyVolume[PhysicIndex] = Value;
+        SetBit(Value, GetIndex(glm::clamp(Location, ivec3(0), ivec3(Resolution - 1))));
+    }
+    void SetBit(FOccupancyValue Value, uint32_t Index)
+    {
+        const uint64_t Bit = 1ull << (Index & 63);
+        Words[Index >> 6] = Value ? (Words[Index >> 6] | Bit) : (Words[Index >> 6] & ~Bit);
+    }
+    FOccupancyValue GetBit(uint32_t Index) const
+    {
+        return (Words[Index >> 6] >> (Index & 63)) & 1ull;
     }
     FOccupancyValue GetClamped(ivec3 Location) const
     {
-        uint32_t PhysicIndex = FVoxelMathHelper::Convert3DTo1DClamped(Location, { Resolution ,Resolution ,Resolution });
-        return OccupancyVolume[PhysicIndex];
+        return GetBit(GetIndex(glm::clamp(Location, ivec3(0), ivec3(Resolution - 1))));
     }
     FOccupancyValue Get(ivec3 Location) const
     {
-        uint32_t PhysicIndex = FVoxelMathHelper::Convert3DTo1D(Location, { Resolution ,Resolution ,Resolution });
-        return OccupancyVolume[PhysicIndex];
+        return GetBit(GetIndex(Location));
     }
     FOccupancyValue GetWithBoundaryCondition(ivec3 Location, FOccupancyValue BoundaryValue = 0) const
     {
-        if (FVoxelMathHelper::bIsOutOfBound(Location, { Resolution ,Resolution ,Resolution }))
-        {
-            return BoundaryValue;
-        }
-        uint32_t PhysicIndex = FVoxelMathHelper::Convert3DTo1D(Location, { Resolution ,Resolution ,Resolution });
-        return OccupancyVolume[PhysicIndex];
+        return bIsOutOfBound(Location) ? BoundaryValue : Get(Location);
     }
-};
 
-// should move to helper/folder but it's messy now
-struct FOccupancyHelper
-{
-    //Moore neighborhood
-    inline static std::vector<ivec3> Get26Offsets()
+    // X row of (Y, Z), bit x = voxel x, row index Y + Z * Resolution
+    uint64_t GetRow(uint32_t Row) const
     {
-        return
-        {
-            {-1, -1, -1}, {-1, -1, 0}, {-1, -1, 1},
-            {-1, 0, -1} , {-1, 0, 0} , {-1, 0, 1},
-            {-1, 1, -1} , {-1, 1, 0} , {-1, 1, 1},
-
-            {0, -1, -1}, {0, -1, 0}, {0, -1, 1},
-            {0, 0, -1} , /*SELF*/    {0, 0, 1},
-            {0, 1, -1} , {0, 1, 0} , {0, 1, 1},
-
-            {1, -1, -1}, {1, -1, 0}, {1, -1, 1},
-            {1, 0, -1} , {1, 0, 0} , {1, 0, 1},
-            {1, 1, -1} , {1, 1, 0} , {1, 1, 1}
-        };
+        const uint32_t Bit = Row << ResolutionShift;
+        return (Words[Bit >> 6] >> (Bit & 63)) & RowMask;
+    }
+    void SetRow(uint32_t Row, uint64_t Bits)
+    {
+        const uint32_t Bit = Row << ResolutionShift;
+        uint64_t& Word = Words[Bit >> 6];
+        Word = (Word & ~(RowMask << (Bit & 63))) | ((Bits & RowMask) << (Bit & 63));
     }
 
-    //Von Neumann neighborhood
-    inline static std::vector<ivec3> Get6Offsets()
+    void Reset()
     {
-        return
-        {
-            {-1, 0, 0},
-            {0, -1, 0},
-            {0, 0, -1}, 
-            {0, 0, 1},
-            {0, 1, 0},
-            {1, 0, 0}
-        };
+        Words.fill(0ull);
+    }
+    void Fill()
+    {
+        Words.fill(~0ull);
     }
-    template<bool bUseComplex = true>
-    inline static FBinaryOccupancyVolume::FOccupancyValue ErodeSingleVoxel(const FBinaryOccupancyVolume& BaseOccupancyVolume, ivec3 Location)
+    uint32_t Count() const
     {
-        if (FVoxelMathHelper::bIsOutOfBoundThickness(Location, { BaseOccupancyVolume.Resolution,BaseOccupancyVolume.Resolution ,BaseOccupancyVolume.Resolution }, 1u))
+        uint32_t Result = 0;
+        for (uint64_t Word : Words)
         {
-            return 0;
+            Result += (uint32_t)std::popcount(Word);
         }
-        std::vector<ivec3> Offsets;
-        constexpr uint32_t NeighbourNum = bUseComplex ? 26 : 6;
-        if constexpr (bUseComplex)
+        return Result;
+    }
+    bool bAny() const
+    {
+        for (uint64_t Word : Words)
         {
-            Offsets = Get26Offsets();
+            if (Word)
+            {
+                return true;
+            }
         }
-        else
+        return false;
+    }
+    // Func(uint32_t Index) for every set voxel, in index order
+    template<typename FFunc>
+    void ForEachSet(FFunc&& Func) const
+    {
+        for (uint32_t w = 0; w < WordNum; w++)
         {
-            Offsets = Get6Offsets();
+            for (uint64_t Word = Words[w]; Word; Word &= Word - 1)
+            {
+                Func((w << 6) | (uint32_t)std::countr_zero(Word));
+            }
         }
-        FBinaryOccupancyVolume::FOccupancyValue ErodeResult = true;
-        for (uint32_t i = 0; i < NeighbourNum; i++)
+    }
+    bool operator==(const TBinaryOccupancyVolume&) const = default;
+};
+
+// should move to helper/folder but it's messy now
+struct FOccupancyHelper
+{
+    // Exposed faces of one X row, a bit per voxel for each face in -X, +X, -Y, +Y, -Z, +Z order.
+    // LowerY..UpperZ are the rows at Y - 1, Y + 1, Z - 1, Z + 1, LowerX / UpperX (0 or 1) the voxels just before X = 0 and after X = Resolution - 1
+    inline static std::array<uint64_t, 6> GetExposedFaceRows(uint64_t Row, uint64_t LowerX, uint64_t UpperX, uint64_t LowerY, uint64_t UpperY, uint64_t LowerZ, uint64_t UpperZ, uint32_t Resolution)
+    {
+        return
         {
-            ErodeResult &= BaseOccupancyVolume.Get(Offsets[i] + Location);
-        }
-        return ErodeResult;
+            Row & ~((Row << 1) | LowerX),
+            Row & ~((Row >> 1) | (UpperX << (Resolution - 1))),
+            Row & ~LowerY,
+            Row & ~UpperY,
+            Row & ~LowerZ,
+            Row & ~UpperZ,
+        };
     }
 };
\ No newline at end of file
@@ -0,0 +1,113 @@
+// Meso Engine 2024
+#pragma once
+#include <algorithm>
+#include <array>
+#include "Voxel/Occupancy/BinaryOccupancyVolume.h"
+
+/*
+Interior depth of every voxel, the chessboard distance to the nearest empty voxel, voxels outside the volume count as empty.
+0 on empty voxels, 1 on the surface. Depth > d is the same as the voxel surviving d erosions (26 neighbourhood, mip d of the old erode chain),
+so any cull threshold is one lookup and the cost doesn't depend on how deep we look.
+Built in three separable passes (X, Y, Z), the chessboard ball is a cube so each pass only sees one axis.
+*/
+template<uint32_t Resolution_>
+struct TInteriorDepthVolume
+{
+    static constexpr uint32_t Resolution = Resolution_;
+    using FOccupancyVolume = TBinaryOccupancyVolume<Resolution>;
+
+    std::array<uint8_t, FOccupancyVolume::VoxelNum> Depths = {};
+
+    uint8_t GetDepth(uint32_t Index) const
+    {
+        return Depths[Index];
+    }
+    uint8_t GetDepth(ivec3 Location) const
+    {
+        return Depths[FOccupancyVolume::GetIndex(Location)];
+    }
+    void Fill(uint8_t Depth)
+    {
+        Depths.fill(Depth);
+    }
+    void Calculate(const FOccupancyVolume& Occupancy)
+    {
+        //X: run lengths of the packed row from both sides, empty and full rows are the common case
+        uint8_t FullLine[Resolution];
+        for (uint32_t X = 0; X < Resolution; X++)
+        {
+            FullLine[X] = (uint8_t)std::min(X + 1, Resolution - X);
+        }
+        for (uint32_t Row = 0; Row < FOccupancyVolume::RowNum; Row++)
+        {
+            const uint64_t Bits = Occupancy.GetRow(Row);
+            uint8_t* Line = &Depths[Row * Resolution];
+            if (Bits == 0)
+            {
+                std::fill_n(Line, Resolution, (uint8_t)0);
+                continue;
+            }
+            if (Bits == FOccupancyVolume::RowMask)
+            {
+                std::copy_n(FullLine, Resolution, Line);
+                continue;
+            }
+            uint8_t Run = 0;
+            for (uint32_t X = 0; X < Resolution; X++)
+            {
+                Run = ((Bits >> X) & 1ull) ? Run + 1 : 0;
+                Line[X] = Run;
+            }
+            Run = 0;
+            for (uint32_t X = Resolution; X-- > 0;)
+            {
+                Run = ((Bits >> X) & 1ull) ? Run + 1 : 0;
+                Line[X] = std::min(Line[X], Run);
+            }
+        }
+        //Y then Z, whole X rows at a time
+        for (uint32_t Z = 0; Z < Resolution; Z++)
+        {
+            TransformRows(&Depths[Z * Resolution * Resolution], Resolution);
+        }
+        for (uint32_t Y = 0; Y < Resolution; Y++)
+        {
+            TransformRows(&Depths[Y * Resolution], Resolution * Resolution);
+        }
+    }
+    bool operator==(const TInteriorDepthVolume&) const = default;
+private:
+    /*
+    g(i) = min_j max(|i - j|, f(j)), j in [-1, Resolution] with f = 0 outside, along the axis of Stride for every X of the row at once.
+    Only |i - j| < g can lower g, so the search stops at the deepest voxel of the row. The X loops vectorize.
+    */
+    static void TransformRows(uint8_t* Base, uint32_t Stride)
+    {
+        uint8_t Source[Resolution][Resolution];
+        for (uint32_t i = 0; i < Resolution; i++)
+        {
+            std::copy_n(Base + i * Stride, Resolution, Source[i]);
+        }
+        for (uint32_t i = 0; i < Resolution; i++)
+        {
+            const uint8_t Bound = (uint8_t)std::min(i + 1, Resolution - i);
+            uint8_t Depth[Resolution];
+            uint8_t MaxDepth = 0;
+            for (uint32_t X = 0; X < Resolution; X++)
+            {
+                Depth[X] = std::min(Source[i][X], Bound);
+                MaxDepth = std::max(MaxDepth, Depth[X]);
+            }
+            for (uint32_t k = 1; k < MaxDepth; k++)
+            {
+                const uint8_t* Lower = Source[i - k];
+                const uint8_t* Upper = Source[i + k];
+                for (uint32_t X = 0; X < Resolution; X++)
+                {
+                    Depth[X] = std::min(Depth[X], std::max((uint8_t)k, std::min(Lower[X], Upper[X])));
+                }
+            }
+            std::copy_n(Depth, Resolution, Base + i * Stride);
+        }
+    }
+};
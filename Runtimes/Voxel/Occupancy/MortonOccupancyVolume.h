@@ -0,0 +1,85 @@
+// Meso Engine 2024
+#pragma once
+#include <array>
+#include <bit>
+#include "Helper/VoxelMathHelper.h"
+#include "Voxel/Occupancy/BinaryOccupancyVolume.h"
+
+/*
+Same bits as TBinaryOccupancyVolume in Z-order (FVoxelMathHelper::MortonEncode3D), the 26 neighbours of a voxel mostly share its word.
+Every aligned 2^3 cube is one byte and every aligned 4^3 brick one word, so empty space tests and OR reductions don't need any shifting.
+The linear layout stays the working one (rows are what the erosion, depth and face kernels eat), convert where locality matters.
+*/
+template<uint32_t Resolution_>
+struct TMortonOccupancyVolume
+{
+    using FOccupancyValue = bool;
+    using FLinearVolume = TBinaryOccupancyVolume<Resolution_>;
+
+    static constexpr uint32_t Resolution = Resolution_;
+    static constexpr uint32_t VoxelNum = FLinearVolume::VoxelNum;
+    static constexpr uint32_t WordNum = FLinearVolume::WordNum;
+    static constexpr uint32_t BrickResolution = 4;//Voxels per axis of one word
+
+    std::array<uint64_t, WordNum> Words = {};
+
+    static uint32_t GetIndex(ivec3 Location)
+    {
+        return FVoxelMathHelper::MortonEncode3D(Location);
+    }
+    static ivec3 GetLocation(uint32_t Index)
+    {
+        return FVoxelMathHelper::MortonDecode3D(Index);
+    }
+    void SetBit(FOccupancyValue Value, uint32_t Index)
+    {
+        const uint64_t Bit = 1ull << (Index & 63);
+        Words[Index >> 6] = Value ? (Words[Index >> 6] | Bit) : (Words[Index >> 6] & ~Bit);
+    }
+    FOccupancyValue GetBit(uint32_t Index) const
+    {
+        return (Words[Index >> 6] >> (Index & 63)) & 1ull;
+    }
+    void Set(FOccupancyValue Value, ivec3 Location)
+    {
+        SetBit(Value, GetIndex(Location));
+    }
+    FOccupancyValue Get(ivec3 Location) const
+    {
+        return GetBit(GetIndex(Location));
+    }
+    //Nothing solid in the aligned 4^3 brick around Location
+    bool bIsBrickEmpty(ivec3 Location) const
+    {
+        return Words[GetIndex(Location) >> 6] == 0;
+    }
+    void FromLinear(const FLinearVolume& Linear)
+    {
+        Words.fill(0ull);
+        Linear.ForEachSet([this](uint32_t Index)
+            {
+                SetBit(true, GetIndex(FLinearVolume::GetLocation(Index)));
+            });
+    }
+    void ToLinear(FLinearVolume& Linear) const
+    {
+        Linear.Reset();
+        ForEachSet([&Linear](uint32_t Index)
+            {
+                Linear.SetBit(true, FLinearVolume::GetIndex(GetLocation(Index)));
+            });
+    }
+    // Func(uint32_t MortonIndex) for every set voxel, in Z-order
+    template<typename FFunc>
+    void ForEachSet(FFunc&& Func) const
+    {
+        for (uint32_t w = 0; w < WordNum; w++)
+        {
+            for (uint64_t Word = Words[w]; Word; Word &= Word - 1)
+            {
+                Func((w << 6) | (uint32_t)std::countr_zero(Word));
+            }
+        }
+    }
+    bool operator==(const TMortonOccupancyVolume&) const = default;
+};
@@ -0,0 +1,158 @@
+// Meso Engine 2024
+#pragma once
+#include <array>
+#include "Voxel/Occupancy/BinaryOccupancyVolume.h"
+#include "Voxel/Occupancy/MortonOccupancyVolume.h"
+
+/*
+OR reduced occupancy, level L has Resolution >> L cells per axis and a cell is set when any voxel of its (1 << L)^3 cube is solid.
+Level 0 is the occupancy itself and isn't stored, the last level is one cell for the whole volume.
+Empty cells let ray and sweep queries jump over a whole cube at once. Built row by row, 4 rows OR'd then the even bits compacted.
+*/
+template<uint32_t Resolution_>
+struct TOccupancyPyramid
+{
+    static constexpr uint32_t Resolution = Resolution_;
+    using FOccupancyVolume = TBinaryOccupancyVolume<Resolution>;
+    static constexpr uint32_t LevelNum = FOccupancyVolume::ResolutionShift;
+
+    static constexpr uint32_t GetLevelResolution(uint32_t Level)
+    {
+        return Resolution >> Level;
+    }
+    //Levels start on a word, rows of a level never straddle two words (both are powers of two)
+    static constexpr uint32_t GetLevelWordOffset(uint32_t Level)
+    {
+        uint32_t Offset = 0;
+        for (uint32_t i = 1; i < Level; i++)
+        {
+            const uint32_t LevelResolution = GetLevelResolution(i);
+            Offset += (LevelResolution * LevelResolution * LevelResolution + 63) / 64;
+        }
+        return Offset;
+    }
+    static constexpr uint32_t WordNum = GetLevelWordOffset(LevelNum + 1);
+    //Queries take a runtime level, so no loop per lookup
+    static constexpr std::array<uint32_t, LevelNum + 1> LevelWordOffsets = []()
+        {
+            std::array<uint32_t, LevelNum + 1> Offsets = {};
+            for (uint32_t Level = 1; Level <= LevelNum; Level++)
+            {
+                Offsets[Level] = GetLevelWordOffset(Level);
+            }
+            return Offsets;
+        }();
+
+    std::array<uint64_t, WordNum> Words = {};
+
+    //Cell in level units, 1 <= Level <= LevelNum
+    bool bAny(uint32_t Level, ivec3 Cell) const
+    {
+        const uint32_t LevelResolution = GetLevelResolution(Level);
+        const uint32_t Bit = (uint32_t)Cell.x + ((uint32_t)Cell.y + (uint32_t)Cell.z * LevelResolution) * LevelResolution;
+        return (Words[LevelWordOffsets[Level] + (Bit >> 6)] >> (Bit & 63)) & 1ull;
+    }
+    bool bAny() const
+    {
+        return bAny(LevelNum, { 0, 0, 0 });
+    }
+    //Coarsest level whose cube around Voxel is empty, 0 when the level 1 cube already has something (check the voxel itself)
+    uint32_t GetEmptyLevel(ivec3 Voxel) const
+    {
+        for (uint32_t Level = LevelNum; Level > 0; Level--)
+        {
+            if (!bAny(Level, Voxel >> (int32_t)Level))
+            {
+                return Level;
+            }
+        }
+        return 0;
+    }
+    void Calculate(const FOccupancyVolume& Occupancy)
+    {
+        constexpr uint32_t Half = Resolution / 2;
+        for (uint32_t Z = 0; Z < Half; Z++)
+        {
+            for (uint32_t Y = 0; Y < Half; Y++)
+            {
+                const uint32_t Row = 2 * Y + 2 * Z * Resolution;
+                const uint64_t Bits = Occupancy.GetRow(Row) | Occupancy.GetRow(Row + 1) | Occupancy.GetRow(Row + Resolution) | Occupancy.GetRow(Row + Resolution + 1);
+                SetLevelRow(1, Y + Z * Half, CompactEvenBits(Bits | (Bits >> 1)));
+            }
+        }
+        for (uint32_t Level = 2; Level <= LevelNum; Level++)
+        {
+            const uint32_t Source = GetLevelResolution(Level - 1);
+            const uint32_t Target = GetLevelResolution(Level);
+            for (uint32_t Z = 0; Z < Target; Z++)
+            {
+                for (uint32_t Y = 0; Y < Target; Y++)
+                {
+                    const uint32_t Row = 2 * Y + 2 * Z * Source;
+                    const uint64_t Bits = GetLevelRow(Level - 1, Row) | GetLevelRow(Level - 1, Row + 1) | GetLevelRow(Level - 1, Row + Source) | GetLevelRow(Level - 1, Row + Source + 1);
+                    SetLevelRow(Level, Y + Z * Target, CompactEvenBits(Bits | (Bits >> 1)));
+                }
+            }
+        }
+    }
+    //Z-order source, the level L cell with Morton index m covers the bits [m * 8^L, (m + 1) * 8^L) so levels 1 and 2 are bytes and words
+    void Calculate(const TMortonOccupancyVolume<Resolution>& Occupancy)
+    {
+        Words.fill(0ull);
+        for (uint32_t w = 0; w < TMortonOccupancyVolume<Resolution>::WordNum; w++)
+        {
+            const uint64_t Word = Occupancy.Words[w];
+            if (Word == 0)
+            {
+                continue;
+            }
+            //One decode per word, the byte index holds the last x, y, z bits of the level 1 cell
+            const ivec3 Brick = FVoxelMathHelper::MortonDecode3D(w);
+            for (uint32_t Byte = 0; Byte < 8; Byte++)
+            {
+                if ((Word >> (Byte * 8)) & 0xFFull)
+                {
+                    SetCell(1, Brick * 2 + ivec3{ (int32_t)(Byte & 1), (int32_t)((Byte >> 1) & 1), (int32_t)(Byte >> 2) });
+                }
+            }
+            for (uint32_t Level = 2; Level <= LevelNum; Level++)
+            {
+                SetCell(Level, Brick >> (int32_t)(Level - 2));
+            }
+        }
+    }
+    bool operator==(const TOccupancyPyramid&) const = default;
+private:
+    void SetCell(uint32_t Level, ivec3 Cell)
+    {
+        const uint32_t LevelResolution = GetLevelResolution(Level);
+        const uint32_t Bit = (uint32_t)Cell.x + ((uint32_t)Cell.y + (uint32_t)Cell.z * LevelResolution) * LevelResolution;
+        Words[LevelWordOffsets[Level] + (Bit >> 6)] |= 1ull << (Bit & 63);
+    }
+    static constexpr uint64_t GetLevelRowMask(uint32_t Level)
+    {
+        return GetLevelResolution(Level) >= 64 ? ~0ull : (1ull << GetLevelResolution(Level)) - 1ull;
+    }
+    uint64_t GetLevelRow(uint32_t Level, uint32_t Row) const
+    {
+        const uint32_t Bit = Row * GetLevelResolution(Level);
+        return (Words[LevelWordOffsets[Level] + (Bit >> 6)] >> (Bit & 63)) & GetLevelRowMask(Level);
+    }
+    void SetLevelRow(uint32_t Level, uint32_t Row, uint64_t Bits)
+    {
+        const uint32_t Bit = Row * GetLevelResolution(Level);
+        uint64_t& Word = Words[LevelWordOffsets[Level] + (Bit >> 6)];
+        Word = (Word & ~(GetLevelRowMask(Level) << (Bit & 63))) | ((Bits & GetLevelRowMask(Level)) << (Bit & 63));
+    }
+    //Bits 0, 2, 4 ... packed into the low half
+    static uint64_t CompactEvenBits(uint64_t Bits)
+    {
+        Bits &= 0x5555555555555555ull;
+        Bits = (Bits | (Bits >> 1)) & 0x3333333333333333ull;
+        Bits = (Bits | (Bits >> 2)) & 0x0F0F0F0F0F0F0F0Full;
+        Bits = (Bits | (Bits >> 4)) & 0x00FF00FF00FF00FFull;
+        Bits = (Bits | (Bits >> 8)) & 0x0000FFFF0000FFFFull;
+        Bits = (Bits | (Bits >> 16)) & 0x00000000FFFFFFFFull;
+        return Bits;
+    }
+};
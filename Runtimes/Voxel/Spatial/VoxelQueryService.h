@@ -0,0 +1,143 @@
+// Meso Engine 2024
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <numeric>
+#include <span>
+#include <vector>
+#include "Helper/Comparator.h"
+#include "Thread/ThreadPool.h"
+#include "Voxel/Spatial/VoxelRayCast.h"
+#include "Voxel/Spatial/VoxelSweep.h"
+
+enum class EVoxelQueryType : uint8_t
+{
+    RayCast = 0,
+    SweepBox = 1,
+    OverlapBox = 2,//A sweep that doesn't move, hits with bStartSolid
+};
+
+//One request of a batch, box queries use LocalOrigin as the box min
+struct FVoxelQuery
+{
+    EVoxelQueryType Type = EVoxelQueryType::RayCast;
+    ivec3 OriginChunk = { 0, 0, 0 };
+    vec3 LocalOrigin = { 0.0f, 0.0f, 0.0f };
+    vec3 LocalMax = { 0.0f, 0.0f, 0.0f };//Box max
+    vec3 Direction = { 0.0f, 0.0f, 0.0f };//Ray direction or box delta
+    float MaxDistance = 0.0f;//Rays only
+};
+
+struct FVoxelQueryResult
+{
+    FRayCastHit RayHit;
+    FSweepHit SweepHit;
+};
+
+/*
+Runs batches of rays, sweeps and overlaps. Queries are sorted by origin chunk so the tasks walk the same chunks back to back
+(and share their lookups), then handed out QueriesPerTask at a time to the pool threads that are free plus the calling thread.
+A pool thread is held until the batch is done, a pool shared with other work (the generator threads) should be capped with MaxPoolTaskNum.
+Results land at the index of their query in the caller's buffer. One batch at a time per service.
+*/
+class FVoxelQueryService
+{
+public:
+    static constexpr size_t QueriesPerTask = 64;
+    struct FStats
+    {
+        uint64_t QueryNum = 0;
+        uint64_t BatchNum = 0;
+        double Seconds = 0.0;
+        double LastBatchSeconds = 0.0;
+        double MaxBatchSeconds = 0.0;
+        double GetQueriesPerSecond() const
+        {
+            return Seconds > 0.0 ? QueryNum / Seconds : 0.0;
+        }
+    };
+
+    //Pool can be null, or busy, the calling thread then runs everything. At most MaxPoolTaskNum of its threads are taken
+    template<typename FFindChunk>
+    void Run(FFindChunk&& FindChunk, std::span<const FVoxelQuery> Queries, std::span<FVoxelQueryResult> Results, float BlockSize, ThreadPool* Pool = nullptr, size_t MaxPoolTaskNum = SIZE_MAX)
+    {
+        const auto Start = std::chrono::steady_clock::now();
+        const size_t QueryNum = std::min(Queries.size(), Results.size());
+        Order.resize(QueryNum);//Grows once, reused by every batch
+        std::iota(Order.begin(), Order.end(), 0u);
+        std::sort(Order.begin(), Order.end(), [&Queries](uint32_t A, uint32_t B) { return FIVec3Comparator()(Queries[A].OriginChunk, Queries[B].OriginChunk); });
+
+        Cursor = 0;
+        auto Work = [&]()
+            {
+                FChunkLookupCache Cache;
+                for (size_t Begin = Cursor.fetch_add(QueriesPerTask); Begin < QueryNum; Begin = Cursor.fetch_add(QueriesPerTask))
+                {
+                    for (size_t i = Begin; i < std::min(Begin + QueriesPerTask, QueryNum); i++)
+                    {
+                        Results[Order[i]] = RunQuery(FindChunk, Cache, Queries[Order[i]], BlockSize);
+                    }
+                }
+            };
+        if (Pool && Pool->GetSize() > 0 && QueryNum > 0)
+        {
+            const size_t PoolTaskNum = std::min(std::min<size_t>(Pool->GetSize(), (QueryNum + QueriesPerTask - 1) / QueriesPerTask) - 1, MaxPoolTaskNum);
+            for (size_t t = 0; t < PoolTaskNum; t++)
+            {
+                PendingTaskNum++;
+                if (!Pool->EnqueueForward([this, &Work]()
+                    {
+                        Work();
+                        PendingTaskNum--;
+                        PendingTaskNum.notify_all();
+                    }))
+                {
+                    PendingTaskNum--;
+                    break;
+                }
+            }
+        }
+        Work();
+        for (uint32_t Pending = PendingTaskNum.load(); Pending != 0; Pending = PendingTaskNum.load())
+        {
+            PendingTaskNum.wait(Pending);
+        }
+
+        const double BatchSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+        Stats.QueryNum += QueryNum;
+        Stats.BatchNum++;
+        Stats.Seconds += BatchSeconds;
+        Stats.LastBatchSeconds = BatchSeconds;
+        Stats.MaxBatchSeconds = std::max(Stats.MaxBatchSeconds, BatchSeconds);
+    }
+    template<typename FFindChunk>
+    static FVoxelQueryResult RunQuery(FFindChunk& FindChunk, FChunkLookupCache& Cache, const FVoxelQuery& Query, float BlockSize)
+    {
+        FVoxelQueryResult Result;
+        if (Query.Type == EVoxelQueryType::RayCast)
+        {
+            Result.RayHit = RayCast(FindChunk, Query.OriginChunk, Query.LocalOrigin, Query.Direction, Query.MaxDistance, BlockSize);
+        }
+        else
+        {
+            const vec3 Delta = Query.Type == EVoxelQueryType::SweepBox ? Query.Direction : vec3(0.0f);
+            Result.SweepHit = SweepBox(FindChunk, Cache, { .OriginChunk = Query.OriginChunk, .LocalMin = Query.LocalOrigin, .LocalMax = Query.LocalMax, .Delta = Delta }, BlockSize);
+        }
+        return Result;
+    }
+    const FStats& GetStats() const
+    {
+        return Stats;
+    }
+    void ResetStats()
+    {
+        Stats = {};
+    }
+private:
+    std::vector<uint32_t> Order;
+    std::atomic<size_t> Cursor = 0;
+    std::atomic<uint32_t> PendingTaskNum = 0;//Outlives the batch, the last task may still notify after Run saw 0
+    FStats Stats;
+};
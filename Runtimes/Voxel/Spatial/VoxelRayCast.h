@@ -0,0 +1,130 @@
+// Meso Engine 2024
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <glm/glm.hpp>
+#include "Voxel/Chunk/Chunk.h"
+
+//What a ray step sees at a level 0 chunk, either the resident chunk covering it or how far around it is known empty
+struct FChunkRayLookup
+{
+    std::shared_ptr<const FChunkQueryData> Data;
+    int32_t EmptyCubeShift = 0;//No data, the aligned cube of 2^EmptyCubeShift level 0 chunks around it is empty too
+};
+
+struct FRayCastHit
+{
+    bool bHit = false;
+    ivec3 ChunkLocation = { INT_MAX, INT_MAX, INT_MAX };
+    uint32_t MipmapLevel = 0;
+    u8vec3 BlockLocation = { 0, 0, 0 };//In the hit chunk, so in blocks of its mip level
+    uint8_t Face = UINT8_MAX;//Face of the block the ray entered through (-X, +X, -Y, +Y, -Z, +Z), UINT8_MAX when it starts inside
+    float Distance = 0.0f;
+};
+
+/*
+Voxel DDA over chunks in level 0 block units. Every step leaves the biggest aligned cube known to be empty around the current voxel:
+a missing chunk (plus its empty brick), an empty pyramid cell, or one block of the chunk's mip level. Lookups are cached while the ray stays in the same chunk.
+Positions are doubles on absolute block coordinates, so far chunks don't lose the alignment of the cubes.
+FindChunk(ivec3 ChunkLocation) returns a FChunkRayLookup for a level 0 chunk location.
+*/
+template<typename FFindChunk>
+FRayCastHit RayCast(FFindChunk&& FindChunk, ivec3 OriginChunk, vec3 LocalOrigin, vec3 Direction, float MaxDistance, float BlockSize)
+{
+    using FOccupancyVolume = FChunkOccupancyVolume;
+    constexpr int32_t ResolutionShift = (int32_t)FOccupancyVolume::ResolutionShift;
+    constexpr int64_t Resolution = FOccupancyVolume::Resolution;
+
+    FRayCastHit Hit;
+    const double Length = std::sqrt((double)Direction.x * Direction.x + (double)Direction.y * Direction.y + (double)Direction.z * Direction.z);
+    if (Length <= 0.0 || BlockSize <= 0.0f)
+    {
+        return Hit;
+    }
+    double Origin[3], Dir[3], InvDir[3];
+    int64_t Cell[3];
+    for (int32_t Axis = 0; Axis < 3; Axis++)
+    {
+        Origin[Axis] = (double)OriginChunk[Axis] * Resolution + (double)LocalOrigin[Axis] / BlockSize;
+        Dir[Axis] = Direction[Axis] / Length;
+        InvDir[Axis] = Dir[Axis] != 0.0 ? 1.0 / Dir[Axis] : 0.0;
+        Cell[Axis] = (int64_t)std::floor(Origin[Axis]);
+    }
+    const double MaxT = (double)MaxDistance / BlockSize;
+
+    double T = 0.0;
+    uint8_t Face = UINT8_MAX;
+    ivec3 CachedChunk = { INT_MAX, INT_MAX, INT_MAX };
+    FChunkRayLookup Lookup;
+    while (T <= MaxT)
+    {
+        const ivec3 ChunkLocation = { (int32_t)(Cell[0] >> ResolutionShift), (int32_t)(Cell[1] >> ResolutionShift), (int32_t)(Cell[2] >> ResolutionShift) };
+        if (ChunkLocation != CachedChunk)
+        {
+            Lookup = FindChunk(ChunkLocation);
+            CachedChunk = ChunkLocation;
+        }
+        int32_t Shift = ResolutionShift + Lookup.EmptyCubeShift;
+        if (Lookup.Data)
+        {
+            const FChunkQueryData& Data = *Lookup.Data;
+            const int32_t MipmapLevel = Data.ChunkKey.w;
+            const ivec3 Local = {
+                (int32_t)((Cell[0] - (int64_t)Data.ChunkKey.x * Resolution) >> MipmapLevel),
+                (int32_t)((Cell[1] - (int64_t)Data.ChunkKey.y * Resolution) >> MipmapLevel),
+                (int32_t)((Cell[2] - (int64_t)Data.ChunkKey.z * Resolution) >> MipmapLevel) };
+            const uint32_t EmptyLevel = Data.OccupancyPyramid.GetEmptyLevel(Local);
+            if (EmptyLevel == 0 && Data.Occupancy.Get(Local))
+            {
+                Hit.bHit = true;
+                Hit.ChunkLocation = ivec3(Data.ChunkKey);
+                Hit.MipmapLevel = (uint32_t)MipmapLevel;
+                Hit.BlockLocation = u8vec3(Local);
+                Hit.Face = Face;
+                Hit.Distance = (float)(T * BlockSize);
+                return Hit;
+            }
+            Shift = (int32_t)EmptyLevel + MipmapLevel;
+        }
+        //Leave the aligned cube of 2^Shift blocks holding Cell through its nearest face
+        const int64_t Size = 1ll << Shift;
+        double ExitT = INFINITY;
+        int32_t ExitAxis = 0;
+        int64_t CubeMin[3];
+        for (int32_t Axis = 0; Axis < 3; Axis++)
+        {
+            CubeMin[Axis] = Cell[Axis] & ~(Size - 1);
+            if (Dir[Axis] == 0.0)
+            {
+                continue;
+            }
+            const double Bound = (double)(Dir[Axis] > 0.0 ? CubeMin[Axis] + Size : CubeMin[Axis]);
+            const double AxisT = (Bound - Origin[Axis]) * InvDir[Axis];
+            if (AxisT < ExitT)
+            {
+                ExitT = AxisT;
+                ExitAxis = Axis;
+            }
+        }
+        if (ExitT > MaxT)
+        {
+            break;
+        }
+        T = std::max(T, ExitT);
+        for (int32_t Axis = 0; Axis < 3; Axis++)
+        {
+            if (Axis == ExitAxis)
+            {
+                Cell[Axis] = Dir[Axis] > 0.0 ? CubeMin[Axis] + Size : CubeMin[Axis] - 1;
+            }
+            else
+            {
+                //Rounding can't push the other axes out of the cube we just crossed
+                Cell[Axis] = std::clamp((int64_t)std::floor(Origin[Axis] + Dir[Axis] * T), CubeMin[Axis], CubeMin[Axis] + Size - 1);
+            }
+        }
+        Face = (uint8_t)(ExitAxis * 2 + (Dir[ExitAxis] > 0.0 ? 0 : 1));
+    }
+    return Hit;
+}
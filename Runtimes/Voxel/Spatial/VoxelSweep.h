@@ -0,0 +1,170 @@
+// Meso Engine 2024
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <glm/glm.hpp>
+#include "Voxel/Spatial/VoxelRayCast.h"
+
+//Box moving by Delta, in world units from OriginChunk's corner
+struct FBoxSweep
+{
+    ivec3 OriginChunk = { 0, 0, 0 };
+    vec3 LocalMin = { 0.0f, 0.0f, 0.0f };
+    vec3 LocalMax = { 0.0f, 0.0f, 0.0f };
+    vec3 Delta = { 0.0f, 0.0f, 0.0f };
+};
+
+struct FSweepHit
+{
+    bool bHit = false;
+    bool bStartSolid = false;//Already overlapping solid blocks, Time is 0 and there is no normal
+    float Time = 1.0f;//Fraction of Delta travelled before touching
+    ivec3 Normal = { 0, 0, 0 };//Axis of the block face touched, pointing back at the box
+};
+
+//Last lookups by the low bit of each chunk axis, a box rarely spans more than 2 chunks per axis. Lives on the stack, no allocation
+struct FChunkLookupCache
+{
+    std::array<ivec3, 8> Locations;
+    std::array<FChunkRayLookup, 8> Lookups;
+
+    FChunkLookupCache()
+    {
+        Locations.fill(ivec3{ INT_MAX, INT_MAX, INT_MAX });
+    }
+    template<typename FFindChunk>
+    const FChunkRayLookup& Find(FFindChunk& FindChunk, ivec3 ChunkLocation)
+    {
+        const uint32_t Slot = (uint32_t)((ChunkLocation.x & 1) | ((ChunkLocation.y & 1) << 1) | ((ChunkLocation.z & 1) << 2));
+        if (Locations[Slot] != ChunkLocation)
+        {
+            Locations[Slot] = ChunkLocation;
+            Lookups[Slot] = FindChunk(ChunkLocation);
+        }
+        return Lookups[Slot];
+    }
+};
+
+/*
+Anything solid in the absolute level 0 block range [Min, Max] (inclusive), one masked occupancy row per Y, Z and chunk.
+Chunks that aren't resident count as empty, same as the ray cast.
+*/
+template<typename FFindChunk>
+bool bAnySolidBlock(FFindChunk& FindChunk, FChunkLookupCache& Cache, const int64_t Min[3], const int64_t Max[3])
+{
+    constexpr int32_t ResolutionShift = (int32_t)FChunkOccupancyVolume::ResolutionShift;
+    constexpr int64_t Resolution = FChunkOccupancyVolume::Resolution;
+    if (Max[0] < Min[0] || Max[1] < Min[1] || Max[2] < Min[2])
+    {
+        return false;
+    }
+    for (int64_t ChunkZ = Min[2] >> ResolutionShift; ChunkZ <= Max[2] >> ResolutionShift; ChunkZ++)
+    {
+        for (int64_t ChunkY = Min[1] >> ResolutionShift; ChunkY <= Max[1] >> ResolutionShift; ChunkY++)
+        {
+            for (int64_t ChunkX = Min[0] >> ResolutionShift; ChunkX <= Max[0] >> ResolutionShift; ChunkX++)
+            {
+                const int64_t Chunk[3] = { ChunkX, ChunkY, ChunkZ };
+                const FChunkRayLookup& Lookup = Cache.Find(FindChunk, ivec3{ (int32_t)ChunkX, (int32_t)ChunkY, (int32_t)ChunkZ });
+                if (!Lookup.Data)
+                {
+                    continue;
+                }
+                //Clamp to this level 0 chunk, then into the blocks of the covering chunk's mip level
+                const FChunkQueryData& Data = *Lookup.Data;
+                const int32_t MipmapLevel = Data.ChunkKey.w;
+                int32_t Lower[3], Upper[3];
+                for (int32_t Axis = 0; Axis < 3; Axis++)
+                {
+                    const int64_t Base = (int64_t)Data.ChunkKey[Axis] * Resolution;
+                    Lower[Axis] = (int32_t)((std::max(Min[Axis], Chunk[Axis] * Resolution) - Base) >> MipmapLevel);
+                    Upper[Axis] = (int32_t)((std::min(Max[Axis], Chunk[Axis] * Resolution + Resolution - 1) - Base) >> MipmapLevel);
+                }
+                const uint64_t Mask = (~0ull >> (63 - (Upper[0] - Lower[0]))) << Lower[0];
+                for (int32_t Z = Lower[2]; Z <= Upper[2]; Z++)
+                {
+                    for (int32_t Y = Lower[1]; Y <= Upper[1]; Y++)
+                    {
+                        if (Data.Occupancy.GetRow((uint32_t)(Y + Z * (int32_t)Resolution)) & Mask)
+                        {
+                            return true;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return false;
+}
+
+/*
+Swept AABB against the block grid. The leading face on each moving axis is walked like a DDA, whenever it reaches the next block boundary
+the one block thick layer it enters (over the box extent on the other axes) is scanned for solid blocks, the first solid layer is the impact.
+The other axes use the blocks the box covers just after that time, so edges and corners entered on two axes at once aren't missed.
+Exact for axis aligned boxes, crossing chunks is just more rows, nothing is allocated.
+*/
+template<typename FFindChunk>
+FSweepHit SweepBox(FFindChunk&& FindChunk, FChunkLookupCache& Cache, const FBoxSweep& Sweep, float BlockSize)
+{
+    constexpr int64_t Resolution = FChunkOccupancyVolume::Resolution;
+    FSweepHit Hit;
+    if (BlockSize <= 0.0f)
+    {
+        return Hit;
+    }
+    double Lower[3], Upper[3], Delta[3];
+    int64_t Min[3], Max[3];
+    for (int32_t Axis = 0; Axis < 3; Axis++)
+    {
+        const double Base = (double)Sweep.OriginChunk[Axis] * Resolution;
+        Lower[Axis] = Base + (double)Sweep.LocalMin[Axis] / BlockSize;
+        Upper[Axis] = Base + (double)Sweep.LocalMax[Axis] / BlockSize;
+        Delta[Axis] = (double)Sweep.Delta[Axis] / BlockSize;
+        Min[Axis] = (int64_t)std::floor(Lower[Axis]);
+        Max[Axis] = (int64_t)std::ceil(Upper[Axis]) - 1;
+    }
+    if (bAnySolidBlock(FindChunk, Cache, Min, Max))
+    {
+        Hit.bHit = true;
+        Hit.bStartSolid = true;
+        Hit.Time = 0.0f;
+        return Hit;
+    }
+    //Boundary the leading face crosses next on every axis, and when
+    int64_t Boundary[3];
+    double BoundaryTime[3];
+    for (int32_t Axis = 0; Axis < 3; Axis++)
+    {
+        Boundary[Axis] = Delta[Axis] > 0.0 ? (int64_t)std::ceil(Upper[Axis]) : (int64_t)std::floor(Lower[Axis]);
+        BoundaryTime[Axis] = Delta[Axis] == 0.0 ? INFINITY : ((double)Boundary[Axis] - (Delta[Axis] > 0.0 ? Upper[Axis] : Lower[Axis])) / Delta[Axis];
+    }
+    while (true)
+    {
+        const int32_t Axis = BoundaryTime[0] < BoundaryTime[1] ? (BoundaryTime[0] < BoundaryTime[2] ? 0 : 2) : (BoundaryTime[1] < BoundaryTime[2] ? 1 : 2);
+        const double Time = BoundaryTime[Axis];
+        if (!(Time <= 1.0))
+        {
+            return Hit;
+        }
+        for (int32_t Other = 0; Other < 3; Other++)
+        {
+            const double OtherLower = Lower[Other] + Delta[Other] * Time;
+            const double OtherUpper = Upper[Other] + Delta[Other] * Time;
+            Min[Other] = Delta[Other] < 0.0 ? (int64_t)std::ceil(OtherLower) - 1 : (int64_t)std::floor(OtherLower);
+            Max[Other] = Delta[Other] > 0.0 ? (int64_t)std::floor(OtherUpper) : (int64_t)std::ceil(OtherUpper) - 1;
+        }
+        const int64_t Layer = Delta[Axis] > 0.0 ? Boundary[Axis] : Boundary[Axis] - 1;
+        Min[Axis] = Layer;
+        Max[Axis] = Layer;
+        if (bAnySolidBlock(FindChunk, Cache, Min, Max))
+        {
+            Hit.bHit = true;
+            Hit.Time = (float)std::max(Time, 0.0);
+            Hit.Normal[Axis] = Delta[Axis] > 0.0 ? -1 : 1;
+            return Hit;
+        }
+        Boundary[Axis] += Delta[Axis] > 0.0 ? 1 : -1;
+        BoundaryTime[Axis] = ((double)Boundary[Axis] - (Delta[Axis] > 0.0 ? Upper[Axis] : Lower[Axis])) / Delta[Axis];
+    }
+}
@@ -8,6 +8,11 @@ using glm::ivec4;
 using glm::u8vec3;
 using glm::u8vec4;
 
+//Chunk resolution is fixed at compile time so the chunk occupancy can live inline, 8, 16, 32 or 64 (block locations stay u8)
+#if !defined(MESO_CHUNK_RESOLUTION)
+#define MESO_CHUNK_RESOLUTION 16
+#endif
+constexpr uint32_t kChunkResolution = MESO_CHUNK_RESOLUTION;
 
 enum class EChunkOverrideMode : uint8_t
 {
@@ -21,15 +26,15 @@ struct FVoxelSceneConfig
 {
 	unsigned char BlockResolution = 8; //This won't change basically
 	float BlockSize = 1.0f;
-	unsigned char ChunkResolution = 16;
+	static constexpr unsigned char ChunkResolution = (unsigned char)kChunkResolution;//Not configurable, the chunk volumes are sized by MESO_CHUNK_RESOLUTION
 	uint32_t MaxBlockCount = 65536 * 16;
 	uint32_t MaxVolumeCount = 65536 * 16;
 	uint32_t MaxChunkCount = 8192 * 2;
 	uint32_t MaxEmptyChunkCount = 8192 * 4;
 
-	uint32_t MaxChunkCheckTimes = 128;
-	uint32_t MaxEmptyChunkCheckTimes = 128;
 	uint32_t MaxBlockCheckTimes = 16;
+	uint32_t BlockPageSize = 4096;//Block slots move between the generator threads a page at a time
+	uint32_t UploadMergeGapBytes = 4096;//Dirty ranges of a GPU buffer closer than this are sent as one upload
 
 	uint32_t BakeVisibilityViewNum = 256;
 	uint32_t ViewForwardLoadChunkSize = 24;
@@ -40,9 +45,18 @@ struct FVoxelSceneConfig
 	EChunkOverrideMode ChunkOverrideMode = EChunkOverrideMode::FindMin;// 
 	float ViewChunkAngle = 120.0f;//should = fov
 
+	//LOD, a level N chunk keeps ChunkResolution^3 blocks of BlockSize * 2^N
+	uint32_t MaxChunkMipmapLevel = 2; //0 disables LOD
+	float LodDistance = 8.0f; //In chunks, level N is used from LodDistance * 2^(N-1)
+
 	//Chunk config
-	uint32_t ChunkOccupancyDepth = 4;
-	uint32_t ChunkInnerVoxelCullDepthThreshold = 1;
+	uint32_t ChunkInnerVoxelCullDepthThreshold = 1;//Blocks deeper than this inside their chunk aren't pushed, FChunkPool::SetCullDepthThreshold changes it per frame
+	uint32_t ChunkMaxCullDepthThreshold = 1;//Occupancy generated chunks only keep blocks this deep, the threshold can't be raised past it without regenerating
+	bool bMortonBlockOrder = false;//Occupancy generated chunks list their blocks in Z-order instead of X, Y, Z
+
+	//Spatial queries
+	uint32_t QueryThreadCount = 0;//Threads of the batched ray/sweep queries, 0 borrows free generator threads
+	uint32_t QueryBorrowedThreadCount = 1;//With QueryThreadCount 0, the most generator threads a batch takes. They generate nothing until the batch is done
 	float GetChunkSize() const
 	{
 		return ChunkResolution * BlockSize;
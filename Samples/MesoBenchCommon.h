@@ -0,0 +1,91 @@
+// Meso Engine 2024
+#pragma once
+#include "Helper/GeneratorHelper.h"
+#include "Voxel/Chunk/ChunkManagerHelper.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+//Shared by the headless benches (MesoGenBench, MesoPoolBench, MesoSpatialBench), no window or vulkan context is created
+using FBenchmarkClock = std::chrono::steady_clock;
+
+using FGeneratorFunction = FChunk(*)(ivec3, float, unsigned char, uint32_t);
+using FClassifierFunction = EGeneratorRegion(*)(ivec3, float, unsigned char, uint32_t);
+using FOccupancyGeneratorFunction = void(*)(FChunkOccupancyVolume&, ivec3, float, unsigned char, uint32_t);
+
+inline std::vector<ivec3> GetBenchmarkChunkLocations(int32_t HalfExtent, int32_t HalfHeight = 2)
+{
+    std::vector<ivec3> Locations;
+    for (int32_t X = -HalfExtent; X < HalfExtent; X++)
+    {
+        for (int32_t Y = -HalfHeight; Y < HalfHeight; Y++)//Default is around the surface, where every chunk is mixed
+        {
+            for (int32_t Z = -HalfExtent; Z < HalfExtent; Z++)
+            {
+                Locations.push_back({ X, Y, Z });
+            }
+        }
+    }
+    return Locations;
+}
+
+//Chunk of the test generator the way FChunkManage::GenerateAndPushChunk makes it, ChunkLocation in level 0 chunk units
+inline FChunk GenerateLevelChunk(const ivec3 ChunkLocation, const uint32_t MipmapLevel, const FVoxelSceneConfig& VoxelSceneConfig)
+{
+    FChunk Chunk = FGeneratorHelper::TestGeneratorBatched<>(ChunkLocation >> (int32_t)MipmapLevel, VoxelSceneConfig.BlockSize * (float)(1u << MipmapLevel), VoxelSceneConfig.ChunkResolution, MipmapLevel);
+    Chunk.CalculateOccupancyInteriorDepth();
+    Chunk.ChunkLocation = ChunkLocation;
+    Chunk.MipmapLevel = MipmapLevel;
+    return Chunk;
+}
+
+//Options every bench takes, the rest are up to the bench
+struct FBenchOptions
+{
+    int32_t HalfExtent = 4;
+    int32_t HalfHeight = 2;
+    std::vector<uint32_t> ThreadNums;
+};
+
+//True if argv[i] (and its value) was one of the shared options, i is left on the last argument read
+inline bool ParseBenchOption(int argc, char* argv[], int& i, FBenchOptions& Options)
+{
+    const std::string Arg = argv[i];
+    const bool bHasValue = i + 1 < argc;
+    if (Arg == "--extent" && bHasValue)
+    {
+        Options.HalfExtent = std::max(1, atoi(argv[++i]));
+    }
+    else if (Arg == "--height" && bHasValue)
+    {
+        Options.HalfHeight = std::max(1, atoi(argv[++i]));
+    }
+    else if (Arg == "--threads" && bHasValue)
+    {
+        std::stringstream List(argv[++i]);
+        for (std::string Item; std::getline(List, Item, ',');)
+        {
+            Options.ThreadNums.push_back((uint32_t)std::max(1, atoi(Item.c_str())));
+        }
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+//Default thread counts once the options are read
+inline void FinishBenchOptions(FBenchOptions& Options)
+{
+    if (Options.ThreadNums.empty())
+    {
+        Options.ThreadNums = { 1u, std::max(1u, std::thread::hardware_concurrency()) };
+    }
+}
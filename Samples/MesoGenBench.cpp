@@ -0,0 +1,1059 @@
+#include "MesoBenchCommon.h"
+#include "Helper/GeneratorGraph.h"
+
+#include <array>
+#include <bit>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+
+struct FGeneratorBenchmarkResult
+{
+    double Seconds = 0.0;
+    uint64_t BlockCount = 0;
+    std::vector<FChunk> Chunks;
+};
+
+static FGeneratorBenchmarkResult RunGenerator(FGeneratorFunction Generator, const std::vector<ivec3>& Locations, const FVoxelSceneConfig& VoxelSceneConfig)
+{
+    FGeneratorBenchmarkResult Result;
+    Result.Chunks.reserve(Locations.size());
+    auto Start = FBenchmarkClock::now();
+    for (const ivec3& Location : Locations)
+    {
+        Result.Chunks.push_back(Generator(Location, VoxelSceneConfig.BlockSize, VoxelSceneConfig.ChunkResolution, 0));
+        Result.BlockCount += Result.Chunks.back().Blocks.size();
+    }
+    Result.Seconds = std::chrono::duration<double>(FBenchmarkClock::now() - Start).count();
+    return Result;
+}
+
+static void PrintResult(const char* Name, const FGeneratorBenchmarkResult& Result, size_t ChunkNum, uint32_t ChunkResolution)
+{
+    const double VoxelNum = (double)ChunkNum * ChunkResolution * ChunkResolution * ChunkResolution;
+    printf("%-34s %8.3lf ms/chunk %10.1lf chunks/s %8.2lf Mvoxels/s (%llu blocks)\n", Name,
+        Result.Seconds * 1000.0 / std::max<size_t>(ChunkNum, 1), ChunkNum / std::max(Result.Seconds, 1e-9),
+        VoxelNum / std::max(Result.Seconds, 1e-9) * 1e-6, (unsigned long long)Result.BlockCount);
+}
+
+static uint32_t CountMismatchedChunks(const FGeneratorBenchmarkResult& A, const FGeneratorBenchmarkResult& B)
+{
+    uint32_t Mismatch = 0;
+    for (size_t i = 0; i < A.Chunks.size(); i++)
+    {
+        const auto& BlocksA = A.Chunks[i].Blocks;
+        const auto& BlocksB = B.Chunks[i].Blocks;
+        bool bSame = BlocksA.size() == BlocksB.size();
+        for (size_t j = 0; bSame && j < BlocksA.size(); j++)
+        {
+            bSame = BlocksA[j].BlockLocation == BlocksB[j].BlockLocation;
+        }
+        Mismatch += bSame ? 0 : 1;
+    }
+    return Mismatch;
+}
+
+//Empty/solid answers must match the generated chunk, returns the wrong ones and the time with classification
+static uint32_t CountMisclassifiedChunks(FClassifierFunction Classifier, FGeneratorFunction Generator, const std::vector<ivec3>& Locations, const FVoxelSceneConfig& VoxelSceneConfig, uint32_t RegionCount[3], double& ClassifiedSeconds)
+{
+    const uint64_t VoxelNum = (uint64_t)VoxelSceneConfig.ChunkResolution * VoxelSceneConfig.ChunkResolution * VoxelSceneConfig.ChunkResolution;
+    uint32_t Wrong = 0;
+    ClassifiedSeconds = 0.0;
+    for (const ivec3& Location : Locations)
+    {
+        auto Start = FBenchmarkClock::now();
+        const EGeneratorRegion Region = Classifier(Location, VoxelSceneConfig.BlockSize, VoxelSceneConfig.ChunkResolution, 0);
+        if (Region == EGeneratorRegion::Mixed)
+        {
+            Generator(Location, VoxelSceneConfig.BlockSize, VoxelSceneConfig.ChunkResolution, 0);
+        }
+        ClassifiedSeconds += std::chrono::duration<double>(FBenchmarkClock::now() - Start).count();
+        RegionCount[(uint32_t)Region]++;
+        if (Region != EGeneratorRegion::Mixed)
+        {
+            const size_t BlockNum = Generator(Location, VoxelSceneConfig.BlockSize, VoxelSceneConfig.ChunkResolution, 0).Blocks.size();
+            Wrong += (Region == EGeneratorRegion::Empty ? BlockNum != 0 : BlockNum != VoxelNum) ? 1 : 0;
+        }
+    }
+    return Wrong;
+}
+
+static uint32_t RunClassifier(const char* Name, FClassifierFunction Classifier, FGeneratorFunction Generator, const std::vector<ivec3>& Locations, const FVoxelSceneConfig& VoxelSceneConfig)
+{
+    uint32_t RegionCount[3] = { 0, 0, 0 };
+    double ClassifiedSeconds = 0.0;
+    const uint32_t Wrong = CountMisclassifiedChunks(Classifier, Generator, Locations, VoxelSceneConfig, RegionCount, ClassifiedSeconds);
+    const FGeneratorBenchmarkResult Full = RunGenerator(Generator, Locations, VoxelSceneConfig);
+    printf("%-34s %u empty, %u solid, %u mixed, %.3lf ms/chunk classified vs %.3lf ms/chunk full, %u wrong\n", Name,
+        RegionCount[0], RegionCount[1], RegionCount[2], ClassifiedSeconds * 1000.0 / Locations.size(), Full.Seconds * 1000.0 / Locations.size(), Wrong);
+    return Wrong;
+}
+
+//Compares the octree generator against brute force on the mixed chunks, and counts Sdf evaluations per chunk
+static uint32_t RunLipschitz(const char* Name, double(*Sdf)(dvec3), double Lipschitz, FGeneratorFunction BruteGenerator, FClassifierFunction Classifier, const std::vector<ivec3>& Locations, const FVoxelSceneConfig& VoxelSceneConfig)
+{
+    std::vector<ivec3> MixedLocations;
+    for (const ivec3& Location : Locations)
+    {
+        if (Classifier(Location, VoxelSceneConfig.BlockSize, VoxelSceneConfig.ChunkResolution, 0) == EGeneratorRegion::Mixed)
+        {
+            MixedLocations.push_back(Location);
+        }
+    }
+    FGeneratorBenchmarkResult Brute = RunGenerator(BruteGenerator, MixedLocations, VoxelSceneConfig);
+    FGeneratorBenchmarkResult Octree;
+    uint64_t EvaluationNum = 0;
+    auto CountedSdf = [&](dvec3 Location)
+        {
+            EvaluationNum++;
+            return Sdf(Location);
+        };
+    auto Start = FBenchmarkClock::now();
+    for (const ivec3& Location : MixedLocations)
+    {
+        Octree.Chunks.push_back(FGeneratorHelper::GenerateLipschitz(Location, VoxelSceneConfig.BlockSize, VoxelSceneConfig.ChunkResolution, 0, CountedSdf, Lipschitz));
+    }
+    Octree.Seconds = std::chrono::duration<double>(FBenchmarkClock::now() - Start).count();
+    const uint32_t Mismatch = CountMismatchedChunks(Brute, Octree);
+    const size_t ChunkNum = std::max<size_t>(MixedLocations.size(), 1);
+    printf("%-34s %zu mixed chunks, %.1lf evaluations/chunk (brute %d), %.3lf ms/chunk vs %.3lf ms/chunk brute, %u mismatched\n", Name, MixedLocations.size(),
+        (double)EvaluationNum / ChunkNum, VoxelSceneConfig.ChunkResolution * VoxelSceneConfig.ChunkResolution * VoxelSceneConfig.ChunkResolution,
+        Octree.Seconds * 1000.0 / ChunkNum, Brute.Seconds * 1000.0 / ChunkNum, Mismatch);
+    return Mismatch;
+}
+
+//Generates the chunks wanted by one view, every chunk at level 0 vs levels picked like FChunkManage::UpdateLoadingQueue
+static void RunLod(FGeneratorFunction Generator, FClassifierFunction Classifier, FVoxelSceneConfig VoxelSceneConfig)
+{
+    const vec3 ForwardVector = normalize(vec3(1.0f, -0.2f, 0.3f));
+    FChunkManageHelper::FImportanceChunkQueue Desired = FChunkManageHelper::GetDesiredShowChunkLocationByView(ForwardVector, VoxelSceneConfig);
+    std::vector<ivec3> Offsets;
+    while (!Desired.empty())
+    {
+        Offsets.push_back(Desired.top().second);
+        Desired.pop();
+    }
+    for (uint32_t MaxLevel : { 0u, VoxelSceneConfig.MaxChunkMipmapLevel })
+    {
+        FImportanceComputeInfo CameraInfo = { .CameraChunk = { 0, 0, 0 }, .CameraForwardVector = ForwardVector, .MaxChunkMipmapLevel = MaxLevel, .LodDistance = VoxelSceneConfig.LodDistance };
+        std::set<ivec4, FIVec4Comparator> Keys;
+        for (const ivec3& Offset : Offsets)
+        {
+            const uint32_t Level = CameraInfo.CalculateChunkMipmapLevel(Offset);
+            Keys.insert(ivec4(FImportanceComputeInfo::AlignChunkLocation(Offset, Level), (int32_t)Level));
+        }
+        uint32_t MixedNum = 0;
+        auto Start = FBenchmarkClock::now();
+        for (const ivec4& Key : Keys)
+        {
+            //Same conversion as FChunkManage::GenerateAndPushChunk
+            const ivec3 LevelChunkLocation = ivec3(Key.x >> Key.w, Key.y >> Key.w, Key.z >> Key.w);
+            const float LevelBlockSize = VoxelSceneConfig.BlockSize * (float)(1 << Key.w);
+            if (Classifier(LevelChunkLocation, LevelBlockSize, VoxelSceneConfig.ChunkResolution, Key.w) == EGeneratorRegion::Mixed)
+            {
+                Generator(LevelChunkLocation, LevelBlockSize, VoxelSceneConfig.ChunkResolution, Key.w);
+                MixedNum++;
+            }
+        }
+        const double Seconds = std::chrono::duration<double>(FBenchmarkClock::now() - Start).count();
+        printf("LOD max level %u                    %zu desired, %zu chunks, %u mixed, %.1lf ms total\n", MaxLevel, Offsets.size(), Keys.size(), MixedNum, Seconds * 1000.0);
+    }
+}
+
+//Block list path (generator + CalculateOccupancyInteriorDepth) vs occupancy path (like FChunkManage::GenerateAndPushChunk), same occupancy, depths and pushed blocks expected
+static uint32_t RunOccupancy(const char* Name, FGeneratorFunction Generator, FOccupancyGeneratorFunction OccupancyGenerator, const std::vector<ivec3>& Locations, const FVoxelSceneConfig& VoxelSceneConfig)
+{
+    const uint32_t Resolution = VoxelSceneConfig.ChunkResolution;
+    std::vector<FChunk> BlockChunks;
+    std::vector<FChunk> OccupancyChunks(Locations.size());
+    auto Start = FBenchmarkClock::now();
+    for (const ivec3& Location : Locations)
+    {
+        BlockChunks.push_back(Generator(Location, VoxelSceneConfig.BlockSize, Resolution, 0));
+        BlockChunks.back().CalculateOccupancyInteriorDepth();
+    }
+    const double BlockSeconds = std::chrono::duration<double>(FBenchmarkClock::now() - Start).count();
+    Start = FBenchmarkClock::now();
+    for (size_t i = 0; i < Locations.size(); i++)
+    {
+        FChunk& Chunk = OccupancyChunks[i];
+        OccupancyGenerator(Chunk.InitializeOccupancy(), Locations[i], VoxelSceneConfig.BlockSize, Resolution, 0);
+        Chunk.CalculateInteriorDepthFromOccupancy();
+        Chunk.GatherSurfaceBlocks();
+    }
+    const double OccupancySeconds = std::chrono::duration<double>(FBenchmarkClock::now() - Start).count();
+    uint32_t Mismatch = 0;
+    size_t BlockMemory = 0;
+    size_t OccupancyMemory = 0;
+    for (size_t i = 0; i < Locations.size(); i++)
+    {
+        const FChunk& A = BlockChunks[i];
+        const FChunk& B = OccupancyChunks[i];
+        BlockMemory += A.GetMemorySize();
+        OccupancyMemory += B.GetMemorySize();
+        bool bSame = A.Occupancy == B.Occupancy && A.InteriorDepth == B.InteriorDepth;
+        //Same filter as FChunkPool::PushToBlockPool
+        size_t PushedNum = 0;
+        for (const FBlock& Block : A.Blocks)
+        {
+            PushedNum += A.bShouldVoxelOccupancyCull(Block.BlockLocation, 1) ? 0 : 1;
+        }
+        bSame = bSame && PushedNum == B.Blocks.size();
+        for (size_t j = 0; bSame && j < B.Blocks.size(); j++)
+        {
+            bSame = !A.bShouldVoxelOccupancyCull(B.Blocks[j].BlockLocation, 1) && A.Occupancy.Get(ivec3(B.Blocks[j].BlockLocation));
+        }
+        Mismatch += bSame ? 0 : 1;
+    }
+    const size_t ChunkNum = std::max<size_t>(Locations.size(), 1);
+    printf("%-34s %.3lf ms/chunk vs %.3lf ms/chunk block list, %.1lf KB/chunk vs %.1lf KB/chunk, %u mismatched\n", Name,
+        OccupancySeconds * 1000.0 / ChunkNum, BlockSeconds * 1000.0 / ChunkNum, OccupancyMemory / 1024.0 / ChunkNum, BlockMemory / 1024.0 / ChunkNum, Mismatch);
+    return Mismatch;
+}
+
+static FChunk GraphTestGenerator(ivec3 StartLocation, float BlockSize, unsigned char ChunkResolution, uint32_t MipmapLevel)
+{
+    static const auto Graph = FGeneratorGraph::MakeTestGeneratorGraph();
+    return FGeneratorGraph::Generate(Graph, StartLocation, BlockSize, ChunkResolution, MipmapLevel);
+}
+
+static FChunk GraphFbmTerrain(ivec3 StartLocation, float BlockSize, unsigned char ChunkResolution, uint32_t MipmapLevel)
+{
+    static const auto Graph = FGeneratorGraph::MakeFbmTerrainGraph();
+    return FGeneratorGraph::Generate(Graph, StartLocation, BlockSize, ChunkResolution, MipmapLevel);
+}
+
+//TestGenerator with float samples in world space, what the float path would be without the lattice origin
+static void TestGeneratorWorldFloatOccupancy(FChunkOccupancyVolume& Occupancy, ivec3 StartLocation, float BlockSize, unsigned char ChunkResolution, uint32_t MipmapLevel)
+{
+    const dvec3 ChunkStartLocation = (dvec3)StartLocation * (double)BlockSize * (double)ChunkResolution;
+    TVec3Lanes<float> Samples;
+    alignas(64) float Displacement[kSimdLaneNum];
+    for (uint32_t X = 0; X < ChunkResolution; X++)
+    {
+        for (uint32_t Y = 0; Y < ChunkResolution; Y++)
+        {
+            for (uint32_t ZStart = 0; ZStart < ChunkResolution; ZStart += kSimdLaneNum)
+            {
+                for (uint32_t i = 0; i < kSimdLaneNum; i++)
+                {
+                    const dvec3 SampleLocation = (ChunkStartLocation + dvec3{ X, Y, std::min(ZStart + i, (uint32_t)ChunkResolution - 1u) } *(double)BlockSize) * .1;
+                    Samples.X[i] = (float)SampleLocation.x;
+                    Samples.Y[i] = (float)SampleLocation.y;
+                    Samples.Z[i] = (float)SampleLocation.z;
+                }
+                FGeneratorHelper::displacementLanes<float, kSimdLaneNum, ENoiseHashMode::Integer>(Samples, Displacement);
+                for (uint32_t i = 0; i < kSimdLaneNum && ZStart + i < ChunkResolution; i++)
+                {
+                    const double BlockCenterY = ChunkStartLocation.y + (double)Y * (double)BlockSize;
+                    if ((BlockCenterY * .5 + Displacement[i] * 10.3) * .4 < 0.0)
+                    {
+                        Occupancy.Set(true, { X, Y, ZStart + i });
+                    }
+                }
+            }
+        }
+    }
+}
+
+template<uint32_t Resolution>
+static uint32_t CountDifferentVoxels(const TBinaryOccupancyVolume<Resolution>& A, const TBinaryOccupancyVolume<Resolution>& B)
+{
+    uint32_t Result = 0;
+    for (uint32_t w = 0; w < A.WordNum; w++)
+    {
+        Result += (uint32_t)std::popcount(A.Words[w] ^ B.Words[w]);
+    }
+    return Result;
+}
+
+//Float generators against the double one, the same chunk block shifted far from the origin. Chunk-local float has to stay as close as near the origin
+static uint32_t RunFloatAccuracy(const std::vector<ivec3>& Locations, const FVoxelSceneConfig& VoxelSceneConfig)
+{
+    const uint32_t Resolution = VoxelSceneConfig.ChunkResolution;
+    const double MaxMismatchRatio = 1e-3;
+    uint32_t Failed = 0;
+    for (int32_t Offset : { 0, 1 << 10, 1 << 16 })
+    {
+        uint64_t VoxelNum = 0, LocalMismatch = 0, WorldMismatch = 0;
+        double DoubleSeconds = 0.0, FloatSeconds = 0.0;
+        for (const ivec3& Location : Locations)
+        {
+            const ivec3 FarLocation = Location + ivec3(Offset, 0, -Offset);
+            FChunkOccupancyVolume Reference, Local, World;
+            //Float gets twice the lanes, both fill the same registers
+            auto Start = FBenchmarkClock::now();
+            FGeneratorHelper::TestGeneratorOccupancy<>(Reference, FarLocation, VoxelSceneConfig.BlockSize, Resolution, 0);
+            DoubleSeconds += std::chrono::duration<double>(FBenchmarkClock::now() - Start).count();
+            Start = FBenchmarkClock::now();
+            FGeneratorHelper::TestGeneratorOccupancy<kSimdLaneNum * 2, ENoiseHashMode::Integer, true, float>(Local, FarLocation, VoxelSceneConfig.BlockSize, Resolution, 0);
+            FloatSeconds += std::chrono::duration<double>(FBenchmarkClock::now() - Start).count();
+            TestGeneratorWorldFloatOccupancy(World, FarLocation, VoxelSceneConfig.BlockSize, Resolution, 0);
+            VoxelNum += FChunkOccupancyVolume::VoxelNum;
+            LocalMismatch += CountDifferentVoxels(Reference, Local);
+            WorldMismatch += CountDifferentVoxels(Reference, World);
+        }
+        const double LocalRatio = (double)LocalMismatch / std::max<uint64_t>(VoxelNum, 1);
+        printf("Float TestGenerator, offset %-7d %.3lf ms/chunk vs %.3lf ms/chunk double, voxel mismatch %.5lf%% chunk-local, %.5lf%% world float\n", Offset,
+            FloatSeconds * 1000.0 / Locations.size(), DoubleSeconds * 1000.0 / Locations.size(), LocalRatio * 100.0, (double)WorldMismatch / std::max<uint64_t>(VoxelNum, 1) * 100.0);
+        Failed += LocalRatio > MaxMismatchRatio ? 1 : 0;
+    }
+    return Failed;
+}
+
+/*
+Word-parallel erosion over the 26 neighbours, Result = erode(Base) & Mask, 0 on the one voxel border. A mip of the old erode chain the interior depth replaced,
+neighbours along X are the row shifted by one, along Y/Z the neighbouring rows
+*/
+template<uint32_t Resolution>
+static void ErodeVolumeMasked(const TBinaryOccupancyVolume<Resolution>& Base, const TBinaryOccupancyVolume<Resolution>& Mask, TBinaryOccupancyVolume<Resolution>& Result)
+{
+    constexpr uint64_t InnerMask = TBinaryOccupancyVolume<Resolution>::RowMask & ~1ull & ~(1ull << (Resolution - 1));
+    Result.Reset();
+    for (uint32_t Z = 1; Z + 1 < Resolution; Z++)
+    {
+        for (uint32_t Y = 1; Y + 1 < Resolution; Y++)
+        {
+            const uint32_t Row = Y + Z * Resolution;
+            const uint64_t Center = Base.GetRow(Row);
+            uint64_t Eroded = (Center << 1) & (Center >> 1);
+            for (int32_t dZ = -1; dZ <= 1; dZ++)
+            {
+                for (int32_t dY = -1; dY <= 1; dY++)
+                {
+                    const uint64_t Neighbour = Base.GetRow((uint32_t)((int32_t)Row + dY + dZ * (int32_t)Resolution));
+                    Eroded &= (dZ == 0 && dY == 0) ? ~0ull : Neighbour & (Neighbour << 1) & (Neighbour >> 1);
+                }
+            }
+            Result.SetRow(Row, Eroded & InnerMask & Mask.GetRow(Row));
+        }
+    }
+}
+
+template<uint32_t Resolution>
+static TBinaryOccupancyVolume<Resolution> ErodeVolumePerVoxel(const TBinaryOccupancyVolume<Resolution>& Volume)
+{
+    TBinaryOccupancyVolume<Resolution> Result;
+    for (uint32_t i = 0; i < Result.VoxelNum; i++)
+    {
+        const ivec3 Location = Result.GetLocation(i);
+        bool bEroded = !FVoxelMathHelper::bIsOutOfBoundThickness(Location, ivec3(Resolution), 1u);
+        for (int32_t Neighbour = 0; Neighbour < 27 && bEroded; Neighbour++)
+        {
+            bEroded = Neighbour == 13 || Volume.Get(Location + ivec3(Neighbour % 3 - 1, Neighbour / 3 % 3 - 1, Neighbour / 9 - 1));
+        }
+        Result.SetBit(bEroded, i);
+    }
+    return Result;
+}
+
+template<uint32_t Resolution, typename FRandom>
+static uint32_t RunFixedErosion(FRandom& Random, double Density)
+{
+    TBinaryOccupancyVolume<Resolution> Volume, Mask, Eroded;
+    for (uint32_t i = 0; i < Volume.VoxelNum; i++)
+    {
+        Volume.SetBit(Random() < Density, i);
+    }
+    Mask.Fill();
+    ErodeVolumeMasked(Volume, Mask, Eroded);
+    return Eroded == ErodeVolumePerVoxel(Volume) ? 0 : 1;
+}
+
+//The erode chain reference of RunInteriorDepth against a per voxel erosion on random volumes
+static uint32_t RunErosion(const FVoxelSceneConfig& VoxelSceneConfig)
+{
+    uint32_t Mismatch = 0;
+    uint32_t Seed = 12345u;
+    auto Random = [&Seed]() { Seed = Seed * 1664525u + 1013904223u; return (Seed >> 8) * (1.0 / 16777216.0); };
+    for (double Density : { 0.5, 0.95, 0.999, 1.0 })
+    {
+        Mismatch += RunFixedErosion<8>(Random, Density);
+        Mismatch += RunFixedErosion<16>(Random, Density);
+        Mismatch += RunFixedErosion<32>(Random, Density);
+        Mismatch += RunFixedErosion<64>(Random, Density);
+    }
+    printf("Erosion                            %u mismatched\n", Mismatch);
+    return Mismatch;
+}
+
+//Interior depth thresholds against the erode chain (mip d = erode(mip d-1) & mip 0) on generated, solid and random chunks, then the time for both
+static uint32_t RunInteriorDepth(const FVoxelSceneConfig& VoxelSceneConfig)
+{
+    const uint32_t CheckDepth = 8;
+    const uint32_t ChainDepth = 4;//Old ChunkOccupancyDepth default
+    std::vector<FChunkOccupancyVolume> Volumes;
+    for (const ivec3& Location : GetBenchmarkChunkLocations(2))
+    {
+        FChunkOccupancyVolume& Volume = Volumes.emplace_back();
+        FGeneratorHelper::TestGeneratorOccupancy<>(Volume, Location, VoxelSceneConfig.BlockSize, VoxelSceneConfig.ChunkResolution, 0);
+    }
+    Volumes.emplace_back().Fill();
+    uint32_t Seed = 777u;
+    for (double Density : { 0.99, 0.999 })
+    {
+        FChunkOccupancyVolume& Volume = Volumes.emplace_back();
+        for (uint32_t i = 0; i < Volume.VoxelNum; i++)
+        {
+            Seed = Seed * 1664525u + 1013904223u;
+            Volume.SetBit((Seed >> 8) * (1.0 / 16777216.0) < Density, i);
+        }
+    }
+    uint32_t Mismatch = 0;
+    for (const FChunkOccupancyVolume& Volume : Volumes)
+    {
+        FChunkInteriorDepthVolume Depth;
+        Depth.Calculate(Volume);
+        FChunkOccupancyVolume Mip = Volume, Next;
+        for (uint32_t d = 0; d < CheckDepth; d++)
+        {
+            for (uint32_t i = 0; i < Volume.VoxelNum; i++)
+            {
+                Mismatch += Mip.GetBit(i) != (Depth.GetDepth(i) > d) ? 1 : 0;
+            }
+            ErodeVolumeMasked(Mip, Volume, Next);
+            Mip = Next;
+        }
+    }
+    FChunkInteriorDepthVolume Depth;
+    auto Start = FBenchmarkClock::now();
+    for (const FChunkOccupancyVolume& Volume : Volumes)
+    {
+        Depth.Calculate(Volume);
+    }
+    const double DepthSeconds = std::chrono::duration<double>(FBenchmarkClock::now() - Start).count();
+    std::array<FChunkOccupancyVolume, ChainDepth> Mips;
+    Start = FBenchmarkClock::now();
+    for (const FChunkOccupancyVolume& Volume : Volumes)
+    {
+        Mips[0] = Volume;
+        for (uint32_t d = 1; d < ChainDepth; d++)
+        {
+            ErodeVolumeMasked(Mips[d - 1], Mips[0], Mips[d]);
+        }
+    }
+    const double ChainSeconds = std::chrono::duration<double>(FBenchmarkClock::now() - Start).count();
+    printf("Interior depth                     %.2lf us/chunk (%zu B, any depth) vs %.2lf us/chunk %u mip erode chain (%zu B), %u mismatched voxels\n",
+        DepthSeconds * 1e6 / Volumes.size(), sizeof(FChunkInteriorDepthVolume), ChainSeconds * 1e6 / Volumes.size(), ChainDepth, sizeof(Mips), Mismatch);
+    return Mismatch;
+}
+
+//Every pyramid cell against the OR of its voxels, GetEmptyLevel against the cubes, and the build time next to the interior depth
+static uint32_t RunOccupancyPyramid(const FVoxelSceneConfig& VoxelSceneConfig)
+{
+    std::vector<FChunkOccupancyVolume> Volumes;
+    for (const ivec3& Location : GetBenchmarkChunkLocations(2))
+    {
+        FChunkOccupancyVolume& Volume = Volumes.emplace_back();
+        FGeneratorHelper::TestGeneratorOccupancy<>(Volume, Location, VoxelSceneConfig.BlockSize, VoxelSceneConfig.ChunkResolution, 0);
+    }
+    Volumes.emplace_back().Fill();
+    Volumes.emplace_back();
+    uint32_t Seed = 4242u;
+    for (double Density : { 0.001, 0.01 })
+    {
+        FChunkOccupancyVolume& Volume = Volumes.emplace_back();
+        for (uint32_t i = 0; i < Volume.VoxelNum; i++)
+        {
+            Seed = Seed * 1664525u + 1013904223u;
+            Volume.SetBit((Seed >> 8) * (1.0 / 16777216.0) < Density, i);
+        }
+    }
+    constexpr int32_t Resolution = (int32_t)kChunkResolution;
+    uint32_t Mismatch = 0;
+    size_t EmptyLevelSum = 0;
+    for (const FChunkOccupancyVolume& Volume : Volumes)
+    {
+        FChunkOccupancyPyramid Pyramid;
+        Pyramid.Calculate(Volume);
+        for (uint32_t Level = 1; Level <= FChunkOccupancyPyramid::LevelNum; Level++)
+        {
+            const int32_t Size = 1 << Level;
+            for (int32_t Z = 0; Z < Resolution; Z += Size)
+            {
+                for (int32_t Y = 0; Y < Resolution; Y += Size)
+                {
+                    for (int32_t X = 0; X < Resolution; X += Size)
+                    {
+                        bool bAny = false;
+                        for (int32_t i = 0; i < Size * Size * Size && !bAny; i++)
+                        {
+                            bAny = Volume.Get({ X + i % Size, Y + (i / Size) % Size, Z + i / (Size * Size) });
+                        }
+                        Mismatch += Pyramid.bAny(Level, ivec3{ X, Y, Z } >> (int32_t)Level) != bAny ? 1 : 0;
+                    }
+                }
+            }
+        }
+        for (uint32_t i = 0; i < Volume.VoxelNum; i++)
+        {
+            const ivec3 Voxel = FChunkOccupancyVolume::GetLocation(i);
+            const uint32_t EmptyLevel = Pyramid.GetEmptyLevel(Voxel);
+            const bool bCoarserEmpty = EmptyLevel < FChunkOccupancyPyramid::LevelNum && !Pyramid.bAny(EmptyLevel + 1, Voxel >> (int32_t)(EmptyLevel + 1));
+            Mismatch += (EmptyLevel > 0 && Pyramid.bAny(EmptyLevel, Voxel >> (int32_t)EmptyLevel)) || bCoarserEmpty ? 1 : 0;
+            EmptyLevelSum += EmptyLevel;
+        }
+    }
+    FChunkOccupancyPyramid Pyramid;
+    auto Start = FBenchmarkClock::now();
+    for (const FChunkOccupancyVolume& Volume : Volumes)
+    {
+        Pyramid.Calculate(Volume);
+    }
+    const double PyramidSeconds = std::chrono::duration<double>(FBenchmarkClock::now() - Start).count();
+    FChunkInteriorDepthVolume Depth;
+    Start = FBenchmarkClock::now();
+    for (const FChunkOccupancyVolume& Volume : Volumes)
+    {
+        Depth.Calculate(Volume);
+    }
+    const double DepthSeconds = std::chrono::duration<double>(FBenchmarkClock::now() - Start).count();
+    printf("Occupancy pyramid                  %.2lf us/chunk (%zu B) vs %.2lf us/chunk interior depth, mean empty level %.2lf, %u mismatched\n",
+        PyramidSeconds * 1e6 / Volumes.size(), sizeof(FChunkOccupancyPyramid), DepthSeconds * 1e6 / Volumes.size(),
+        (double)EmptyLevelSum / (Volumes.size() * (size_t)FChunkOccupancyVolume::VoxelNum), Mismatch);
+    return Mismatch;
+}
+
+//Distinct 64 B cache lines the 26 neighbourhood of a voxel touches, every voxel of a chunk, payload of BitsPerVoxel
+template<typename FGetIndex>
+static double GetMeanNeighbourhoodLines(FGetIndex GetIndex, uint32_t BitsPerVoxel)
+{
+    size_t LineSum = 0;
+    for (uint32_t i = 0; i < FChunkOccupancyVolume::VoxelNum; i++)
+    {
+        const ivec3 Voxel = FChunkOccupancyVolume::GetLocation(i);
+        std::array<uint32_t, 27> Lines;
+        uint32_t LineNum = 0;
+        for (int32_t n = 0; n < 27; n++)
+        {
+            const ivec3 Neighbour = Voxel + ivec3{ n % 3 - 1, (n / 3) % 3 - 1, n / 9 - 1 };
+            if (FChunkOccupancyVolume::bIsOutOfBound(Neighbour))
+            {
+                continue;
+            }
+            const uint32_t Line = GetIndex(Neighbour) * BitsPerVoxel / 512;
+            if (std::find(Lines.begin(), Lines.begin() + LineNum, Line) == Lines.begin() + LineNum)
+            {
+                Lines[LineNum++] = Line;
+            }
+        }
+        LineSum += LineNum;
+    }
+    return (double)LineSum / FChunkOccupancyVolume::VoxelNum;
+}
+
+//Morton encode/decode, linear <-> Z-order round trips, Z-order pyramid and block list against the linear ones, and the cache line model of both layouts
+static uint32_t RunMortonLayout(const FVoxelSceneConfig& VoxelSceneConfig)
+{
+    uint32_t Mismatch = 0;
+    for (uint32_t Index = 0; Index < (1u << 30); Index += 997u)
+    {
+        const ivec3 Location = FVoxelMathHelper::MortonDecode3D(Index);
+        Mismatch += FVoxelMathHelper::MortonEncode3D(Location) != Index ? 1 : 0;
+        Mismatch += (FVoxelMathHelper::SpreadBits3(Location.x) | (FVoxelMathHelper::SpreadBits3(Location.y) << 1) | (FVoxelMathHelper::SpreadBits3(Location.z) << 2)) != Index ? 1 : 0;
+    }
+    std::vector<FChunk> Chunks;
+    for (const ivec3& Location : GetBenchmarkChunkLocations(2))
+    {
+        FChunk& Chunk = Chunks.emplace_back();
+        FGeneratorHelper::TestGeneratorOccupancy<>(Chunk.InitializeOccupancy(), Location, VoxelSceneConfig.BlockSize, VoxelSceneConfig.ChunkResolution, 0);
+        Chunk.CalculateInteriorDepthFromOccupancy();
+    }
+    std::vector<FChunkMortonOccupancyVolume> MortonVolumes(Chunks.size());
+    for (size_t i = 0; i < Chunks.size(); i++)
+    {
+        const FChunk& Chunk = Chunks[i];
+        MortonVolumes[i].FromLinear(Chunk.Occupancy);
+        FChunkOccupancyVolume Linear;
+        MortonVolumes[i].ToLinear(Linear);
+        Mismatch += Linear == Chunk.Occupancy ? 0 : 1;
+        FChunkOccupancyPyramid Pyramid;
+        Pyramid.Calculate(MortonVolumes[i]);
+        Mismatch += Pyramid == Chunk.OccupancyPyramid ? 0 : 1;
+        for (uint32_t v = 0; v < FChunkOccupancyVolume::VoxelNum; v += 7)
+        {
+            const ivec3 Voxel = FChunkOccupancyVolume::GetLocation(v);
+            Mismatch += MortonVolumes[i].bIsBrickEmpty(Voxel) != !Chunk.OccupancyPyramid.bAny(2, Voxel >> 2) ? 1 : 0;
+        }
+        FChunk Linear_ = Chunk, Morton_ = Chunk;
+        Linear_.GatherSurfaceBlocks(1, false);
+        Morton_.GatherSurfaceBlocks(1, true);
+        auto GetKeys = [](const FChunk& Gathered, bool bMortonKey)
+            {
+                std::vector<uint32_t> Keys;
+                for (const FBlock& Block : Gathered.Blocks)
+                {
+                    const ivec3 Location = ivec3(Block.BlockLocation);
+                    Keys.push_back(bMortonKey ? FVoxelMathHelper::MortonEncode3D(Location) : FChunkOccupancyVolume::GetIndex(Location));
+                }
+                return Keys;
+            };
+        std::vector<uint32_t> MortonKeys = GetKeys(Morton_, true);
+        std::vector<uint32_t> SortedKeys = GetKeys(Linear_, true);
+        std::sort(SortedKeys.begin(), SortedKeys.end());
+        Mismatch += MortonKeys == SortedKeys ? 0 : 1;
+    }
+    FChunkOccupancyPyramid Pyramid;
+    auto Start = FBenchmarkClock::now();
+    for (const FChunk& Chunk : Chunks)
+    {
+        Pyramid.Calculate(Chunk.Occupancy);
+    }
+    const double LinearSeconds = std::chrono::duration<double>(FBenchmarkClock::now() - Start).count();
+    Start = FBenchmarkClock::now();
+    for (const FChunkMortonOccupancyVolume& Volume : MortonVolumes)
+    {
+        Pyramid.Calculate(Volume);
+    }
+    const double MortonSeconds = std::chrono::duration<double>(FBenchmarkClock::now() - Start).count();
+    auto LinearIndex = [](ivec3 Location) { return FChunkOccupancyVolume::GetIndex(Location); };
+    auto MortonIndex = [](ivec3 Location) { return FChunkMortonOccupancyVolume::GetIndex(Location); };
+    printf("Morton layout                      26-neighbourhood lines %.2lf vs %.2lf linear (1 B/voxel), %.2lf vs %.2lf (1 bit/voxel), pyramid %.2lf vs %.2lf us/chunk linear, %u mismatched\n",
+        GetMeanNeighbourhoodLines(MortonIndex, 8), GetMeanNeighbourhoodLines(LinearIndex, 8), GetMeanNeighbourhoodLines(MortonIndex, 1), GetMeanNeighbourhoodLines(LinearIndex, 1),
+        MortonSeconds * 1e6 / Chunks.size(), LinearSeconds * 1e6 / Chunks.size(), Mismatch);
+    return Mismatch;
+}
+
+//Occupancy path chunks on a grid, with world space voxel lookups across the chunk faces for the brute-force references
+struct FChunkGrid
+{
+    std::map<ivec3, FChunk, FIVec3Comparator> Chunks;
+
+    //No generator means solid chunks
+    FChunkGrid(FOccupancyGeneratorFunction OccupancyGenerator, const std::vector<ivec3>& Locations, const FVoxelSceneConfig& VoxelSceneConfig)
+    {
+        for (const ivec3& Location : Locations)
+        {
+            FChunk& Chunk = Chunks[Location];
+            Chunk.ChunkLocation = Location;
+            if (OccupancyGenerator)
+            {
+                OccupancyGenerator(Chunk.InitializeOccupancy(), Location, VoxelSceneConfig.BlockSize, VoxelSceneConfig.ChunkResolution, 0);
+            }
+            else
+            {
+                Chunk.InitializeOccupancy().Fill();
+            }
+            Chunk.CalculateInteriorDepthFromOccupancy();
+            Chunk.GatherSurfaceBlocks();
+        }
+    }
+    bool bIsSolid(ivec3 ChunkLocation, ivec3 Voxel) const
+    {
+        constexpr int32_t Resolution = (int32_t)kChunkResolution;
+        for (uint32_t Axis = 0; Axis < 3; Axis++)
+        {
+            const int32_t Carry = Voxel[Axis] < 0 ? -1 : (Voxel[Axis] >= Resolution ? 1 : 0);
+            ChunkLocation[Axis] += Carry;
+            Voxel[Axis] -= Carry * Resolution;
+        }
+        auto Found = Chunks.find(ChunkLocation);
+        return Found != Chunks.end() && Found->second.Occupancy.Get(Voxel);
+    }
+    FChunkNeighbourSlices GetNeighbourSlices(ivec3 Location) const
+    {
+        FChunkNeighbourSlices NeighbourSlices;
+        for (uint32_t Face = 0; Face < ChunkFaceNum; Face++)
+        {
+            ivec3 NeighbourLocation = Location;
+            NeighbourLocation[Face >> 1] += (Face & 1) ? 1 : -1;
+            auto Found = Chunks.find(NeighbourLocation);
+            NeighbourSlices[Face] = Found == Chunks.end() ? nullptr : &Found->second.BorderSlices[Face ^ 1];
+        }
+        return NeighbourSlices;
+    }
+    //Brute-force face mask, one world space lookup per face
+    uint8_t GetReferenceFaceMask(ivec3 Location, u8vec3 BlockLocation) const
+    {
+        uint8_t FaceMask = 0;
+        for (uint32_t Face = 0; Face < ChunkFaceNum; Face++)
+        {
+            ivec3 Voxel = ivec3(BlockLocation);
+            Voxel[Face >> 1] += (Face & 1) ? 1 : -1;
+            FaceMask |= bIsSolid(Location, Voxel) ? 0 : (uint8_t)(1u << Face);
+        }
+        return FaceMask;
+    }
+};
+
+//Border cull with the neighbour slices against the world space 6 neighbour test over the whole grid
+static uint32_t RunBorderCull(const char* Name, FOccupancyGeneratorFunction OccupancyGenerator, const std::vector<ivec3>& Locations, const FVoxelSceneConfig& VoxelSceneConfig)
+{
+    const FChunkGrid Grid(OccupancyGenerator, Locations, VoxelSceneConfig);
+    uint32_t Mismatch = 0;
+    size_t BorderNum = 0;
+    size_t CulledNum = 0;
+    for (const auto& [Location, Chunk] : Grid.Chunks)
+    {
+        const FChunkNeighbourSlices NeighbourSlices = Grid.GetNeighbourSlices(Location);
+        for (const FBlock& Block : Chunk.Blocks)
+        {
+            if (!FChunk::bIsBorderVoxel(Block.BlockLocation))
+            {
+                continue;
+            }
+            const bool bCull = Chunk.bShouldBorderVoxelCull(Block.BlockLocation, NeighbourSlices);
+            BorderNum++;
+            CulledNum += bCull ? 1 : 0;
+            Mismatch += bCull != (Grid.GetReferenceFaceMask(Location, Block.BlockLocation) == 0) ? 1 : 0;
+        }
+    }
+    printf("%-34s %zu of %zu border blocks hidden by resident neighbours, %u mismatched\n", Name, CulledNum, BorderNum, Mismatch);
+    return Mismatch;
+}
+
+//Row kernel face masks of every gathered block against the world space lookups, plus how many faces the impostors could skip
+static uint32_t RunFaceMasks(const char* Name, FOccupancyGeneratorFunction OccupancyGenerator, const std::vector<ivec3>& Locations, const FVoxelSceneConfig& VoxelSceneConfig)
+{
+    const FChunkGrid Grid(OccupancyGenerator, Locations, VoxelSceneConfig);
+    uint32_t Mismatch = 0;
+    size_t BlockNum = 0;
+    size_t EnclosedNum = 0;
+    size_t ExposedFaceNum = 0;
+    double MaskSeconds = 0.0;
+    std::vector<uint8_t> FaceMasks;
+    for (const auto& [Location, Chunk] : Grid.Chunks)
+    {
+        const FChunkNeighbourSlices NeighbourSlices = Grid.GetNeighbourSlices(Location);
+        const auto Start = FBenchmarkClock::now();
+        Chunk.CalculateFaceMasks(NeighbourSlices, FaceMasks);
+        MaskSeconds += std::chrono::duration<double>(FBenchmarkClock::now() - Start).count();
+        for (size_t i = 0; i < Chunk.Blocks.size(); i++)
+        {
+            const u8vec3 BlockLocation = Chunk.Blocks[i].BlockLocation;
+            Mismatch += FaceMasks[i] != Grid.GetReferenceFaceMask(Location, BlockLocation) ? 1 : 0;
+            Mismatch += FaceMasks[i] != Chunk.GetFaceMask(BlockLocation, NeighbourSlices) ? 1 : 0;
+            EnclosedNum += FaceMasks[i] == 0 ? 1 : 0;
+            ExposedFaceNum += std::popcount(FaceMasks[i]);
+        }
+        BlockNum += Chunk.Blocks.size();
+    }
+    BlockNum = std::max<size_t>(BlockNum, 1);
+    printf("%-34s %.2lf us/chunk, %.2lf exposed faces/block, %.1lf%% of %zu gathered blocks enclosed, %u mismatched\n", Name,
+        MaskSeconds * 1e6 / std::max<size_t>(Grid.Chunks.size(), 1), (double)ExposedFaceNum / BlockNum, EnclosedNum * 100.0 / BlockNum, BlockNum, Mismatch);
+    return Mismatch;
+}
+
+template<ENoiseHashMode HashMode>
+static double MaxDisplacementLaneError(uint32_t SampleNum)
+{
+    double MaxError = 0.0;
+    TVec3Lanes<double> Samples;
+    alignas(64) double Displacement[kSimdLaneNum];
+    for (uint32_t s = 0; s < SampleNum; s += kSimdLaneNum)
+    {
+        for (uint32_t i = 0; i < kSimdLaneNum; i++)
+        {
+            Samples.X[i] = (s + i) * 0.0731 - 40.0;
+            Samples.Y[i] = (s + i) * 0.0173 - 9.0;
+            Samples.Z[i] = (s + i) * 0.1129 + 3.0;
+        }
+        FGeneratorHelper::displacementLanes<double, kSimdLaneNum, HashMode>(Samples, Displacement);
+        for (uint32_t i = 0; i < kSimdLaneNum; i++)
+        {
+            const double Reference = FGeneratorHelper::displacement<double, HashMode>(dvec3{ Samples.X[i], Samples.Y[i], Samples.Z[i] });
+            MaxError = std::max(MaxError, std::abs(Reference - Displacement[i]));
+        }
+    }
+    return MaxError;
+}
+
+//Every optimized path against its reference, plus the classifier/Lipschitz/LOD/float reports
+static uint32_t RunVerification(int32_t HalfExtent, const FVoxelSceneConfig& VoxelSceneConfig)
+{
+    const std::vector<ivec3> Locations = GetBenchmarkChunkLocations(HalfExtent);
+    printf("Verification: %zu chunks of %d^3, %u simd lanes\n", Locations.size(), VoxelSceneConfig.ChunkResolution, kSimdLaneNum);
+
+    FGeneratorBenchmarkResult ScalarSine = RunGenerator(&FGeneratorHelper::TestGenerator<ENoiseHashMode::Sine>, Locations, VoxelSceneConfig);
+    PrintResult("TestGenerator (sine hash)", ScalarSine, Locations.size(), VoxelSceneConfig.ChunkResolution);
+
+    FGeneratorBenchmarkResult BatchedSine = RunGenerator(&FGeneratorHelper::TestGeneratorBatched<kSimdLaneNum, ENoiseHashMode::Sine>, Locations, VoxelSceneConfig);
+    PrintResult("TestGeneratorBatched (sine)", BatchedSine, Locations.size(), VoxelSceneConfig.ChunkResolution);
+
+    FGeneratorBenchmarkResult Scalar = RunGenerator(&FGeneratorHelper::TestGenerator<>, Locations, VoxelSceneConfig);
+    PrintResult("TestGenerator", Scalar, Locations.size(), VoxelSceneConfig.ChunkResolution);
+
+    FGeneratorBenchmarkResult Batched = RunGenerator(&FGeneratorHelper::TestGeneratorBatched<>, Locations, VoxelSceneConfig);
+    PrintResult("TestGeneratorBatched", Batched, Locations.size(), VoxelSceneConfig.ChunkResolution);
+
+    FGeneratorBenchmarkResult ScalarCached = RunGenerator(&FGeneratorHelper::TestGenerator<FGeneratorHelper::GeneratorHashMode, true>, Locations, VoxelSceneConfig);
+    PrintResult("TestGenerator (lattice)", ScalarCached, Locations.size(), VoxelSceneConfig.ChunkResolution);
+
+    FGeneratorBenchmarkResult BatchedUncached = RunGenerator(&FGeneratorHelper::TestGeneratorBatched<kSimdLaneNum, FGeneratorHelper::GeneratorHashMode, false>, Locations, VoxelSceneConfig);
+    PrintResult("TestGeneratorBatched (no lattice)", BatchedUncached, Locations.size(), VoxelSceneConfig.ChunkResolution);
+
+    uint32_t Mismatch = CountMismatchedChunks(ScalarSine, BatchedSine) + CountMismatchedChunks(Scalar, Batched)
+        + CountMismatchedChunks(Scalar, ScalarCached) + CountMismatchedChunks(Scalar, BatchedUncached);
+
+    FGeneratorBenchmarkResult Graph = RunGenerator(&GraphTestGenerator, Locations, VoxelSceneConfig);
+    PrintResult("Graph TestGenerator", Graph, Locations.size(), VoxelSceneConfig.ChunkResolution);
+    Mismatch += CountMismatchedChunks(Scalar, Graph);
+
+    //Taller column, mostly sky and ground
+    const std::vector<ivec3> ColumnLocations = GetBenchmarkChunkLocations(HalfExtent / 2 + 1, 6);
+
+    FGeneratorBenchmarkResult FbmTerrain = RunGenerator(&FGeneratorHelper::GenerateFbmTerrain<>, ColumnLocations, VoxelSceneConfig);
+    PrintResult("GenerateFbmTerrain", FbmTerrain, ColumnLocations.size(), VoxelSceneConfig.ChunkResolution);
+    FGeneratorBenchmarkResult GraphFbm = RunGenerator(&GraphFbmTerrain, ColumnLocations, VoxelSceneConfig);
+    PrintResult("Graph fbm terrain", GraphFbm, ColumnLocations.size(), VoxelSceneConfig.ChunkResolution);
+    Mismatch += CountMismatchedChunks(FbmTerrain, GraphFbm);
+
+    Mismatch += RunClassifier("ClassifyTestGenerator", &FGeneratorHelper::ClassifyTestGenerator, &FGeneratorHelper::TestGeneratorBatched<>, ColumnLocations, VoxelSceneConfig);
+    Mismatch += RunClassifier("ClassifySphere", &FGeneratorHelper::ClassifySphere, &FGeneratorHelper::GenerateSphere, GetBenchmarkChunkLocations(8, 4), VoxelSceneConfig);
+    Mismatch += RunClassifier("ClassifyFbmTerrain", &FGeneratorHelper::ClassifyFbmTerrain, &FGeneratorHelper::GenerateFbmTerrain<>, ColumnLocations, VoxelSceneConfig);
+
+    Mismatch += RunLipschitz("GenerateLipschitz (sphere)", &FGeneratorHelper::SphereSdf, 1.0, &FGeneratorHelper::GenerateSphere, &FGeneratorHelper::ClassifySphere, GetBenchmarkChunkLocations(8, 4), VoxelSceneConfig);
+    Mismatch += RunLipschitz("GenerateLipschitz (fbm terrain)", &FGeneratorHelper::FbmTerrainSdf<>, FGeneratorHelper::GetFbmTerrainLipschitz(), &FGeneratorHelper::GenerateFbmTerrain<>, &FGeneratorHelper::ClassifyFbmTerrain, ColumnLocations, VoxelSceneConfig);
+    Mismatch += RunOccupancy("TestGeneratorOccupancy", &FGeneratorHelper::TestGeneratorBatched<>, &FGeneratorHelper::TestGeneratorOccupancy<>, Locations, VoxelSceneConfig);
+    Mismatch += RunOccupancy("GenerateFbmTerrainOccupancy", &FGeneratorHelper::GenerateFbmTerrainLipschitz<>, &FGeneratorHelper::GenerateFbmTerrainOccupancy<>, ColumnLocations, VoxelSceneConfig);
+    Mismatch += RunFloatAccuracy(Locations, VoxelSceneConfig);
+    Mismatch += RunErosion(VoxelSceneConfig);
+    Mismatch += RunInteriorDepth(VoxelSceneConfig);
+    Mismatch += RunOccupancyPyramid(VoxelSceneConfig);
+    Mismatch += RunMortonLayout(VoxelSceneConfig);
+    Mismatch += RunBorderCull("Border cull (solid)", nullptr, GetBenchmarkChunkLocations(2), VoxelSceneConfig);
+    Mismatch += RunBorderCull("Border cull (fbm terrain)", &FGeneratorHelper::GenerateFbmTerrainOccupancy<>, ColumnLocations, VoxelSceneConfig);
+    Mismatch += RunFaceMasks("Face masks (test generator)", &FGeneratorHelper::TestGeneratorOccupancy<>, Locations, VoxelSceneConfig);
+    Mismatch += RunFaceMasks("Face masks (fbm terrain)", &FGeneratorHelper::GenerateFbmTerrainOccupancy<>, ColumnLocations, VoxelSceneConfig);
+    FVoxelSceneConfig LodSceneConfig = VoxelSceneConfig;
+    LodSceneConfig.ViewForwardLoadChunkSize = 8 + 4 * (uint32_t)HalfExtent;
+    RunLod(&FGeneratorHelper::GenerateFbmTerrainLipschitz<>, &FGeneratorHelper::ClassifyFbmTerrain, LodSceneConfig);
+
+    printf("Mismatched chunks: %u, max displacement lane error: %g (sine), %g (integer)\n", Mismatch,
+        MaxDisplacementLaneError<ENoiseHashMode::Sine>(1u << 16), MaxDisplacementLaneError<ENoiseHashMode::Integer>(1u << 16));
+    return Mismatch;
+}
+
+struct FRegisteredGenerator
+{
+    const char* Name;//Also the golden file name
+    FGeneratorFunction Generator;
+};
+
+//Add a line here to benchmark and golden-check another generator
+static const std::vector<FRegisteredGenerator>& GetRegisteredGenerators()
+{
+    static const std::vector<FRegisteredGenerator> Generators =
+    {
+        { "TestGenerator", &FGeneratorHelper::TestGeneratorBatched<> },
+        { "TestGeneratorFloat", &FGeneratorHelper::TestGeneratorBatched<kSimdLaneNum * 2, ENoiseHashMode::Integer, true, float> },
+        { "GenerateSphere", &FGeneratorHelper::GenerateSphereLipschitz },
+        { "GenerateFbmTerrain", &FGeneratorHelper::GenerateFbmTerrainLipschitz<> },
+        { "GraphFbmTerrain", &GraphFbmTerrain },
+    };
+    return Generators;
+}
+
+//Locations are split over ThreadNum std::threads through an atomic cursor, like the generator thread pool does with tasks
+static void RunThroughput(const FRegisteredGenerator& Entry, const std::vector<ivec3>& Locations, uint32_t ThreadNum, const FVoxelSceneConfig& VoxelSceneConfig)
+{
+    const uint64_t ChunkVoxelNum = (uint64_t)VoxelSceneConfig.ChunkResolution * VoxelSceneConfig.ChunkResolution * VoxelSceneConfig.ChunkResolution;
+    std::atomic<size_t> Cursor = 0;
+    std::atomic<uint32_t> RegionCount[3] = { 0, 0, 0 };
+    auto Worker = [&]()
+        {
+            for (size_t i = Cursor++; i < Locations.size(); i = Cursor++)
+            {
+                const size_t BlockNum = Entry.Generator(Locations[i], VoxelSceneConfig.BlockSize, VoxelSceneConfig.ChunkResolution, 0).Blocks.size();
+                const EGeneratorRegion Region = BlockNum == 0 ? EGeneratorRegion::Empty : (BlockNum == ChunkVoxelNum ? EGeneratorRegion::Solid : EGeneratorRegion::Mixed);
+                RegionCount[(uint32_t)Region]++;
+            }
+        };
+    auto Start = FBenchmarkClock::now();
+    std::vector<std::thread> Threads;
+    for (uint32_t t = 1; t < ThreadNum; t++)
+    {
+        Threads.emplace_back(Worker);
+    }
+    Worker();
+    for (std::thread& Thread : Threads)
+    {
+        Thread.join();
+    }
+    const double Seconds = std::max(std::chrono::duration<double>(FBenchmarkClock::now() - Start).count(), 1e-9);
+    const double ChunkNum = (double)std::max<size_t>(Locations.size(), 1);
+    printf("%-22s %2u threads %10.1lf chunks/s %8.2lf Mvoxels/s, %5.1lf%% empty %5.1lf%% solid %5.1lf%% mixed\n", Entry.Name, ThreadNum,
+        ChunkNum / Seconds, ChunkNum * ChunkVoxelNum / Seconds * 1e-6,
+        RegionCount[0] * 100.0 / ChunkNum, RegionCount[1] * 100.0 / ChunkNum, RegionCount[2] * 100.0 / ChunkNum);
+}
+
+//FNV-1a over the indices of the solid voxels, independent of block order and of the bitset word size
+static uint64_t HashChunkOccupancy(const FChunk& Chunk)
+{
+    FChunkOccupancyVolume Occupancy;
+    for (const FBlock& Block : Chunk.Blocks)
+    {
+        Occupancy.Set(true, ivec3(Block.BlockLocation));
+    }
+    uint64_t Hash = 14695981039346656037ull;
+    Occupancy.ForEachSet([&Hash](uint32_t i)
+        {
+            for (uint32_t Byte = 0; Byte < 4; Byte++)
+            {
+                Hash = (Hash ^ ((i >> (Byte * 8)) & 0xffu)) * 1099511628211ull;
+            }
+        });
+    return Hash;
+}
+
+//Fixed chunk set so golden files don't depend on the benchmark options, covers the sphere at x = 100 and the terrain surfaces
+static std::vector<ivec3> GetGoldenChunkLocations()
+{
+    std::vector<ivec3> Locations;
+    for (int32_t X = -4; X < 12; X++)
+    {
+        for (int32_t Y = -3; Y < 3; Y++)
+        {
+            for (int32_t Z = -4; Z < 4; Z++)
+            {
+                Locations.push_back({ X, Y, Z });
+            }
+        }
+    }
+    return Locations;
+}
+
+//One "x y z block_count hash" line per chunk. Returns the mismatched chunks (missing file counts as one)
+static uint32_t RunGolden(const FRegisteredGenerator& Entry, const std::string& GoldenDirectory, bool bUpdate, const FVoxelSceneConfig& VoxelSceneConfig)
+{
+    //Goldens are per chunk resolution, the default 16 keeps the plain name
+    const std::string Suffix = kChunkResolution == 16 ? "" : "_" + std::to_string(kChunkResolution);
+    const std::string Path = GoldenDirectory + "/" + Entry.Name + Suffix + ".txt";
+    std::vector<std::string> Lines;
+    for (const ivec3& Location : GetGoldenChunkLocations())
+    {
+        const FChunk Chunk = Entry.Generator(Location, VoxelSceneConfig.BlockSize, VoxelSceneConfig.ChunkResolution, 0);
+        char Line[128];
+        snprintf(Line, sizeof(Line), "%d %d %d %zu %016llx", Location.x, Location.y, Location.z, Chunk.Blocks.size(), (unsigned long long)HashChunkOccupancy(Chunk));
+        Lines.push_back(Line);
+    }
+    if (bUpdate)
+    {
+        std::filesystem::create_directories(GoldenDirectory);
+        std::ofstream File(Path);
+        File << "# MesoGenBench golden output of " << Entry.Name << ", chunk x y z, block count, FNV-1a of the solid voxel indices\n";
+        for (const std::string& Line : Lines)
+        {
+            File << Line << "\n";
+        }
+        printf("%-22s golden written to %s\n", Entry.Name, Path.c_str());
+        return File.good() ? 0 : 1;
+    }
+    std::ifstream File(Path);
+    if (!File)
+    {
+        printf("%-22s golden missing (%s), run with --update-golden\n", Entry.Name, Path.c_str());
+        return 1;
+    }
+    std::vector<std::string> GoldenLines;
+    for (std::string Line; std::getline(File, Line);)
+    {
+        if (!Line.empty() && Line[0] != '#')
+        {
+            GoldenLines.push_back(Line);
+        }
+    }
+    uint32_t Mismatch = GoldenLines.size() == Lines.size() ? 0 : 1;
+    for (size_t i = 0; i < std::min(Lines.size(), GoldenLines.size()); i++)
+    {
+        if (Lines[i] != GoldenLines[i])
+        {
+            if (Mismatch < 4)
+            {
+                printf("  %s: got \"%s\", golden \"%s\"\n", Entry.Name, Lines[i].c_str(), GoldenLines[i].c_str());
+            }
+            Mismatch++;
+        }
+    }
+    printf("%-22s golden %zu chunks, %u mismatched\n", Entry.Name, Lines.size(), Mismatch);
+    return Mismatch;
+}
+
+#ifndef MESO_GOLDEN_DIR
+#define MESO_GOLDEN_DIR "Golden"
+#endif
+
+/*
+MesoGenBench [options]
+    --extent N          benchmark chunks in [-N, N) on x/z (default 4)
+    --height N          benchmark chunks in [-N, N) on y (default 2)
+    --threads 1,4,8     thread counts of the throughput runs (default 1 and all cores)
+    --generator Name    only this registered generator (repeatable)
+    --golden-dir Path   golden files directory (default set by cmake)
+    --update-golden     rewrite the golden files instead of checking them
+    --no-verify         skip the optimized vs reference verification suite
+The chunk pool and the spatial queries have their own benches, MesoPoolBench and MesoSpatialBench.
+Exit code is non zero on any mismatch
+*/
+int main(int argc, char* argv[])
+{
+    FVoxelSceneConfig VoxelSceneConfig;
+    FBenchOptions Options;
+    std::vector<std::string> GeneratorNames;
+    std::string GoldenDirectory = MESO_GOLDEN_DIR;
+    bool bUpdateGolden = false;
+    bool bVerify = true;
+    for (int i = 1; i < argc; i++)
+    {
+        if (ParseBenchOption(argc, argv, i, Options))
+        {
+            continue;
+        }
+        const std::string Arg = argv[i];
+        const bool bHasValue = i + 1 < argc;
+        if (Arg == "--generator" && bHasValue)
+        {
+            GeneratorNames.push_back(argv[++i]);
+        }
+        else if (Arg == "--golden-dir" && bHasValue)
+        {
+            GoldenDirectory = argv[++i];
+        }
+        else if (Arg == "--update-golden")
+        {
+            bUpdateGolden = true;
+        }
+        else if (Arg == "--no-verify")
+        {
+            bVerify = false;
+        }
+        else
+        {
+            printf("Unknown option %s\n", Arg.c_str());
+            return 2;
+        }
+    }
+    FinishBenchOptions(Options);
+    std::vector<FRegisteredGenerator> Generators;
+    for (const FRegisteredGenerator& Entry : GetRegisteredGenerators())
+    {
+        if (GeneratorNames.empty() || std::find(GeneratorNames.begin(), GeneratorNames.end(), Entry.Name) != GeneratorNames.end())
+        {
+            Generators.push_back(Entry);
+        }
+    }
+
+    uint32_t Mismatch = 0;
+    if (bVerify)
+    {
+        Mismatch += RunVerification(Options.HalfExtent, VoxelSceneConfig);
+    }
+    const std::vector<ivec3> Locations = GetBenchmarkChunkLocations(Options.HalfExtent, Options.HalfHeight);
+    printf("Throughput: %zu chunks of %d^3\n", Locations.size(), VoxelSceneConfig.ChunkResolution);
+    for (const FRegisteredGenerator& Entry : Generators)
+    {
+        for (uint32_t ThreadNum : Options.ThreadNums)
+        {
+            RunThroughput(Entry, Locations, ThreadNum, VoxelSceneConfig);
+        }
+    }
+    uint32_t GoldenMismatch = 0;
+    for (const FRegisteredGenerator& Entry : Generators)
+    {
+        GoldenMismatch += RunGolden(Entry, GoldenDirectory, bUpdateGolden, VoxelSceneConfig);
+    }
+    printf("Mismatched: %u verification, %u golden\n", Mismatch, GoldenMismatch);
+    return Mismatch + GoldenMismatch == 0 ? 0 : 1;
+}
@@ -0,0 +1,861 @@
+#include "MesoBenchCommon.h"
+#include "Voxel/Chunk/ChunkPool.h"
+
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <map>
+#include <set>
+
+//Heap allocations of the calling thread, counted in MesoPoolBenchAllocation.cpp
+extern thread_local uint64_t ThreadAllocationNum;
+
+//Eviction index on full pools of SimpleVoxel's size (4 generator threads), a few pushes a frame while the camera turns every frame. It crosses a 16m chunk
+//every 96 frames at the camera's 10m/s and every 10 at its fast 100m/s, at 60 fps. The victim must match a full scan for the true minimum,
+//unless the floors were left behind by the fast camera. The old best of 128 ring probe is timed and scored alongside
+static uint32_t RunEvictionIndex()
+{
+    constexpr uint32_t FrameNum = 192;
+    constexpr uint32_t ProbeNum = 128;
+    uint32_t Mismatch = 0;
+    for (const uint32_t SlotNum : { 16384u / 4u, 32768u / 4u })
+    {
+        for (const uint32_t MoveFrameNum : { 96u, 10u })
+        for (const uint32_t PushPerFrame : { 1u, 2u, 4u, 8u })
+        {
+            uint32_t Seed = 0x9E3779B9u;
+            auto Random = [&Seed]() { Seed = Seed * 1664525u + 1013904223u; return (Seed >> 8) * (1.0 / 16777216.0); };
+            FImportanceComputeInfo CameraInfo = { .CameraChunk = { 0, 0, 0 }, .CameraForwardVector = { 1.0f, 0.0f, 0.0f }, .MaxChunkMipmapLevel = 2 };
+            auto GetRandomChunk = [&](uint32_t Frame)
+                {
+                    FEmptyChunk NewChunk;
+                    const ivec3 Location = CameraInfo.CameraChunk + ivec3{ (int32_t)(Random() * 80.0) - 40, (int32_t)(Random() * 8.0) - 4, (int32_t)(Random() * 80.0) - 40 };
+                    NewChunk.MipmapLevel = CameraInfo.CalculateChunkMipmapLevel(Location);
+                    NewChunk.ChunkLocation = FImportanceComputeInfo::AlignChunkLocation(Location, NewChunk.MipmapLevel);
+                    NewChunk.ChunkFrameStamp = Frame;
+                    return NewChunk;
+                };
+
+            std::vector<FEmptyChunk> Slots(SlotNum);
+            FChunkEvictionIndex EvictionIndex;
+            EvictionIndex.Initialize(SlotNum);
+            for (uint32_t Slot = 0; Slot < SlotNum; Slot++)
+            {
+                Slots[Slot] = GetRandomChunk(0);
+                EvictionIndex.Heap.Set(Slot, EvictionIndex.GetKey(Slots[Slot]));
+            }
+            EvictionIndex.FilledNum = SlotNum;
+
+            uint32_t ProbeCursor = 0;
+            size_t EvictionNum = 0;
+            double IndexSeconds = 0.0, ProbeSeconds = 0.0;
+            double IndexImportance = 0.0, ProbeImportance = 0.0, TrueImportance = 0.0;
+            uint32_t ConfigMismatch = 0;
+            uint32_t StalePushNum = 0;
+            for (uint32_t Frame = 1; Frame <= FrameNum; Frame++)
+            {
+                const float Angle = Frame * 0.05f;
+                CameraInfo.CameraChunk.x += Frame % MoveFrameNum == 0 ? 1 : 0;
+                CameraInfo.CameraForwardVector = { std::cos(Angle), 0.0f, std::sin(Angle) };
+                for (uint32_t Push = 0; Push < PushPerFrame; Push++)
+                {
+                    const FEmptyChunk NewChunk = GetRandomChunk(Frame);
+                    const float NewImportance = CameraInfo.CalculateChunkImportance(NewChunk.ChunkLocation, NewChunk.MipmapLevel);
+
+                    auto Start = FBenchmarkClock::now();
+                            auto [Victim, VictimImportance] = EvictionIndex.FindVictim(Slots, CameraInfo, Frame);
+                    IndexSeconds += std::chrono::duration<double>(FBenchmarkClock::now() - Start).count();
+
+                    //Full scan for the true minimum, and the keys must still order the heap
+                    float TrueMin = INFINITY;
+                    float MinKey = INFINITY;
+                    for (const FEmptyChunk& Chunk : Slots)
+                    {
+                        if (Chunk.ChunkFrameStamp < Frame)
+                        {
+                            TrueMin = std::min(TrueMin, CameraInfo.CalculateChunkImportance(Chunk.ChunkLocation, Chunk.MipmapLevel));
+                        }
+                        MinKey = std::min(MinKey, EvictionIndex.GetKey(Chunk));
+                    }
+                    const bool bStale = EvictionIndex.KeyCameraInfo.CameraChunk != CameraInfo.CameraChunk;
+                    StalePushNum += bStale ? 1 : 0;
+                    ConfigMismatch += (bStale || VictimImportance == TrueMin) && MinKey == EvictionIndex.Heap.GetMinKey() && EvictionIndex.Heap.Size() == SlotNum ? 0 : 1;
+
+                    //The old ring probe, 128 importance evaluations
+                    Start = FBenchmarkClock::now();
+                    float ProbeMin = INFINITY;
+                    for (uint32_t i = 0; i < ProbeNum; i++)
+                    {
+                        const FEmptyChunk& Chunk = Slots[(ProbeCursor + i) % SlotNum];
+                        if (Chunk.ChunkFrameStamp < Frame)
+                        {
+                            ProbeMin = std::min(ProbeMin, CameraInfo.CalculateChunkImportance(Chunk.ChunkLocation, Chunk.MipmapLevel));
+                        }
+                    }
+                    ProbeCursor = (ProbeCursor + ProbeNum) % SlotNum;
+                    ProbeSeconds += std::chrono::duration<double>(FBenchmarkClock::now() - Start).count();
+
+                    if (Victim != INT_MAX && VictimImportance < NewImportance)
+                    {
+                        EvictionNum++;
+                        IndexImportance += VictimImportance;
+                        ProbeImportance += std::min(ProbeMin, NewImportance);
+                        TrueImportance += TrueMin;
+                        Slots[Victim] = NewChunk;
+                        EvictionIndex.Heap.Set(Victim, EvictionIndex.GetKey(Slots[Victim]));
+                    }
+                }
+            }
+            const double PushNum = (double)FrameNum * PushPerFrame;
+            EvictionNum = std::max<size_t>(EvictionNum, 1);
+            printf("%-22s %5u slots %u push/frame, chunk every %2u frames %7.3lf us/push vs %.3lf us/push 128 probe, evicted importance %.2lf (true %.2lf) vs %.2lf (probe), %u pushes on older floors, %u mismatched\n", "Eviction index",
+                SlotNum, PushPerFrame, MoveFrameNum, IndexSeconds * 1e6 / PushNum, ProbeSeconds * 1e6 / PushNum, IndexImportance / EvictionNum, TrueImportance / EvictionNum, ProbeImportance / EvictionNum, StalePushNum, ConfigMismatch);
+            Mismatch += ConfigMismatch;
+        }
+    }
+    return Mismatch;
+}
+
+//Pages taken and given back by racing threads, a page must never have two owners
+static uint32_t RunPageAllocatorStress(uint32_t ThreadNum)
+{
+    constexpr uint32_t PageNum = 64;
+    constexpr uint32_t OperationNum = 100000;
+    FAtomicPageAllocator Allocator;
+    Allocator.Initialize(PageNum);
+    std::vector<std::atomic<uint32_t>> Owners(PageNum);
+    std::atomic<uint32_t> Mismatch = 0;
+    auto Worker = [&](uint32_t ThreadId)
+        {
+            uint32_t Seed = 0x9E3779B9u * (ThreadId + 1);
+            std::vector<uint32_t> Held;
+            for (uint32_t i = 0; i < OperationNum; i++)
+            {
+                Seed = Seed * 1664525u + 1013904223u;
+                if (Held.empty() || ((Seed >> 16) & 1))
+                {
+                    const uint32_t Page = Allocator.Allocate();
+                    if (Page != FAtomicPageAllocator::InvalidPage)
+                    {
+                        Mismatch += Owners[Page].exchange(ThreadId + 1) == 0 ? 0 : 1;
+                        Held.push_back(Page);
+                    }
+                }
+                else
+                {
+                    const uint32_t Page = Held[(Seed >> 8) % Held.size()];
+                    std::erase(Held, Page);
+                    Mismatch += Owners[Page].exchange(0) == ThreadId + 1 ? 0 : 1;
+                    Allocator.Free(Page);
+                }
+            }
+            for (const uint32_t Page : Held)
+            {
+                Owners[Page].store(0);
+                Allocator.Free(Page);
+            }
+        };
+    std::vector<std::thread> Threads;
+    for (uint32_t t = 0; t < ThreadNum; t++)
+    {
+        Threads.emplace_back(Worker, t);
+    }
+    for (std::thread& Thread : Threads)
+    {
+        Thread.join();
+    }
+    //Everything came back, exactly once
+    std::set<uint32_t> Pages;
+    for (uint32_t Page = Allocator.Allocate(); Page != FAtomicPageAllocator::InvalidPage; Page = Allocator.Allocate())
+    {
+        Pages.insert(Page);
+    }
+    return Mismatch.load() + (Pages.size() == PageNum ? 0 : 1) + (Allocator.GetFreeNum() == 0 ? 0 : 1);
+}
+
+/*
+Block slots of ThreadNum chunk pools under skewed load, thread 0 generates dense chunks and the others light ones, starting later.
+Shared pages against the old even split (one page pool per thread), the reading pools must end up showing the same block buffer as the writers.
+*/
+static uint32_t RunBlockPages()
+{
+    constexpr uint32_t ThreadNum = 4;
+    constexpr uint32_t PageSize = 256;
+    constexpr uint32_t MaxBlockCount = PageSize * 64;
+    constexpr uint32_t ChunkSlotNum = 64;
+    constexpr uint32_t FrameNum = 48;
+    constexpr uint32_t LightStartFrame = 16;//The dense thread has everything to itself until then
+    constexpr uint32_t DenseBlockNum = 600;
+    constexpr uint32_t LightBlockNum = 48;
+    const FImportanceComputeInfo CameraInfo = { .CameraForwardVector = { 1.0f, 0.0f, 0.0f } };
+    uint32_t Mismatch = 0;
+    uint32_t HandBackDropNum = 0;
+    //Blocks on the local pages [Begin, End) still drawn by their chunk
+    auto CountDrawnBlocks = [](const FTLSChunkPool& Pool, const uint32_t Begin, const uint32_t End)
+        {
+            uint32_t DrawnNum = 0;
+            for (uint32_t LocalPage = Begin; LocalPage < End; LocalPage++)
+            {
+                for (uint32_t Slot = LocalPage * Pool.BlockPageSize; Slot < (LocalPage + 1) * Pool.BlockPageSize && Pool.BlockPages[LocalPage] != INT_MAX; Slot++)
+                {
+                    const FGPUBlock& Block = Pool.GPUBlockPool[Slot];
+                    DrawnNum += Block.ChunkIndex != INT_MAX && Pool.GPUChunksPool[Block.ChunkIndex - Pool.ChunkCountOffset].ChunkFrameStamp == Block.BlockFrameStamp ? 1 : 0;
+                }
+            }
+            return DrawnNum;
+        };
+    auto Simulate = [&](bool bShared, double& Utilisation, uint32_t& LightDropNum)
+        {
+            std::vector<FBlockPagePool> PagePools(bShared ? 1 : ThreadNum);
+            for (FBlockPagePool& PagePool : PagePools)
+            {
+                PagePool.Initialize(bShared ? MaxBlockCount : MaxBlockCount / ThreadNum, PageSize, bShared ? ThreadNum : 1);
+            }
+            std::vector<FTLSChunkPool> Pools(ThreadNum), ReadPools(ThreadNum);
+            std::vector<FTLSChunkPool::FModifyBufferQueue> Queues(ThreadNum);
+            for (uint32_t t = 0; t < ThreadNum; t++)
+            {
+                Pools[t].Initialize(ChunkSlotNum, 1, PageSize, t * ChunkSlotNum, 0);
+                ReadPools[t].Initialize(ChunkSlotNum, 1, PageSize, t * ChunkSlotNum, 0);
+            }
+            uint32_t Stamp = 0;
+            LightDropNum = 0;
+            for (uint32_t Frame = 0; Frame < FrameNum; Frame++)
+            {
+                //Chunk slots are reused in a ring, a replaced chunk frees its blocks first
+                for (uint32_t t = 0; t < ThreadNum; t++)
+                {
+                    if (t > 0 && Frame < LightStartFrame)
+                    {
+                        continue;
+                    }
+                    FTLSChunkPool& Pool = Pools[t];
+                    FBlockPagePool& PagePool = PagePools[bShared ? 0 : t];
+                    for (uint32_t Push = 0; Push < 4; Push++)
+                    {
+                        const uint32_t ChunkIndex = (Frame * 4 + Push) % ChunkSlotNum;
+                        FTLSModifyBuffer ModifyBuffer = Queues[t].Acquire();
+                        Pool.FreeChunkBlocks(ChunkIndex, PagePool, ModifyBuffer);
+                        //A page is handed back empty, its drawn blocks only drop when our other pages have no room for them
+                        const FTLSChunkPool Before = Pool;
+                        Pool.RebalanceBlockPages(PagePool, ModifyBuffer, CameraInfo, 16);
+                        auto bReleased = [&](uint32_t LocalPage) { return Before.BlockPages[LocalPage] != INT_MAX && Pool.BlockPages[LocalPage] == INT_MAX; };
+                        uint32_t ReleasedDrawnNum = 0, FreeElsewhereNum = 0;
+                        for (uint32_t LocalPage = 0; LocalPage < Before.BlockPages.size(); LocalPage++)
+                        {
+                            ReleasedDrawnNum += bReleased(LocalPage) ? CountDrawnBlocks(Before, LocalPage, LocalPage + 1) : 0;
+                        }
+                        for (const uint32_t Slot : Before.FreeBlockSlots)
+                        {
+                            FreeElsewhereNum += bReleased(Slot / PageSize) ? 0 : 1;
+                        }
+                        const uint32_t DroppedNum = CountDrawnBlocks(Before, 0, (uint32_t)Before.BlockPages.size()) - CountDrawnBlocks(Pool, 0, (uint32_t)Pool.BlockPages.size());
+                        HandBackDropNum += DroppedNum;
+                        Mismatch += DroppedNum == ReleasedDrawnNum - std::min(ReleasedDrawnNum, FreeElsewhereNum) ? 0 : 1;
+                        Pool.GPUChunksPool[ChunkIndex].ChunkLocation = { (int32_t)ChunkIndex, (int32_t)t, 0 };
+                        Pool.GPUChunksPool[ChunkIndex].ChunkFrameStamp = ++Stamp;
+                        const uint32_t BlockNum = t == 0 ? DenseBlockNum : LightBlockNum;
+                        for (uint32_t Block = 0; Block < BlockNum; Block++)
+                        {
+                            const uint32_t Slot = Pool.AllocateBlockSlot(PagePool, ModifyBuffer);
+                            if (Slot == INT_MAX)
+                            {
+                                LightDropNum += (t > 0 && Frame >= LightStartFrame + ChunkSlotNum / 4) ? 1 : 0;
+                                continue;
+                            }
+                            const FGPUBlock NewBlock = { .ChunkIndex = ChunkIndex + Pool.ChunkCountOffset, .BlockLocation = { Block & 15, (Block >> 4) & 15, Block >> 8, 255 }, .BlockFrameStamp = Stamp };
+                            Pool.WriteBlock(Slot, NewBlock, Block);
+                            ModifyBuffer.ModifyGPUBlock.push_back(NewBlock);
+                            ModifyBuffer.ModifyGPUBlockIndex.push_back(Slot);
+                        }
+                        Queues[t].Push(std::move(ModifyBuffer));
+                    }
+                }
+                for (uint32_t t = 0; t < ThreadNum; t++)
+                {
+                    Queues[t].Swap();
+                    ReadPools[t].ConsumeQueue(Queues[t]);
+                }
+            }
+            //Block buffer as uploaded against the writers, page by page
+            uint32_t LiveNum = 0;
+            std::vector<FChunkPool::FBlockPageOwner> Owners;
+            std::vector<FGPUBlock> Uploaded(MaxBlockCount), Written(MaxBlockCount);
+            for (uint32_t p = 0; p < PagePools.size(); p++)
+            {
+                const uint32_t PageOffset = p * PagePools[p].Allocator.GetPageNum();
+                FChunkPool::ResolveBlockPageOwners(bShared ? ReadPools : std::vector<FTLSChunkPool>{ ReadPools[p] }, PagePools[p].Allocator.GetPageNum(), Owners);
+                for (uint32_t Page = 0; Page < Owners.size(); Page++)
+                {
+                    if (Owners[Page].ThreadId != INT_MAX)
+                    {
+                        const FTLSChunkPool& Owner = bShared ? ReadPools[Owners[Page].ThreadId] : ReadPools[p];
+                        std::copy_n(Owner.GPUBlockPool.begin() + Owners[Page].LocalPage * PageSize, PageSize, Uploaded.begin() + (PageOffset + Page) * PageSize);
+                    }
+                }
+            }
+            for (uint32_t t = 0; t < ThreadNum; t++)
+            {
+                const FTLSChunkPool& Pool = Pools[t];
+                LiveNum += Pool.SubCurrentBlockCount;
+                const uint32_t PageOffset = bShared ? 0 : t * PagePools[t].Allocator.GetPageNum();
+                uint32_t PoolLiveNum = 0;
+                for (uint32_t LocalPage = 0; LocalPage < Pool.BlockPages.size(); LocalPage++)
+                {
+                    if (Pool.BlockPages[LocalPage] == INT_MAX)
+                    {
+                        continue;
+                    }
+                    std::copy_n(Pool.GPUBlockPool.begin() + LocalPage * PageSize, PageSize, Written.begin() + (PageOffset + Pool.BlockPages[LocalPage]) * PageSize);
+                    PoolLiveNum += Pool.BlockPageLiveNum[LocalPage];
+                }
+                Mismatch += PoolLiveNum == Pool.SubCurrentBlockCount ? 0 : 1;
+                //Moved blocks are still found from their chunk, to be freed with it
+                uint32_t ReachableNum = 0;
+                for (uint32_t ChunkIndex = 0; ChunkIndex < ChunkSlotNum; ChunkIndex++)
+                {
+                    Pool.ForEachChunkBlockSlot(ChunkIndex, [&](const uint32_t Slot)
+                        {
+                            const FGPUBlock& Block = Pool.GPUBlockPool[Slot];
+                            ReachableNum += Pool.BlockPages[Slot / PageSize] != INT_MAX && Block.ChunkIndex == ChunkIndex + Pool.ChunkCountOffset
+                                && Block.BlockFrameStamp == Pool.GPUChunksPool[ChunkIndex].ChunkFrameStamp ? 1 : 0;
+                        });
+                }
+                Mismatch += ReachableNum == CountDrawnBlocks(Pool, 0, (uint32_t)Pool.BlockPages.size()) ? 0 : 1;
+            }
+            //Freed blocks aren't cleared on the reading side, they are hidden by the stamp of the chunk now in their slot
+            auto bVisible = [&](const FGPUBlock& Block)
+                {
+                    return Block.ChunkIndex != INT_MAX && Pools[Block.ChunkIndex / ChunkSlotNum].GPUChunksPool[Block.ChunkIndex % ChunkSlotNum].ChunkFrameStamp == Block.BlockFrameStamp;
+                };
+            for (uint32_t i = 0; i < MaxBlockCount; i++)
+            {
+                const bool bUploadedVisible = bVisible(Uploaded[i]);
+                Mismatch += (bUploadedVisible == bVisible(Written[i]) && (!bUploadedVisible || (Uploaded[i].ChunkIndex == Written[i].ChunkIndex
+                    && Uploaded[i].BlockFrameStamp == Written[i].BlockFrameStamp && Uploaded[i].BlockLocation == Written[i].BlockLocation))) ? 0 : 1;
+            }
+            Utilisation = (double)LiveNum / MaxBlockCount;
+        };
+    double SharedUtilisation = 0.0, SplitUtilisation = 0.0;
+    uint32_t SharedLightDropNum = 0, SplitLightDropNum = 0;
+    Simulate(true, SharedUtilisation, SharedLightDropNum);
+    Simulate(false, SplitUtilisation, SplitLightDropNum);
+    //Light threads need far less than their share, once settled they must never drop a block
+    Mismatch += SharedLightDropNum;
+    Mismatch += RunPageAllocatorStress(4);
+    printf("%-34s %.1lf%% block slots used vs %.1lf%% even split, %u light blocks dropped, %u dropped handing pages back, %u mismatched\n", "Block pages (skewed load)",
+        SharedUtilisation * 100.0, SplitUtilisation * 100.0, SharedLightDropNum, HandBackDropNum, Mismatch);
+    return Mismatch;
+}
+
+/*
+Worker to render handoff of pushed chunks through FChunkPoolCore::PushChunk, reserved in the lookup table first like the chunk manager does,
+then gathered and logged for the upload like UpdateDebugVisibleChunk. The chunk is moved into its slot once, the GPU side deltas go through recycled modify buffers,
+map nodes and query data are reused. Against the old handoff copying the chunk into a std::queue'd buffer and again into the reading pool.
+Only the push and the render side are counted, generating the chunks isn't.
+*/
+static uint32_t RunModifyBufferHandoff(const FVoxelSceneConfig& VoxelSceneConfig)
+{
+    constexpr int32_t LocationSide = 8;//More locations than slots, pushes keep replacing resident neighbours
+    constexpr uint32_t PushPerFrame = 8;
+    constexpr uint32_t WarmFrameNum = 32;//Slots, pages, map nodes and recycled buffers reach their size
+    constexpr uint32_t FrameNum = 64;
+    struct FOldModifyBuffer
+    {
+        FChunk ModifyChunk;
+        uint32_t ModifyChunkIndex = INT_MAX;
+        std::vector<FGPUBlock> ModifyGPUBlock;
+        std::vector<uint32_t> ModifyGPUBlockIndex;
+    };
+    std::vector<FChunk> Sources;
+    for (int32_t i = 0; i < LocationSide * LocationSide; i++)
+    {
+        Sources.push_back(FGeneratorHelper::TestGeneratorBatched<>({ i % LocationSide, 0, i / LocationSide }, VoxelSceneConfig.BlockSize, VoxelSceneConfig.ChunkResolution, 0));
+    }
+    FVoxelSceneConfig PoolSceneConfig = VoxelSceneConfig;
+    PoolSceneConfig.MaxChunkCount = 32;
+    PoolSceneConfig.MaxEmptyChunkCount = 1;
+    PoolSceneConfig.MaxBlockCount = 1u << 20;
+    FChunkPoolCore Pool;
+    Pool.InitializePools(PoolSceneConfig, 1);
+    const FImportanceComputeInfo CameraInfo = { .CameraChunk = { LocationSide / 2, 0, LocationSide / 2 }, .CameraForwardVector = { 0.0f, 0.0f, 1.0f } };
+    TDoubleBufferQueue<FOldModifyBuffer> OldQueue;
+    std::vector<FChunk> OldReadChunks(PoolSceneConfig.MaxChunkCount);
+
+    uint32_t Mismatch = 0;
+    uint64_t AllocationNum = 0, OldAllocationNum = 0, PushNum = 0, OldPushNum = 0;
+    double OldCopiedBytes = 0.0;
+    for (uint32_t Frame = 0; Frame < WarmFrameNum + FrameNum; Frame++)
+    {
+        std::vector<FChunk> Chunks;
+        for (uint32_t Push = 0; Push < PushPerFrame; Push++)
+        {
+            Chunks.push_back(Sources[(Frame * PushPerFrame + Push) % Sources.size()]);
+        }
+        const bool bCounted = Frame >= WarmFrameNum;
+        Pool.IncreaseFrameStamp();
+        //New handoff
+        uint64_t AllocationStart = ThreadAllocationNum;
+        for (uint32_t Push = 0; Push < PushPerFrame; Push++)
+        {
+            EChunkState State;
+            if (!Pool.ChunksLookupTable.ATOMIC_not_contains_insert(Chunks[Push].GetChunkKey(), EChunkState::Computing, State))
+            {
+                continue;//Still resident
+            }
+            Pool.PushChunk(std::move(Chunks[Push]), 0, Pool.GetFrameStamp(), VoxelSceneConfig.ChunkResolution, CameraInfo, VoxelSceneConfig.GetChunkSize(), EChunkOverrideMode::OverrideMin);
+            PushNum += bCounted ? 1 : 0;
+        }
+        Pool.GatherDebugInstanceInfo(PoolSceneConfig);
+        const auto SkipUpload = [](const void*, size_t, size_t) {};
+        FChunkPoolCore::ResolveBlockPageOwners(Pool.TLSChunkPoolRead, Pool.BlockPagePool.Allocator.GetPageNum(), Pool.BlockPageOwners);
+        for (FTLSChunkPool& ReadPool : Pool.TLSChunkPoolRead)
+        {
+            FChunkPoolCore::UploadSpans(Pool.GatherUploadSpans(ReadPool.GPUInstanceLog, 0), ReadPool.GPUInstanceData, ReadPool.GPUInstanceOffset, Pool.UploadMergeGapBytes, SkipUpload);
+            FChunkPoolCore::UploadSpans(Pool.GatherUploadSpans(ReadPool.GPUChunkLog, 0), ReadPool.GPUChunksPool, ReadPool.ChunkCountOffset, Pool.UploadMergeGapBytes, SkipUpload);
+            FChunkPoolCore::UploadBlockSpans(Pool.GatherUploadSpans(ReadPool.GPUBlockLog, 0), Pool.TLSChunkPoolRead, Pool.BlockPageOwners, Pool.InvalidBlockPage, Pool.BlockPagePool.PageSize, Pool.UploadMergeGapBytes, SkipUpload);
+        }
+        Pool.FrameUploadVersion[0] = Pool.UploadVersion;
+        Pool.TruncateUploadLogs();
+        if (bCounted)
+        {
+            AllocationNum += ThreadAllocationNum - AllocationStart;
+        }
+
+        //Old handoff, same chunks copied twice
+        for (uint32_t Push = 0; Push < PushPerFrame; Push++)
+        {
+            Chunks[Push] = Sources[(Frame * PushPerFrame + Push) % Sources.size()];
+        }
+        AllocationStart = ThreadAllocationNum;
+        for (uint32_t Push = 0; Push < PushPerFrame; Push++)
+        {
+            FOldModifyBuffer ModifyBuffer;
+            ModifyBuffer.ModifyChunk = Chunks[Push]; //Copy
+            OldCopiedBytes += bCounted ? 2.0 * (sizeof(FChunk) + Chunks[Push].Blocks.size() * sizeof(FBlock)) : 0.0;
+            ModifyBuffer.ModifyChunkIndex = (Frame * PushPerFrame + Push) % PoolSceneConfig.MaxChunkCount;
+            for (uint32_t Block = 0; Block < Chunks[Push].Blocks.size(); Block++)
+            {
+                ModifyBuffer.ModifyGPUBlock.push_back({ .ChunkIndex = ModifyBuffer.ModifyChunkIndex, .BlockLocation = { Chunks[Push].Blocks[Block].BlockLocation, 255 }, .BlockFrameStamp = Pool.GetFrameStamp() });
+                ModifyBuffer.ModifyGPUBlockIndex.push_back(Block);
+            }
+            OldQueue.Push(std::move(ModifyBuffer));
+            OldPushNum += bCounted ? 1 : 0;
+        }
+        OldQueue.Swap();
+        for (FOldModifyBuffer ModifyBuffer; OldQueue.Pop(ModifyBuffer);)
+        {
+            OldReadChunks[ModifyBuffer.ModifyChunkIndex] = ModifyBuffer.ModifyChunk;
+        }
+        if (bCounted)
+        {
+            OldAllocationNum += ThreadAllocationNum - AllocationStart;
+        }
+    }
+    //The reading pool sees every resident block, every resident chunk with solid voxels is in the cache with its own query data
+    const FTLSChunkPool& WritePool = Pool.TLSChunkPool[0];
+    const FTLSChunkPool& ReadPool = Pool.TLSChunkPoolRead[0];
+    for (uint32_t ChunkIndex = 0; ChunkIndex < WritePool.SubMaxChunkCount; ChunkIndex++)
+    {
+        Mismatch += std::memcmp(&ReadPool.GPUChunksPool[ChunkIndex], &WritePool.GPUChunksPool[ChunkIndex], sizeof(FGPUChunk)) == 0 ? 0 : 1;
+        WritePool.ForEachChunkBlockSlot(ChunkIndex, [&](const uint32_t Slot)
+            {
+                Mismatch += std::memcmp(&ReadPool.GPUBlockPool[Slot], &WritePool.GPUBlockPool[Slot], sizeof(FGPUBlock)) == 0 ? 0 : 1;
+            });
+        const FChunk& Chunk = WritePool.ChunksPool[ChunkIndex];
+        FChunkPoolCore::FResidentChunkEntry Entry;
+        const bool bCached = Chunk.bIsValid() && Pool.ResidentChunkCache.ATOMIC_get(Chunk.GetChunkKey(), Entry);
+        Mismatch += (bCached && Entry.ChunkIndex == ChunkIndex && Entry.Data == WritePool.ChunkQueryData[ChunkIndex] && Entry.Data->ChunkKey == Chunk.GetChunkKey()) == Chunk.bIsValid() ? 0 : 1;
+    }
+    Mismatch += PushNum > 0 && AllocationNum == 0 ? 0 : 1;
+    printf("%-34s %.2lf allocations/push (%llu pushes) vs %.2lf copying (%.1lf KB of chunk copies/push), %u mismatched\n", "Modify buffer handoff",
+        PushNum ? (double)AllocationNum / PushNum : 0.0, (unsigned long long)PushNum, OldPushNum ? (double)OldAllocationNum / OldPushNum : 0.0, OldPushNum ? OldCopiedBytes / OldPushNum / 1024.0 : 0.0, Mismatch);
+    return Mismatch;
+}
+
+/*
+Chunks of different mip levels over the same place pushed from two threads, the way the camera moving across a LOD ring does it.
+Once the owners drained their requests only one level of a place may be resident: in the writing pools, the lookup table, the resident cache and
+the bricks, and no block of an evicted chunk may still match its GPU chunk. A scripted case first, then random pushes into small pools.
+*/
+static uint32_t CountLodOverlapErrors(const FChunkPoolCore& Pool, const uint32_t MaxMipmapLevel)
+{
+    uint32_t Error = 0;
+    std::map<ivec4, uint32_t, FIVec4Comparator> Resident;//Key -> thread
+    for (uint32_t ThreadId = 0; ThreadId < Pool.ThreadCount; ThreadId++)
+    {
+        const FTLSChunkPool& WritePool = Pool.TLSChunkPool[ThreadId];
+        for (uint32_t ChunkIndex = 0; ChunkIndex < WritePool.SubMaxChunkCount; ChunkIndex++)
+        {
+            const FChunk& Chunk = WritePool.ChunksPool[ChunkIndex];
+            if (!Chunk.bIsValid())
+            {
+                Error += WritePool.GPUChunksPool[ChunkIndex].ChunkFrameStamp == UINT32_MAX || WritePool.GPUChunksPool[ChunkIndex].ChunkLocation.x == INT_MAX ? 0 : 1;
+                continue;
+            }
+            Resident[Chunk.GetChunkKey()] = ThreadId;
+            EChunkState State;
+            FChunkPoolCore::FResidentChunkEntry Entry;
+            Error += Pool.ChunksLookupTable.ATOMIC_get(Chunk.GetChunkKey(), State) && State == EChunkState::NonEmpty ? 0 : 1;
+            Error += Pool.ResidentChunkCache.ATOMIC_get(Chunk.GetChunkKey(), Entry) && Entry.ThreadId == ThreadId && Entry.ChunkIndex == ChunkIndex ? 0 : 1;
+            Error += Pool.bIsResidentChunkSolid(Chunk.GetChunkKey()) ? 0 : 1;
+        }
+        //Every block still matching its GPU chunk belongs to a resident chunk
+        for (uint32_t LocalPage = 0; LocalPage < WritePool.BlockPages.size(); LocalPage++)
+        {
+            for (uint32_t Slot = LocalPage * WritePool.BlockPageSize; WritePool.BlockPages[LocalPage] != INT_MAX && Slot < (LocalPage + 1) * WritePool.BlockPageSize; Slot++)
+            {
+                const FGPUBlock& Block = WritePool.GPUBlockPool[Slot];
+                if (Block.ChunkIndex != INT_MAX && WritePool.GPUChunksPool[Block.ChunkIndex - WritePool.ChunkCountOffset].ChunkFrameStamp == Block.BlockFrameStamp)
+                {
+                    Error += WritePool.ChunksPool[Block.ChunkIndex - WritePool.ChunkCountOffset].bIsValid() ? 0 : 1;
+                }
+            }
+        }
+    }
+    for (const auto& [Key, ThreadId] : Resident)
+    {
+        Pool.ForEachOverlappingResidentChunk(Key, MaxMipmapLevel, [&](const ivec4&) { Error++; });
+        for (uint32_t MipmapLevel = 0; MipmapLevel <= MaxMipmapLevel; MipmapLevel++)
+        {
+            const ivec4 OverlapKey = ivec4(FImportanceComputeInfo::AlignChunkLocation(ivec3(Key), MipmapLevel), (int32_t)MipmapLevel);
+            Error += MipmapLevel > (uint32_t)Key.w && Resident.contains(OverlapKey) ? 1 : 0;
+        }
+        const FChunkRayLookup Lookup = Pool.FindRayChunk(ivec3(Key), MaxMipmapLevel);
+        Error += Lookup.Data && Lookup.Data->ChunkKey == Key ? 0 : 1;
+    }
+    Error += Pool.ResidentChunkCache.ATOMIC_size() == Resident.size() ? 0 : 1;
+    return Error;
+}
+
+static uint32_t RunLodOverlap(const FVoxelSceneConfig& VoxelSceneConfig)
+{
+    constexpr uint32_t MaxMipmapLevel = 2;
+    constexpr uint32_t RandomPushNum = 2000;
+    std::map<ivec4, FChunk, FIVec4Comparator> Generated;
+    auto Generate = [&](const ivec3 ChunkLocation, const uint32_t MipmapLevel)
+        {
+            const ivec4 Key = ivec4(ChunkLocation, (int32_t)MipmapLevel);
+            auto It = Generated.find(Key);
+            if (It == Generated.end())
+            {
+                It = Generated.emplace(Key, GenerateLevelChunk(ChunkLocation, MipmapLevel, VoxelSceneConfig)).first;
+            }
+            return It->second;
+        };
+    FVoxelSceneConfig PoolSceneConfig = VoxelSceneConfig;
+    PoolSceneConfig.MaxChunkCount = 64;
+    PoolSceneConfig.MaxEmptyChunkCount = 2;
+    PoolSceneConfig.MaxBlockCount = 1u << 20;
+    const FImportanceComputeInfo CameraInfo = { .CameraChunk = { 4, 0, 4 }, .CameraForwardVector = { 0.0f, 0.0f, 1.0f }, .MaxChunkMipmapLevel = MaxMipmapLevel };
+    FChunkPoolCore Pool;
+    Pool.InitializePools(PoolSceneConfig, 2);
+    uint32_t PushNum = 0;
+    auto Push = [&](const ivec3 ChunkLocation, const uint32_t MipmapLevel, const uint32_t ThreadId)
+        {
+            FChunk Chunk = Generate(ChunkLocation, MipmapLevel);
+            EChunkState State;
+            if (Chunk.Blocks.empty() || !Pool.ChunksLookupTable.ATOMIC_not_contains_insert(Chunk.GetChunkKey(), EChunkState::Computing, State))
+            {
+                return;
+            }
+            Pool.IncreaseFrameStamp();
+            Pool.PushChunk(std::move(Chunk), ThreadId, Pool.GetFrameStamp(), VoxelSceneConfig.ChunkResolution, CameraInfo, VoxelSceneConfig.GetChunkSize(), EChunkOverrideMode::OverrideMin);
+            PushNum++;
+        };
+    auto Drain = [&]()
+        {
+            for (uint32_t ThreadId = 0; ThreadId < Pool.ThreadCount; ThreadId++)
+            {
+                Pool.ProcessChunkSlotRequests(ThreadId, CameraInfo, VoxelSceneConfig.ChunkResolution);
+            }
+            Pool.GatherDebugInstanceInfo(PoolSceneConfig);
+        };
+    uint32_t Mismatch = 0;
+    //Level 1 chunk, then level 0 chunks inside it from the other thread: it leaves the queries at once and its owner frees it
+    Push({ 0, 0, 0 }, 1, 0);
+    Push({ 0, 0, 0 }, 0, 1);
+    Mismatch += Pool.ResidentChunkCache.ATOMIC_contains(ivec4(0, 0, 0, 1)) ? 1 : 0;
+    Mismatch += Pool.FindRayChunk({ 1, 1, 1 }, MaxMipmapLevel).Data ? 1 : 0;
+    Push({ 1, 0, 1 }, 0, 1);
+    Drain();
+    Mismatch += Pool.ChunksLookupTable.ATOMIC_contains(ivec4(0, 0, 0, 1)) ? 1 : 0;
+    Mismatch += CountLodOverlapErrors(Pool, MaxMipmapLevel);
+    //Level 2 over both
+    Push({ 0, 0, 0 }, 2, 0);
+    Drain();
+    Mismatch += Pool.ResidentChunkCache.ATOMIC_size() == 1 ? 0 : 1;
+    Mismatch += CountLodOverlapErrors(Pool, MaxMipmapLevel);
+    //The reading pools saw the evictions
+    for (uint32_t ThreadId = 0; ThreadId < Pool.ThreadCount; ThreadId++)
+    {
+        const FTLSChunkPool& WritePool = Pool.TLSChunkPool[ThreadId];
+        const FTLSChunkPool& ReadPool = Pool.TLSChunkPoolRead[ThreadId];
+        Mismatch += std::memcmp(ReadPool.GPUChunksPool.data(), WritePool.GPUChunksPool.data(), sizeof(FGPUChunk) * WritePool.GPUChunksPool.size()) == 0 ? 0 : 1;
+        Mismatch += std::memcmp(ReadPool.GPUInstanceData.data(), WritePool.GPUInstanceData.data(), sizeof(FGPUSimpleInstanceData) * WritePool.GPUInstanceData.size()) == 0 ? 0 : 1;
+    }
+    const uint32_t ScriptedMismatch = Mismatch;
+
+    //Random levels over a small place from both threads, the pools fill up so evictions and replacements mix
+    uint32_t Seed = 7;
+    auto Random = [&Seed]() { Seed = Seed * 1664525u + 1013904223u; return Seed >> 8; };
+    for (uint32_t i = 0; i < RandomPushNum; i++)
+    {
+        const uint32_t MipmapLevel = Random() % (MaxMipmapLevel + 1);
+        const ivec3 ChunkLocation = FImportanceComputeInfo::AlignChunkLocation({ (int32_t)(Random() % 16) - 4, (int32_t)(Random() % 4) - 2, (int32_t)(Random() % 16) - 4 }, MipmapLevel);
+        Push(ChunkLocation, MipmapLevel, Random() % Pool.ThreadCount);
+    }
+    Drain();
+    Mismatch += CountLodOverlapErrors(Pool, MaxMipmapLevel);
+    printf("%-34s %u pushes, %zu resident, %u mismatched (%u scripted)\n", "LOD overlap eviction", PushNum, Pool.ResidentChunkCache.ATOMIC_size(), Mismatch, ScriptedMismatch);
+    return Mismatch;
+}
+
+//Border blocks of a resident chunk whose residency or face mask doesn't follow its resident neighbours
+static uint32_t CountStaleBorderBlocks(FChunkPoolCore& Pool, const uint32_t ThreadId, const uint32_t ChunkIndex)
+{
+    const FTLSChunkPool& WritePool = Pool.TLSChunkPool[ThreadId];
+    const FChunk& Chunk = WritePool.ChunksPool[ChunkIndex];
+    std::array<FChunkPoolCore::FResidentChunkEntry, ChunkFaceNum> Entries;
+    FChunkNeighbourSlices NeighbourSlices;
+    Pool.GatherNeighbourSlices(Chunk.GetChunkKey(), Entries, NeighbourSlices);
+    const uint32_t CullDepthThreshold = Pool.AtomicCullDepthThreshold.load();
+    std::vector<uint32_t> ResidentSlots(Chunk.Blocks.size(), INT_MAX);
+    WritePool.ForEachChunkBlockSlot(ChunkIndex, [&](const uint32_t Slot) { ResidentSlots[WritePool.BlockSlotLinks[Slot].BlockIndex] = Slot; });
+    uint32_t Stale = 0;
+    for (uint32_t BlockIndex = 0; BlockIndex < Chunk.Blocks.size(); BlockIndex++)
+    {
+        const u8vec3 BlockLocation = Chunk.Blocks[BlockIndex].BlockLocation;
+        if (!FChunk::bIsBorderVoxel(BlockLocation) || Chunk.bShouldVoxelOccupancyCull(BlockLocation, CullDepthThreshold))
+        {
+            continue;
+        }
+        const uint8_t FaceMask = Chunk.GetFaceMask(BlockLocation, NeighbourSlices);
+        const uint32_t Slot = ResidentSlots[BlockIndex];
+        const bool bResident = Slot != INT_MAX;
+        Stale += bResident == (CullDepthThreshold > 0 && FaceMask == 0) || (bResident && WritePool.GPUBlockPool[Slot].BlockLocation.w != FaceMask) ? 1 : 0;
+    }
+    return Stale;
+}
+
+/*
+Border re-culls of a thread that stopped pushing are drained at the frame boundary by ProcessIdleChunkSlotRequests, like the chunk manager does once a frame.
+A pool being pushed to (its lock held) is left to its own push. Thread 0 pushes a chunk and stops, thread 1 pushes its neighbour.
+*/
+static uint32_t RunFrameBoundaryDrain(const FVoxelSceneConfig& VoxelSceneConfig)
+{
+    FVoxelSceneConfig PoolSceneConfig = VoxelSceneConfig;
+    PoolSceneConfig.MaxChunkCount = 8;
+    PoolSceneConfig.MaxEmptyChunkCount = 2;
+    PoolSceneConfig.MaxBlockCount = 1u << 18;
+    const FImportanceComputeInfo CameraInfo = { .CameraForwardVector = { 0.0f, 0.0f, 1.0f } };
+    FChunkPoolCore Pool;
+    Pool.InitializePools(PoolSceneConfig, 2);
+    auto Push = [&](const ivec3 ChunkLocation, const uint32_t ThreadId)
+        {
+            FChunk Chunk = GenerateLevelChunk(ChunkLocation, 0, VoxelSceneConfig);
+            EChunkState State;
+            Pool.ChunksLookupTable.ATOMIC_not_contains_insert(Chunk.GetChunkKey(), EChunkState::Computing, State);
+            Pool.PushChunk(std::move(Chunk), ThreadId, Pool.GetFrameStamp(), VoxelSceneConfig.ChunkResolution, CameraInfo, VoxelSceneConfig.GetChunkSize(), EChunkOverrideMode::FindMin);
+        };
+    Push({ 0, 0, 0 }, 0);
+    Push({ 1, 0, 0 }, 1);
+    FChunkPoolCore::FResidentChunkEntry Entry;
+    uint32_t Mismatch = Pool.ResidentChunkCache.ATOMIC_get(ivec4(0, 0, 0, 0), Entry) && Entry.ThreadId == 0 ? 0 : 1;
+    const uint32_t StaleBefore = CountStaleBorderBlocks(Pool, 0, Entry.ChunkIndex);
+    Mismatch += Pool.BorderRecullQueues[0]->Size() > 0 && StaleBefore > 0 ? 0 : 1;
+    {
+        std::lock_guard<std::mutex> Lock(*Pool.WritingPoolLocks[0]);//Thread 0 pushing
+        Pool.ProcessIdleChunkSlotRequests(CameraInfo, VoxelSceneConfig.ChunkResolution);
+        Mismatch += Pool.BorderRecullQueues[0]->Size() > 0 ? 0 : 1;
+    }
+    const uint64_t PushVersion = Pool.AtomicPushVersion.load();
+    Pool.ProcessIdleChunkSlotRequests(CameraInfo, VoxelSceneConfig.ChunkResolution);
+    const uint32_t StaleAfter = CountStaleBorderBlocks(Pool, 0, Entry.ChunkIndex);
+    Mismatch += Pool.BorderRecullQueues[0]->Size() == 0 && StaleAfter == 0 && Pool.AtomicPushVersion.load() != PushVersion ? 0 : 1;
+    printf("%-34s %u stale border blocks of the idle thread, %u after the drain, %u mismatched\n", "Frame boundary drain", StaleBefore, StaleAfter, Mismatch);
+    return Mismatch;
+}
+
+/*
+Partial uploads the way UpdateDebugVisibleChunk does them, into a CPU mirror of every buffered frame's buffers. The reading pools log
+their changes once at an upload version, a frame replays the log entries after the version it last got, they are dropped once all frames have them.
+Chunks, instances and blocks change at random (pages move between the pools too, some frames push nothing), after its upload every mirror must equal a full upload.
+*/
+static uint32_t RunDirtySpans()
+{
+    constexpr uint32_t ThreadNum = 3;
+    constexpr uint32_t BufferedFramesNum = 4;
+    constexpr uint32_t PageSize = 64;
+    constexpr uint32_t MaxBlockCount = PageSize * 40 + 17;//Tail short of a page
+    constexpr uint32_t ChunkSlotNum = 24;
+    constexpr uint32_t FrameNum = 96;
+    constexpr uint32_t GapBytes = 256;
+    FBlockPagePool PagePool;
+    PagePool.Initialize(MaxBlockCount, PageSize, ThreadNum);
+    const std::vector<FGPUBlock> InvalidBlockPage(PageSize);
+    std::vector<FTLSChunkPool> Pools(ThreadNum), ReadPools(ThreadNum);
+    std::vector<FTLSChunkPool::FModifyBufferQueue> Queues(ThreadNum);
+    uint64_t UploadVersion = 1;
+    std::vector<uint64_t> FrameUploadVersion(BufferedFramesNum, 0);
+    for (uint32_t t = 0; t < ThreadNum; t++)
+    {
+        Pools[t].Initialize(ChunkSlotNum, 1, PageSize, t * ChunkSlotNum, t);
+        ReadPools[t].Initialize(ChunkSlotNum, 1, PageSize, t * ChunkSlotNum, t, true);
+        ReadPools[t].StartUploadLog(UploadVersion);
+    }
+    ReadPools[0].GPUBlockLog.AddRange(UploadVersion, 0, MaxBlockCount);
+    const size_t ChunkBytes = sizeof(FGPUChunk) * ChunkSlotNum * ThreadNum;
+    const size_t InstanceBytes = sizeof(FGPUSimpleInstanceData) * (ChunkSlotNum + 1) * ThreadNum;
+    const size_t BlockBytes = sizeof(FGPUBlock) * MaxBlockCount;
+    //Garbage until uploaded
+    std::vector<std::vector<uint8_t>> ChunkMirrors(BufferedFramesNum, std::vector<uint8_t>(ChunkBytes, 0xCD));
+    std::vector<std::vector<uint8_t>> InstanceMirrors(BufferedFramesNum, std::vector<uint8_t>(InstanceBytes, 0xCD));
+    std::vector<std::vector<uint8_t>> BlockMirrors(BufferedFramesNum, std::vector<uint8_t>(BlockBytes, 0xCD));
+    std::vector<uint8_t> Reference;
+    std::vector<FChunkPool::FBlockPageOwner> Owners;
+    FDirtySpans Spans;
+
+    uint32_t Mismatch = 0;
+    uint32_t Seed = 12345;
+    auto Random = [&Seed]() { Seed = Seed * 1664525u + 1013904223u; return Seed >> 8; };
+    uint32_t Stamp = 0;
+    double UploadedBytes = 0.0, ReuploadedBytes = 0.0;
+    size_t MaxLogSize = 0;
+    for (uint32_t Frame = 0; Frame < FrameNum; Frame++)
+    {
+        //Quiet stretches, the frames still catch up on what they missed
+        const bool bQuiet = Frame % 24 >= 20;
+        for (uint32_t t = 0; t < ThreadNum && !bQuiet; t++)
+        {
+            FTLSChunkPool& Pool = Pools[t];
+            const uint32_t PushNum = Random() % 3;
+            for (uint32_t Push = 0; Push < PushNum; Push++)
+            {
+                const uint32_t ChunkIndex = Random() % ChunkSlotNum;
+                FTLSModifyBuffer ModifyBuffer = Queues[t].Acquire();
+                Pool.FreeChunkBlocks(ChunkIndex, PagePool, ModifyBuffer);
+                Pool.RebalanceBlockPages(PagePool, ModifyBuffer, FImportanceComputeInfo(), 16);
+                ModifyBuffer.ModifyGPUChunk = { .ChunkLocation = { (int32_t)Random(), 0, 0 }, .ChunkFrameStamp = ++Stamp };
+                ModifyBuffer.ModifyGPUChunkIndex = ChunkIndex;
+                Pool.GPUChunksPool[ChunkIndex] = ModifyBuffer.ModifyGPUChunk;
+                ModifyBuffer.ModifyGPUInstance = { .Position = { (float)Random(), 0.0f, 0.0f }, .ChunkLocation = ModifyBuffer.ModifyGPUChunk.ChunkLocation };
+                ModifyBuffer.ModifyGPUInstanceIndex = ChunkIndex;
+                //Thread 0 sometimes pushes dense chunks, pages move around
+                const uint32_t BlockNum = Random() % (t == 0 && Frame % 16 < 8 ? 400 : 60);
+                for (uint32_t Block = 0; Block < BlockNum; Block++)
+                {
+                    const uint32_t Slot = Pool.AllocateBlockSlot(PagePool, ModifyBuffer);
+                    if (Slot == INT_MAX)
+                    {
+                        break;
+                    }
+                    const FGPUBlock NewBlock = { .ChunkIndex = ChunkIndex + Pool.ChunkCountOffset, .BlockLocation = { Block & 15, (Block >> 4) & 15, Block >> 8, 255 }, .BlockFrameStamp = Stamp };
+                    Pool.WriteBlock(Slot, NewBlock, Block);
+                    ModifyBuffer.ModifyGPUBlock.push_back(NewBlock);
+                    ModifyBuffer.ModifyGPUBlockIndex.push_back(Slot);
+                }
+                Queues[t].Push(std::move(ModifyBuffer));
+            }
+        }
+        UploadVersion++;
+        for (uint32_t t = 0; t < ThreadNum; t++)
+        {
+            Queues[t].Swap();
+            ReadPools[t].ConsumeQueue(Queues[t], UploadVersion);
+        }
+
+        const uint32_t RenderFrameIndex = Frame % BufferedFramesNum;
+        auto MirrorUpload = [&UploadedBytes](std::vector<uint8_t>& Mirror)
+            {
+                return [&Mirror, &UploadedBytes](const void* Data, size_t Size, size_t Offset)
+                    {
+                        std::memcpy(Mirror.data() + Offset, Data, Size);
+                        UploadedBytes += (double)Size;
+                    };
+            };
+        auto GatherSpans = [&](const FVersionedSpanLog& Log) -> FDirtySpans&
+            {
+                Spans.Clear();
+                Log.Gather(FrameUploadVersion[RenderFrameIndex], Spans);
+                return Spans;
+            };
+        FChunkPool::ResolveBlockPageOwners(ReadPools, PagePool.Allocator.GetPageNum(), Owners);
+        for (uint32_t t = 0; t < ThreadNum; t++)
+        {
+            FTLSChunkPool& ReadPool = ReadPools[t];
+            FChunkPool::UploadSpans(GatherSpans(ReadPool.GPUChunkLog), ReadPool.GPUChunksPool, ReadPool.ChunkCountOffset, GapBytes, MirrorUpload(ChunkMirrors[RenderFrameIndex]));
+            FChunkPool::UploadSpans(GatherSpans(ReadPool.GPUInstanceLog), ReadPool.GPUInstanceData, ReadPool.GPUInstanceOffset, GapBytes, MirrorUpload(InstanceMirrors[RenderFrameIndex]));
+            FChunkPool::UploadBlockSpans(GatherSpans(ReadPool.GPUBlockLog), ReadPools, Owners, InvalidBlockPage, PageSize, GapBytes, MirrorUpload(BlockMirrors[RenderFrameIndex]));
+        }
+        FrameUploadVersion[RenderFrameIndex] = UploadVersion;
+        const uint64_t MinVersion = *std::min_element(FrameUploadVersion.begin(), FrameUploadVersion.end());
+        for (FTLSChunkPool& ReadPool : ReadPools)
+        {
+            ReadPool.GPUChunkLog.Truncate(MinVersion);
+            ReadPool.GPUInstanceLog.Truncate(MinVersion);
+            ReadPool.GPUBlockLog.Truncate(MinVersion);
+            MaxLogSize = std::max(MaxLogSize, ReadPool.GPUChunkLog.Size() + ReadPool.GPUInstanceLog.Size() + ReadPool.GPUBlockLog.Size());
+        }
+        //Per frame dirty flags set by every push had each frame re-upload in full, the quiet stretches are no longer than the buffering
+        ReuploadedBytes += (double)(ChunkBytes + InstanceBytes + BlockBytes);
+
+        //Full uploads
+        Reference.assign(ChunkBytes, 0);
+        for (const FTLSChunkPool& ReadPool : ReadPools)
+        {
+            std::memcpy(Reference.data() + sizeof(FGPUChunk) * ReadPool.ChunkCountOffset, ReadPool.GPUChunksPool.data(), sizeof(FGPUChunk) * ReadPool.GPUChunksPool.size());
+        }
+        Mismatch += Reference == ChunkMirrors[RenderFrameIndex] ? 0 : 1;
+        Reference.assign(InstanceBytes, 0);
+        for (const FTLSChunkPool& ReadPool : ReadPools)
+        {
+            std::memcpy(Reference.data() + sizeof(FGPUSimpleInstanceData) * ReadPool.GPUInstanceOffset, ReadPool.GPUInstanceData.data(), sizeof(FGPUSimpleInstanceData) * ReadPool.GPUInstanceData.size());
+        }
+        Mismatch += Reference == InstanceMirrors[RenderFrameIndex] ? 0 : 1;
+        Reference.assign(BlockBytes, 0);
+        for (uint32_t Page = 0; Page * PageSize < MaxBlockCount; Page++)
+        {
+            const uint32_t Num = std::min(PageSize, MaxBlockCount - Page * PageSize);
+            const bool bOwned = Page < Owners.size() && Owners[Page].ThreadId != INT_MAX;
+            const FGPUBlock* Data = bOwned ? ReadPools[Owners[Page].ThreadId].GPUBlockPool.data() + Owners[Page].LocalPage * PageSize : InvalidBlockPage.data();
+            std::memcpy(Reference.data() + sizeof(FGPUBlock) * Page * PageSize, Data, sizeof(FGPUBlock) * Num);
+        }
+        Mismatch += Reference == BlockMirrors[RenderFrameIndex] ? 0 : 1;
+    }
+    //Every frame caught up during the quiet stretch at the end, nothing is left to replay
+    for (const FTLSChunkPool& ReadPool : ReadPools)
+    {
+        Mismatch += ReadPool.GPUChunkLog.Size() + ReadPool.GPUInstanceLog.Size() + ReadPool.GPUBlockLog.Size() == 0 ? 0 : 1;
+    }
+    printf("%-34s %.1lf%% of the bytes of full re-uploads for %u buffered frames, at most %zu log entries per pool, %u mismatched\n", "Dirty span uploads",
+        UploadedBytes / ReuploadedBytes * 100.0, BufferedFramesNum, MaxLogSize, Mismatch);
+    return Mismatch;
+}
+
+
+/*
+MesoPoolBench
+    Chunk pool checks: eviction, block pages, the modify buffer handoff, LOD overlap, border re-culls and partial uploads.
+    The pools are sized by each check, there are no options
+Exit code is non zero on any mismatch
+*/
+int main(int argc, char* argv[])
+{
+    if (argc > 1)
+    {
+        printf("Unknown option %s\n", argv[1]);
+        return 2;
+    }
+    const FVoxelSceneConfig VoxelSceneConfig;
+    printf("Chunk pool: chunks of %d^3\n", VoxelSceneConfig.ChunkResolution);
+    uint32_t Mismatch = 0;
+    Mismatch += RunEvictionIndex();
+    Mismatch += RunBlockPages();
+    Mismatch += RunModifyBufferHandoff(VoxelSceneConfig);
+    Mismatch += RunLodOverlap(VoxelSceneConfig);
+    Mismatch += RunFrameBoundaryDrain(VoxelSceneConfig);
+    Mismatch += RunDirtySpans();
+    printf("Mismatched: %u\n", Mismatch);
+    return Mismatch == 0 ? 0 : 1;
+}
@@ -0,0 +1,25 @@
+// Meso Engine 2024
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+//Counts the heap allocations of the calling thread, for MesoPoolBench's allocation free paths.
+//In its own translation unit so the replaced operators are never inlined next to the matching malloc/free
+thread_local uint64_t ThreadAllocationNum = 0;
+void* operator new(std::size_t Size)
+{
+    ThreadAllocationNum++;
+    if (void* Pointer = std::malloc(Size ? Size : 1))
+    {
+        return Pointer;
+    }
+    throw std::bad_alloc();
+}
+void operator delete(void* Pointer) noexcept
+{
+    std::free(Pointer);
+}
+void operator delete(void* Pointer, std::size_t) noexcept
+{
+    std::free(Pointer);
+}
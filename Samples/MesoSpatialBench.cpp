@@ -0,0 +1,610 @@
+#include "MesoBenchCommon.h"
+#include "Voxel/Chunk/ChunkPool.h"
+#include "Voxel/Spatial/VoxelRayCast.h"
+#include "Voxel/Spatial/VoxelSweep.h"
+#include "Voxel/Spatial/VoxelQueryService.h"
+
+#include <atomic>
+#include <map>
+#include <set>
+
+//Resident chunks for the ray casts, every level 0 chunk maps to the query data of the chunk covering it (any mip level), like FChunkPool::FindRayChunk
+struct FRayCastScene
+{
+    std::map<ivec3, std::shared_ptr<const FChunkQueryData>, FIVec3Comparator> Chunks;
+    std::set<ivec3, FIVec3Comparator> SolidBricks;//Level 0 chunks >> 2 with anything solid, the pool's resident brick bitmap
+    ivec3 Min = ivec3(INT_MAX);
+    ivec3 Max = ivec3(INT_MIN);
+
+    //Locations are aligned to 2^MipmapLevel
+    void Add(FOccupancyGeneratorFunction OccupancyGenerator, const std::vector<ivec3>& Locations, uint32_t MipmapLevel, const FVoxelSceneConfig& VoxelSceneConfig)
+    {
+        const int32_t Size = 1 << MipmapLevel;
+        for (const ivec3& Location : Locations)
+        {
+            FChunk Chunk;
+            Chunk.ChunkLocation = Location;
+            Chunk.MipmapLevel = MipmapLevel;
+            OccupancyGenerator(Chunk.InitializeOccupancy(), Location, VoxelSceneConfig.BlockSize, VoxelSceneConfig.ChunkResolution, MipmapLevel);
+            Chunk.CalculateInteriorDepthFromOccupancy();
+            Min = glm::min(Min, Location);
+            Max = glm::max(Max, Location + Size);
+            if (!Chunk.OccupancyPyramid.bAny())
+            {
+                continue;
+            }
+            const std::shared_ptr<const FChunkQueryData> Data = std::make_shared<const FChunkQueryData>(FChunkQueryData::FromChunk(Chunk));
+            for (int32_t Z = 0; Z < Size; Z++)
+            {
+                for (int32_t Y = 0; Y < Size; Y++)
+                {
+                    for (int32_t X = 0; X < Size; X++)
+                    {
+                        Chunks[Location + ivec3{ X, Y, Z }] = Data;
+                        SolidBricks.insert((Location + ivec3{ X, Y, Z }) >> 2);
+                    }
+                }
+            }
+        }
+    }
+    FChunkRayLookup Find(ivec3 ChunkLocation) const
+    {
+        FChunkRayLookup Lookup;
+        auto Found = Chunks.find(ChunkLocation);
+        if (Found != Chunks.end())
+        {
+            Lookup.Data = Found->second;
+        }
+        else if (!SolidBricks.contains(ChunkLocation >> 2))
+        {
+            Lookup.EmptyCubeShift = 2;
+        }
+        return Lookup;
+    }
+    //Absolute level 0 block, fills the hit location when solid
+    bool bIsSolid(const int64_t Block[3], FRayCastHit& Hit) const
+    {
+        constexpr int32_t ResolutionShift = (int32_t)FChunkOccupancyVolume::ResolutionShift;
+        auto Found = Chunks.find(ivec3{ (int32_t)(Block[0] >> ResolutionShift), (int32_t)(Block[1] >> ResolutionShift), (int32_t)(Block[2] >> ResolutionShift) });
+        if (Found == Chunks.end())
+        {
+            return false;
+        }
+        const FChunkQueryData& Data = *Found->second;
+        ivec3 Local;
+        for (int32_t Axis = 0; Axis < 3; Axis++)
+        {
+            Local[Axis] = (int32_t)((Block[Axis] - ((int64_t)Data.ChunkKey[Axis] << ResolutionShift)) >> Data.ChunkKey.w);
+        }
+        if (!Data.Occupancy.Get(Local))
+        {
+            return false;
+        }
+        Hit.bHit = true;
+        Hit.ChunkLocation = ivec3(Data.ChunkKey);
+        Hit.MipmapLevel = (uint32_t)Data.ChunkKey.w;
+        Hit.BlockLocation = u8vec3(Local);
+        return true;
+    }
+};
+
+struct FBenchmarkRay
+{
+    ivec3 OriginChunk;
+    vec3 LocalOrigin;
+    vec3 Direction;
+};
+
+//Origins anywhere in the scene bounds (some start inside solid blocks), directions uniform on the sphere
+static std::vector<FBenchmarkRay> GetBenchmarkRays(const FRayCastScene& Scene, uint32_t RayNum, const FVoxelSceneConfig& VoxelSceneConfig)
+{
+    uint32_t Seed = 0x2545F491u;
+    auto Random = [&Seed]() { Seed = Seed * 1664525u + 1013904223u; return (float)((Seed >> 8) * (1.0 / 16777216.0)); };
+    std::vector<FBenchmarkRay> Rays(RayNum);
+    for (FBenchmarkRay& Ray : Rays)
+    {
+        for (int32_t Axis = 0; Axis < 3; Axis++)
+        {
+            Ray.OriginChunk[Axis] = Scene.Min[Axis] + std::min((int32_t)(Random() * (Scene.Max[Axis] - Scene.Min[Axis])), Scene.Max[Axis] - Scene.Min[Axis] - 1);
+            Ray.LocalOrigin[Axis] = Random() * VoxelSceneConfig.GetChunkSize();
+        }
+        const float CosTheta = Random() * 2.0f - 1.0f;
+        const float Phi = Random() * 6.28318531f;
+        const float SinTheta = std::sqrt(std::max(0.0f, 1.0f - CosTheta * CosTheta));
+        Ray.Direction = { SinTheta * std::cos(Phi), CosTheta, SinTheta * std::sin(Phi) };
+    }
+    return Rays;
+}
+
+//One level 0 block per step, Amanatides & Woo
+static FRayCastHit ReferenceRayCast(const FRayCastScene& Scene, const FBenchmarkRay& Ray, float MaxDistance, float BlockSize)
+{
+    constexpr int64_t Resolution = FChunkOccupancyVolume::Resolution;
+    const double Length = std::sqrt((double)Ray.Direction.x * Ray.Direction.x + (double)Ray.Direction.y * Ray.Direction.y + (double)Ray.Direction.z * Ray.Direction.z);
+    int64_t Block[3], Step[3];
+    double NextT[3], DeltaT[3];
+    for (int32_t Axis = 0; Axis < 3; Axis++)
+    {
+        const double Origin = (double)Ray.OriginChunk[Axis] * Resolution + (double)Ray.LocalOrigin[Axis] / BlockSize;
+        const double Dir = Ray.Direction[Axis] / Length;
+        Block[Axis] = (int64_t)std::floor(Origin);
+        Step[Axis] = Dir > 0.0 ? 1 : -1;
+        NextT[Axis] = Dir == 0.0 ? INFINITY : ((double)(Block[Axis] + (Dir > 0.0 ? 1 : 0)) - Origin) / Dir;
+        DeltaT[Axis] = Dir == 0.0 ? INFINITY : 1.0 / std::abs(Dir);
+    }
+    const double MaxT = (double)MaxDistance / BlockSize;
+    FRayCastHit Hit;
+    double T = 0.0;
+    uint8_t Face = UINT8_MAX;
+    while (T <= MaxT)
+    {
+        if (Scene.bIsSolid(Block, Hit))
+        {
+            Hit.Face = Face;
+            Hit.Distance = (float)(T * BlockSize);
+            return Hit;
+        }
+        const int32_t Axis = NextT[0] < NextT[1] ? (NextT[0] < NextT[2] ? 0 : 2) : (NextT[1] < NextT[2] ? 1 : 2);
+        if (NextT[Axis] > MaxT)
+        {
+            break;
+        }
+        T = NextT[Axis];
+        NextT[Axis] += DeltaT[Axis];
+        Block[Axis] += Step[Axis];
+        Face = (uint8_t)(Axis * 2 + (Step[Axis] > 0 ? 0 : 1));
+    }
+    return Hit;
+}
+
+//Hierarchical ray cast against the block by block walk, over level 0 fbm terrain next to a band of level 1 chunks
+static uint32_t RunRayCast(int32_t HalfExtent, const FVoxelSceneConfig& VoxelSceneConfig)
+{
+    const int32_t MipStart = (HalfExtent + 1) & ~1;
+    std::vector<ivec3> MipLocations;
+    for (int32_t X = MipStart; X < MipStart + 4; X += 2)
+    {
+        for (int32_t Y = -6; Y < 6; Y += 2)
+        {
+            for (int32_t Z = -MipStart; Z < MipStart; Z += 2)
+            {
+                MipLocations.push_back({ X, Y, Z });
+            }
+        }
+    }
+    FRayCastScene Scene;
+    Scene.Add(&FGeneratorHelper::GenerateFbmTerrainOccupancy<>, GetBenchmarkChunkLocations(HalfExtent, 6), 0, VoxelSceneConfig);
+    Scene.Add(&FGeneratorHelper::GenerateFbmTerrainOccupancy<>, MipLocations, 1, VoxelSceneConfig);
+
+    const float MaxDistance = 4.0f * VoxelSceneConfig.GetChunkSize();
+    const std::vector<FBenchmarkRay> Rays = GetBenchmarkRays(Scene, 1u << 14, VoxelSceneConfig);
+    uint32_t Mismatch = 0;
+    size_t HitNum = 0;
+    double RaySeconds = 0.0;
+    for (const FBenchmarkRay& Ray : Rays)
+    {
+        const auto Start = FBenchmarkClock::now();
+        const FRayCastHit Hit = RayCast([&Scene](ivec3 ChunkLocation) { return Scene.Find(ChunkLocation); }, Ray.OriginChunk, Ray.LocalOrigin, Ray.Direction, MaxDistance, VoxelSceneConfig.BlockSize);
+        RaySeconds += std::chrono::duration<double>(FBenchmarkClock::now() - Start).count();
+        const FRayCastHit Reference = ReferenceRayCast(Scene, Ray, MaxDistance, VoxelSceneConfig.BlockSize);
+        HitNum += Hit.bHit ? 1 : 0;
+        const bool bSame = Hit.bHit == Reference.bHit && (!Hit.bHit || (Hit.ChunkLocation == Reference.ChunkLocation && Hit.MipmapLevel == Reference.MipmapLevel
+            && Hit.BlockLocation == Reference.BlockLocation && Hit.Face == Reference.Face && std::abs(Hit.Distance - Reference.Distance) < 1e-3f * VoxelSceneConfig.BlockSize));
+        Mismatch += bSame ? 0 : 1;
+    }
+    printf("%-34s %.2lf Mrays/s, %.1lf%% of %zu rays hit, %u mismatched\n", "Ray cast (fbm terrain, 2 levels)",
+        Rays.size() / std::max(RaySeconds, 1e-9) * 1e-6, HitNum * 100.0 / Rays.size(), Rays.size(), Mismatch);
+    return Mismatch;
+}
+
+//Earliest contact over every solid block in the swept bounds, slab test of the box against each block
+static FSweepHit ReferenceSweepBox(const FRayCastScene& Scene, const FBoxSweep& Sweep, float BlockSize, bool& bNormalTied)
+{
+    constexpr int64_t Resolution = FChunkOccupancyVolume::Resolution;
+    double Lower[3], Upper[3], Delta[3];
+    int64_t Min[3], Max[3];
+    for (int32_t Axis = 0; Axis < 3; Axis++)
+    {
+        Lower[Axis] = (double)Sweep.OriginChunk[Axis] * Resolution + (double)Sweep.LocalMin[Axis] / BlockSize;
+        Upper[Axis] = (double)Sweep.OriginChunk[Axis] * Resolution + (double)Sweep.LocalMax[Axis] / BlockSize;
+        Delta[Axis] = (double)Sweep.Delta[Axis] / BlockSize;
+        Min[Axis] = (int64_t)std::floor(std::min(Lower[Axis], Lower[Axis] + Delta[Axis])) - 1;
+        Max[Axis] = (int64_t)std::ceil(std::max(Upper[Axis], Upper[Axis] + Delta[Axis]));
+    }
+    FSweepHit Hit;
+    double HitTime = 2.0;
+    bNormalTied = false;
+    FRayCastHit Unused;
+    int64_t Block[3];
+    for (Block[2] = Min[2]; Block[2] <= Max[2]; Block[2]++)
+    {
+        for (Block[1] = Min[1]; Block[1] <= Max[1]; Block[1]++)
+        {
+            for (Block[0] = Min[0]; Block[0] <= Max[0]; Block[0]++)
+            {
+                if (!Scene.bIsSolid(Block, Unused))
+                {
+                    continue;
+                }
+                double Enter = -INFINITY, Exit = INFINITY, SecondEnter = -INFINITY;
+                int32_t EnterAxis = -1;
+                for (int32_t Axis = 0; Axis < 3; Axis++)
+                {
+                    double AxisEnter = -INFINITY, AxisExit = INFINITY;
+                    if (Delta[Axis] == 0.0)
+                    {
+                        if (!(Lower[Axis] < Block[Axis] + 1 && Upper[Axis] > Block[Axis]))
+                        {
+                            AxisEnter = INFINITY;
+                        }
+                    }
+                    else
+                    {
+                        const double A = ((double)Block[Axis] - Upper[Axis]) / Delta[Axis];
+                        const double B = ((double)Block[Axis] + 1 - Lower[Axis]) / Delta[Axis];
+                        AxisEnter = std::min(A, B);
+                        AxisExit = std::max(A, B);
+                    }
+                    if (AxisEnter > Enter)
+                    {
+                        SecondEnter = Enter;
+                        Enter = AxisEnter;
+                        EnterAxis = Axis;
+                    }
+                    else
+                    {
+                        SecondEnter = std::max(SecondEnter, AxisEnter);
+                    }
+                    Exit = std::min(Exit, AxisExit);
+                }
+                if (!(Enter < Exit) || Exit <= 0.0 || Enter > 1.0)
+                {
+                    continue;
+                }
+                if (Enter < 0.0)
+                {
+                    Hit = { .bHit = true, .bStartSolid = true, .Time = 0.0f };
+                    return Hit;
+                }
+                if (Enter < HitTime)
+                {
+                    HitTime = Enter;
+                    Hit = { .bHit = true, .Time = (float)Enter };
+                    Hit.Normal[EnterAxis] = Delta[EnterAxis] > 0.0 ? -1 : 1;
+                    bNormalTied = Enter - SecondEnter < 1e-9;
+                }
+                else if (Enter == HitTime)
+                {
+                    bNormalTied = true;
+                }
+            }
+        }
+    }
+    return Hit;
+}
+
+//Word scanned box sweeps against the slab test reference, on the ray cast scene with character sized and bigger boxes crossing chunks
+static uint32_t RunSweep(int32_t HalfExtent, const FVoxelSceneConfig& VoxelSceneConfig)
+{
+    FRayCastScene Scene;
+    Scene.Add(&FGeneratorHelper::GenerateFbmTerrainOccupancy<>, GetBenchmarkChunkLocations(HalfExtent, 6), 0, VoxelSceneConfig);
+    Scene.Add(&FGeneratorHelper::GenerateFbmTerrainOccupancy<>, { { (HalfExtent + 1) & ~1, 0, 0 } }, 1, VoxelSceneConfig);
+
+    //Agents mostly start in the air, a few start inside the ground
+    const std::vector<FBenchmarkRay> Rays = GetBenchmarkRays(Scene, 1u << 13, VoxelSceneConfig);
+    std::vector<FBoxSweep> Sweeps;
+    for (size_t i = 0; i < Rays.size(); i++)
+    {
+        const vec3 Extent = (i & 3) == 0 ? vec3(2.5f) : vec3(0.6f, 1.8f, 0.6f);
+        const float Length = (float)(i % 7) * 0.25f * VoxelSceneConfig.GetChunkSize();
+        FBoxSweep Sweep = { .OriginChunk = Rays[i].OriginChunk, .LocalMin = Rays[i].LocalOrigin, .LocalMax = Rays[i].LocalOrigin + Extent * VoxelSceneConfig.BlockSize };
+        bool bNormalTied = false;
+        if (!ReferenceSweepBox(Scene, Sweep, VoxelSceneConfig.BlockSize, bNormalTied).bStartSolid || (i & 15) == 0)
+        {
+            Sweep.Delta = Rays[i].Direction * Length;
+            Sweep.Delta.y = (i & 1) ? -std::abs(Sweep.Delta.y) - Length : Sweep.Delta.y;//Half of them fall
+            Sweeps.push_back(Sweep);
+        }
+    }
+    uint32_t Mismatch = 0;
+    size_t HitNum = 0;
+    size_t StartSolidNum = 0;
+    std::vector<FSweepHit> Hits(Sweeps.size());
+    auto FindChunk = [&Scene](ivec3 ChunkLocation) { return Scene.Find(ChunkLocation); };
+    const auto Start = FBenchmarkClock::now();
+    FChunkLookupCache Cache;
+    for (size_t i = 0; i < Sweeps.size(); i++)
+    {
+        Hits[i] = SweepBox(FindChunk, Cache, Sweeps[i], VoxelSceneConfig.BlockSize);
+    }
+    const double Seconds = std::chrono::duration<double>(FBenchmarkClock::now() - Start).count();
+    for (size_t i = 0; i < Sweeps.size(); i++)
+    {
+        bool bNormalTied = false;
+        const FSweepHit Reference = ReferenceSweepBox(Scene, Sweeps[i], VoxelSceneConfig.BlockSize, bNormalTied);
+        const FSweepHit& Hit = Hits[i];
+        HitNum += Hit.bHit ? 1 : 0;
+        StartSolidNum += Hit.bStartSolid ? 1 : 0;
+        const bool bSame = Hit.bHit == Reference.bHit && Hit.bStartSolid == Reference.bStartSolid && std::abs(Hit.Time - Reference.Time) < 1e-4f
+            && (bNormalTied || Hit.Normal == Reference.Normal);
+        Mismatch += bSame ? 0 : 1;
+    }
+    printf("%-34s %.2lf us per 256 boxes, %.1lf%% of %zu sweeps hit (%.1lf%% start solid), %u mismatched\n", "Box sweep (fbm terrain)",
+        Seconds * 1e6 * 256.0 / Sweeps.size(), HitNum * 100.0 / Sweeps.size(), Sweeps.size(), StartSolidNum * 100.0 / Sweeps.size(), Mismatch);
+    return Mismatch;
+}
+
+//Rays are split over ThreadNum std::threads in batches through an atomic cursor, the scene is shared read only like the pool's chunk cache
+static void RunRayCastThroughput(const FRayCastScene& Scene, const std::vector<FBenchmarkRay>& Rays, uint32_t ThreadNum, const FVoxelSceneConfig& VoxelSceneConfig)
+{
+    constexpr size_t BatchSize = 256;
+    const float MaxDistance = 8.0f * VoxelSceneConfig.GetChunkSize();
+    std::atomic<size_t> Cursor = 0;
+    std::atomic<size_t> HitNum = 0;
+    auto Worker = [&]()
+        {
+            size_t LocalHitNum = 0;
+            for (size_t Begin = Cursor.fetch_add(BatchSize); Begin < Rays.size(); Begin = Cursor.fetch_add(BatchSize))
+            {
+                for (size_t i = Begin; i < std::min(Begin + BatchSize, Rays.size()); i++)
+                {
+                    LocalHitNum += RayCast([&Scene](ivec3 ChunkLocation) { return Scene.Find(ChunkLocation); },
+                        Rays[i].OriginChunk, Rays[i].LocalOrigin, Rays[i].Direction, MaxDistance, VoxelSceneConfig.BlockSize).bHit ? 1 : 0;
+                }
+            }
+            HitNum += LocalHitNum;
+        };
+    auto Start = FBenchmarkClock::now();
+    std::vector<std::thread> Threads;
+    for (uint32_t t = 1; t < ThreadNum; t++)
+    {
+        Threads.emplace_back(Worker);
+    }
+    Worker();
+    for (std::thread& Thread : Threads)
+    {
+        Thread.join();
+    }
+    const double Seconds = std::max(std::chrono::duration<double>(FBenchmarkClock::now() - Start).count(), 1e-9);
+    printf("%-22s %2u threads %10.2lf Mrays/s, %5.1lf%% hit\n", "RayCast", ThreadNum, Rays.size() / Seconds * 1e-6, HitNum * 100.0 / std::max<size_t>(Rays.size(), 1));
+}
+
+//Mixed batches (rays, falling boxes, overlaps) through the query service on ThreadNum threads, checked against running every query alone
+static uint32_t RunQueryService(const FRayCastScene& Scene, const std::vector<FBenchmarkRay>& Rays, uint32_t ThreadNum, const FVoxelSceneConfig& VoxelSceneConfig)
+{
+    constexpr size_t BatchSize = 4096;
+    std::vector<FVoxelQuery> Queries(Rays.size());
+    for (size_t i = 0; i < Rays.size(); i++)
+    {
+        const FBenchmarkRay& Ray = Rays[i];
+        FVoxelQuery& Query = Queries[i];
+        Query.Type = (EVoxelQueryType)(i % 3);
+        Query.OriginChunk = Ray.OriginChunk;
+        Query.LocalOrigin = Ray.LocalOrigin;
+        Query.LocalMax = Ray.LocalOrigin + vec3(0.6f, 1.8f, 0.6f) * VoxelSceneConfig.BlockSize;
+        Query.Direction = Query.Type == EVoxelQueryType::RayCast ? Ray.Direction : vec3(0.0f, -0.5f, 0.0f) * VoxelSceneConfig.GetChunkSize() + Ray.Direction;
+        Query.MaxDistance = 8.0f * VoxelSceneConfig.GetChunkSize();
+    }
+    auto FindChunk = [&Scene](ivec3 ChunkLocation) { return Scene.Find(ChunkLocation); };
+    ThreadPool Pool;
+    Pool.Initialize(ThreadNum);
+    FVoxelQueryService Service;
+    std::vector<FVoxelQueryResult> Results(Queries.size());
+    for (size_t Begin = 0; Begin < Queries.size(); Begin += BatchSize)
+    {
+        const size_t Num = std::min(BatchSize, Queries.size() - Begin);
+        Service.Run(FindChunk, std::span<const FVoxelQuery>(Queries.data() + Begin, Num), std::span<FVoxelQueryResult>(Results.data() + Begin, Num), VoxelSceneConfig.BlockSize, &Pool);
+    }
+    uint32_t Mismatch = 0;
+    FChunkLookupCache Cache;
+    for (size_t i = 0; i < Queries.size(); i += 7)
+    {
+        const FVoxelQueryResult Reference = FVoxelQueryService::RunQuery(FindChunk, Cache, Queries[i], VoxelSceneConfig.BlockSize);
+        const FRayCastHit& A = Results[i].RayHit;
+        const FRayCastHit& B = Reference.RayHit;
+        const bool bSameRay = A.bHit == B.bHit && A.ChunkLocation == B.ChunkLocation && A.BlockLocation == B.BlockLocation && A.Face == B.Face && A.Distance == B.Distance;
+        const bool bSameSweep = Results[i].SweepHit.bHit == Reference.SweepHit.bHit && Results[i].SweepHit.bStartSolid == Reference.SweepHit.bStartSolid
+            && Results[i].SweepHit.Time == Reference.SweepHit.Time && Results[i].SweepHit.Normal == Reference.SweepHit.Normal;
+        Mismatch += bSameRay && bSameSweep ? 0 : 1;
+    }
+    const FVoxelQueryService::FStats& Stats = Service.GetStats();
+    //Borrowing from a pool shared with the generators, at most MaxPoolTaskNum of its slots are taken. The borrowed tasks wait at a gate
+    //until the calling thread has filled every slot left with probes, what didn't fit was taken by the batch
+    constexpr size_t MaxPoolTaskNum = 1;
+    std::atomic<bool> bProbeRelease = false;
+    std::atomic<bool> bGateOpen = false;
+    ThreadPool SharedPool;
+    SharedPool.Initialize(4);
+    const std::thread::id CallerId = std::this_thread::get_id();
+    size_t BorrowedNum = SIZE_MAX;
+    auto GatedFindChunk = [&](ivec3 ChunkLocation)
+        {
+            if (std::this_thread::get_id() != CallerId)
+            {
+                bGateOpen.wait(false);
+            }
+            else if (!bGateOpen.load())
+            {
+                size_t FreeNum = 0;
+                while (SharedPool.EnqueueForward([&bProbeRelease]() { bProbeRelease.wait(false); }))
+                {
+                    FreeNum++;
+                }
+                bProbeRelease = true;
+                bProbeRelease.notify_all();
+                BorrowedNum = SharedPool.GetSize() - FreeNum;
+                bGateOpen = true;
+                bGateOpen.notify_all();
+            }
+            return Scene.Find(ChunkLocation);
+        };
+    FVoxelQueryService CappedService;
+    const size_t CappedNum = std::min(BatchSize, Queries.size());
+    std::vector<FVoxelQueryResult> CappedResults(CappedNum);
+    CappedService.Run(GatedFindChunk, std::span<const FVoxelQuery>(Queries.data(), CappedNum), std::span<FVoxelQueryResult>(CappedResults), VoxelSceneConfig.BlockSize, &SharedPool, MaxPoolTaskNum);
+    SharedPool.WaitForTasksToComplete();
+    Mismatch += BorrowedNum == MaxPoolTaskNum ? 0 : 1;
+    for (size_t i = 0; i < CappedNum; i++)
+    {
+        Mismatch += CappedResults[i].RayHit.bHit == Results[i].RayHit.bHit && CappedResults[i].RayHit.Distance == Results[i].RayHit.Distance
+            && CappedResults[i].SweepHit.bHit == Results[i].SweepHit.bHit && CappedResults[i].SweepHit.Time == Results[i].SweepHit.Time ? 0 : 1;
+    }
+    printf("%-22s %2u threads %10.2lf Mqueries/s, %.3lf ms per %zu query batch (max %.3lf ms), %zu of %u shared threads borrowed, %u mismatched\n", "QueryService", ThreadNum,
+        Stats.GetQueriesPerSecond() * 1e-6, Stats.Seconds * 1000.0 / std::max<uint64_t>(Stats.BatchNum, 1), BatchSize, Stats.MaxBatchSeconds * 1000.0, BorrowedNum, SharedPool.GetSize(), Mismatch);
+    return Mismatch;
+}
+
+/*
+Rays through FChunkPoolCore::FindRayChunk on ThreadNum std::threads, alone and while another thread keeps pushing chunks away from the rays,
+so the lookups share the resident cache and brick locks with a writer. Every pass has to match a single threaded one without the writer
+*/
+static uint32_t RunPoolRayCast(const std::vector<ivec3>& Locations, const std::vector<FBenchmarkRay>& Rays, const std::vector<uint32_t>& ThreadNums, const FVoxelSceneConfig& VoxelSceneConfig)
+{
+    constexpr uint32_t MaxMipmapLevel = 2;
+    constexpr uint32_t WriterChunkNum = 64;
+    constexpr size_t BatchSize = 256;
+    const size_t RayNum = std::min<size_t>(Rays.size(), 1u << 16);
+    const float MaxDistance = 8.0f * VoxelSceneConfig.GetChunkSize();
+    FVoxelSceneConfig PoolSceneConfig = VoxelSceneConfig;
+    PoolSceneConfig.MaxChunkCount = 2 * std::max((uint32_t)Locations.size(), WriterChunkNum);//Thread 0 holds the scene, thread 1 the writer's chunks
+    PoolSceneConfig.MaxEmptyChunkCount = 2;
+    PoolSceneConfig.MaxBlockCount = 1u << 20;
+    const FImportanceComputeInfo CameraInfo = { .CameraForwardVector = { 0.0f, 0.0f, 1.0f }, .MaxChunkMipmapLevel = MaxMipmapLevel };
+    FChunkPoolCore Pool;
+    Pool.InitializePools(PoolSceneConfig, 2);
+    auto Push = [&](FChunk&& Chunk, const uint32_t ThreadId)
+        {
+            EChunkState State;
+            if (Chunk.Blocks.empty() || !Pool.ChunksLookupTable.ATOMIC_not_contains_insert(Chunk.GetChunkKey(), EChunkState::Computing, State))
+            {
+                return;
+            }
+            Pool.IncreaseFrameStamp();
+            Pool.PushChunk(std::move(Chunk), ThreadId, Pool.GetFrameStamp(), VoxelSceneConfig.ChunkResolution, CameraInfo, VoxelSceneConfig.GetChunkSize(), EChunkOverrideMode::OverrideMin);
+        };
+    std::vector<FChunk> WriterChunks;
+    for (const ivec3& Location : Locations)
+    {
+        FChunk Chunk = GenerateLevelChunk(Location, 0, VoxelSceneConfig);
+        if (WriterChunks.size() < WriterChunkNum && !Chunk.Blocks.empty())
+        {
+            WriterChunks.push_back(Chunk);
+        }
+        Push(std::move(Chunk), 0);
+    }
+    Pool.GatherDebugInstanceInfo(PoolSceneConfig);
+
+    auto CastAll = [&](const uint32_t ThreadNum, std::vector<FRayCastHit>& Hits)
+        {
+            std::atomic<size_t> Cursor = 0;
+            auto Worker = [&]()
+                {
+                    for (size_t Begin = Cursor.fetch_add(BatchSize); Begin < RayNum; Begin = Cursor.fetch_add(BatchSize))
+                    {
+                        for (size_t i = Begin; i < std::min(Begin + BatchSize, RayNum); i++)
+                        {
+                            Hits[i] = RayCast([&Pool](ivec3 ChunkLocation) { return Pool.FindRayChunk(ChunkLocation, MaxMipmapLevel); },
+                                Rays[i].OriginChunk, Rays[i].LocalOrigin, Rays[i].Direction, MaxDistance, VoxelSceneConfig.BlockSize);
+                        }
+                    }
+                };
+            auto Start = FBenchmarkClock::now();
+            std::vector<std::thread> Threads;
+            for (uint32_t t = 1; t < ThreadNum; t++)
+            {
+                Threads.emplace_back(Worker);
+            }
+            Worker();
+            for (std::thread& Thread : Threads)
+            {
+                Thread.join();
+            }
+            return std::max(std::chrono::duration<double>(FBenchmarkClock::now() - Start).count(), 1e-9);
+        };
+    std::vector<FRayCastHit> Reference(RayNum), Hits(RayNum);
+    CastAll(1, Reference);
+    auto CountMismatchedHits = [&]()
+        {
+            uint32_t Mismatch = 0;
+            for (size_t i = 0; i < RayNum; i++)
+            {
+                const FRayCastHit& A = Hits[i];
+                const FRayCastHit& B = Reference[i];
+                Mismatch += A.bHit == B.bHit && A.ChunkLocation == B.ChunkLocation && A.BlockLocation == B.BlockLocation && A.Face == B.Face && A.Distance == B.Distance ? 0 : 1;
+            }
+            return Mismatch;
+        };
+    uint32_t Mismatch = 0;
+    for (const uint32_t ThreadNum : ThreadNums)
+    {
+        const double AloneSeconds = CastAll(ThreadNum, Hits);
+        Mismatch += CountMismatchedHits();
+        //The writer's chunks are far from the rays and only replace each other in thread 1's pool
+        std::atomic<bool> bWriting = true;
+        uint32_t WriterPushNum = 0;
+        std::thread Writer([&]()
+            {
+                while (bWriting.load(std::memory_order_relaxed))
+                {
+                    FChunk Chunk = WriterChunks[WriterPushNum % WriterChunks.size()];
+                    Chunk.ChunkLocation = { 1 << 16, 0, (int32_t)WriterPushNum };
+                    Push(std::move(Chunk), 1);
+                    if (++WriterPushNum % 8 == 0)
+                    {
+                        Pool.GatherDebugInstanceInfo(PoolSceneConfig);
+                    }
+                }
+            });
+        const double WritingSeconds = CastAll(ThreadNum, Hits);
+        bWriting = false;
+        Writer.join();
+        Mismatch += CountMismatchedHits();
+        printf("%-22s %2u threads %10.2lf Mrays/s, %.2lf Mrays/s with %u pushes alongside, %u mismatched\n", "RayCast (chunk pool)", ThreadNum,
+            RayNum / AloneSeconds * 1e-6, RayNum / WritingSeconds * 1e-6, WriterPushNum, Mismatch);
+    }
+    return Mismatch;
+}
+
+
+/*
+MesoSpatialBench [options]
+    --extent N          scene chunks in [-N, N) on x/z (default 4)
+    --height N          scene chunks in [-N, N) on y (default 2)
+    --threads 1,4,8     thread counts of the throughput and query runs (default 1 and all cores)
+Ray casts and sweeps against their references, then ray cast throughput, the query service and rays through the chunk pool.
+Exit code is non zero on any mismatch
+*/
+int main(int argc, char* argv[])
+{
+    FVoxelSceneConfig VoxelSceneConfig;
+    FBenchOptions Options;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!ParseBenchOption(argc, argv, i, Options))
+        {
+            printf("Unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+    FinishBenchOptions(Options);
+
+    uint32_t Mismatch = 0;
+    Mismatch += RunRayCast(Options.HalfExtent / 2 + 1, VoxelSceneConfig);
+    Mismatch += RunSweep(Options.HalfExtent / 2 + 1, VoxelSceneConfig);
+    const std::vector<ivec3> Locations = GetBenchmarkChunkLocations(Options.HalfExtent, Options.HalfHeight);
+    printf("Throughput: %zu chunks of %d^3\n", Locations.size(), VoxelSceneConfig.ChunkResolution);
+    FRayCastScene RayCastScene;
+    RayCastScene.Add(&FGeneratorHelper::GenerateFbmTerrainOccupancy<>, Locations, 0, VoxelSceneConfig);
+    const std::vector<FBenchmarkRay> Rays = GetBenchmarkRays(RayCastScene, 1u << 20, VoxelSceneConfig);
+    for (uint32_t ThreadNum : Options.ThreadNums)
+    {
+        RunRayCastThroughput(RayCastScene, Rays, ThreadNum, VoxelSceneConfig);
+    }
+    for (uint32_t ThreadNum : Options.ThreadNums)
+    {
+        Mismatch += RunQueryService(RayCastScene, Rays, ThreadNum, VoxelSceneConfig);
+    }
+    Mismatch += RunPoolRayCast(Locations, Rays, Options.ThreadNums, VoxelSceneConfig);
+    printf("Mismatched: %u\n", Mismatch);
+    return Mismatch == 0 ? 0 : 1;
+}
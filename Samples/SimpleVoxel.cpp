@@ -146,12 +146,14 @@ vec3 GetOctantColor(vec3 v)
 void main() 
 {
     ivec3 InstanceChunkLocation = ivec3(INT_MAX, INT_MAX, INT_MAX);
+    uint InstanceMipmapLevel = 0;
     if(InstanceChunkIndex != INT_MAX) // Valid  // && InstanceChunkIndex < CHUNK_ARRAY_SIZE
     {
         GPUChunk CachedChunk = pc.Chunks.ChunkData[InstanceChunkIndex];
         if(CachedChunk.ChunkFrameStamp == InstanceBlockFrameStamp) //Valid
         {
             InstanceChunkLocation = CachedChunk.ChunkLocation;
+            InstanceMipmapLevel = CachedChunk.MipmapLevel;
         }
         else
         {
@@ -165,7 +167,8 @@ void main()
         return;
     }
     ivec3 ChunkOffset = InstanceChunkLocation - pc.Camera.CameraChunkLocation.xyz;
-    ivec3 SubOffset = ReverseUnpackU8Vec3(InstanceBlockLocation);
+    ivec3 SubOffset = ReverseUnpackU8Vec3(InstanceBlockLocation) << InstanceMipmapLevel; //In level 0 blocks
+    float LevelBlockSize = pc.Scene.BlockSize * float(1u << InstanceMipmapLevel);
 /*
     ivec3 InstanceChunkLocation = ivec3(0, 0, 0);
     ivec3 ChunkOffset = InstanceChunkLocation - pc.Camera.CameraChunkLocation.xyz;
@@ -182,9 +185,16 @@ void main()
 //
     vec3 RealViewRelativeBlockOffset = RealViewChunkRelativeBlockOffset - CameraPosition;
     int OctantId = GetOctantId(RealViewRelativeBlockOffset);
+    uint FaceMask = (InstanceBlockLocation >> 24) & 0x3F; //Exposed faces, bit f for -X, +X, -Y, +Y, -Z, +Z
+    uint FacingMask = ((OctantId & 1) != 0 ? 2u : 1u) | ((OctantId & 2) != 0 ? 8u : 4u) | ((OctantId & 4) != 0 ? 32u : 16u); //Faces the imposter shows
+    if((FaceMask & FacingMask) == 0u) //Every face towards the camera is covered
+    {
+        gl_Position = vec4(0.0, 0.0, -1.0, 1.0);
+        return;
+    }
     vec3 ImposterVertexPosition = TriplanarPositions[gl_VertexIndex + OctantId * 7];
 //    
-    vec3 RealVertexPosition = (ImposterVertexPosition + 0.5) * pc.Scene.BlockSize + RealViewChunkRelativeBlockOffset;
+    vec3 RealVertexPosition = (ImposterVertexPosition + 0.5) * LevelBlockSize + RealViewChunkRelativeBlockOffset;
 //    
     gl_Position = Projection * View * vec4(RealVertexPosition, 1.0); //TODO: If Camera Location is inside a cube, move cube surface backward in clip space(for reduce z fighting)
     vtx.Normal = ImposterVertexPosition;
@@ -262,9 +272,11 @@ public:
 
         auto GeneratorInstance = [](ivec3 StartLocation, float BlockSize, unsigned char ChunkResolution, uint32_t MipmapLevel)
             {
-                return FGeneratorHelper::GenerateSphere(StartLocation, BlockSize, ChunkResolution, MipmapLevel);
+                return FGeneratorHelper::GenerateSphereLipschitz(StartLocation, BlockSize, ChunkResolution, MipmapLevel);
             };
         ChunkManager.Initialize(LVKContext.get(), ThreadCount, VoxelSceneConfig, GeneratorInstance, bLVKReverseZ, LVKNumBufferedFrames);
+        ChunkManager.SetRegionClassifier(&FGeneratorHelper::ClassifySphere);
+        ChunkManager.SetOccupancyGenerator(&FGeneratorHelper::GenerateSphereOccupancy);
     }
     void WhenCameraChunkUpdate() override
     {